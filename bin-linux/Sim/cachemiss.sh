@@ -0,0 +1,41 @@
+#!/bin/bash
+
+# Cache-miss comparison of the Hilbert-curve population layout against file order.
+#
+# Usage: cachemiss.sh <in_path> <steps> [threads]
+#
+#   in_path  - folder containing params.bin etc, for a single node
+#   steps    - number of timesteps to run (/steps:)
+#   threads  - /ompmax: value (default 1)
+#
+# Runs the simulator twice under "perf stat", once as normal and once with /noreorder, with the same seed.
+# Counters cover the whole run including loading, so use enough steps for the timestep loop to dominate;
+# /timing shows how much of the run that was. Raw output goes in cachemiss_reordered.txt and cachemiss_file_order.txt.
+# Set PERF_EVENTS to count something else.
+
+if [ $# -lt 2 ]; then
+  echo "Usage: cachemiss.sh <in_path> <steps> [threads]"
+  exit 1
+fi
+
+IN_PATH=$1
+STEPS=$2
+THREADS=${3:-1}
+SIM=${SIM:-$(dirname $0)/sim}
+EVENTS=${PERF_EVENTS:-"cache-references,cache-misses,L1-dcache-loads,L1-dcache-load-misses,LLC-load-misses,dTLB-load-misses"}
+
+export OMP_NUM_THREADS=$THREADS
+for MODE in reordered file_order; do
+  if [ "$MODE" == "file_order" ]; then OPT=/noreorder; else OPT=""; fi
+  echo "Running $MODE"
+  perf stat -e $EVENTS -o cachemiss_$MODE.txt $SIM /in:$IN_PATH /ompmax:$THREADS /steps:$STEPS /seed:1 /timing $OPT > cachemiss_${MODE}_log.txt 2>&1
+  if [ $? -ne 0 ]; then echo "  Run failed - see cachemiss_${MODE}_log.txt"; exit 1; fi
+done
+
+echo "# event reordered file_order ratio"
+awk '
+  FNR==1 { f++ }
+  $1 ~ /^[0-9,]+$/ && NF>=2 { gsub(",","",$1); v[f,$2]=$1; if (f==1) names[++n]=$2; }
+  END { for (i=1; i<=n; i++) { e=names[i]; printf "%s %s %s %.3f\n", e, v[1,e], v[2,e], (v[2,e]>0)?v[1,e]/v[2,e]:0; } }
+' cachemiss_reordered.txt cachemiss_file_order.txt
+grep -h "^TIMING_HEAD\|^TIMING_RANK" cachemiss_reordered_log.txt cachemiss_file_order_log.txt
@@ -0,0 +1,63 @@
+#!/bin/bash
+
+# Statistical-equivalence check of a candidate simulator against a baseline.
+#
+# Usage: equivalence.sh <baseline sim> <candidate sim> <in_path> <runs> [ranks] [threads] [alpha]
+#
+#   in_path  - a small input set (params.bin etc). It is not changed.
+#   runs     - number of seeds per simulator. 50+ gives the tests reasonable power.
+#   ranks    - MPI ranks (default 1). Must match the decomposition in in_path.
+#   threads  - /ompmax: value (default 1)
+#   alpha    - family-wise significance level (default 0.05)
+#
+# Baseline runs use seeds 1..runs, candidate runs use 100001..100000+runs, so the two samples are independent.
+# The seeds and the flat file go through the parameter file, not command-line options, so that a baseline that
+# predates /seed: and /ffout: is seeded and collected the same way: for each run, statequiv /params writes a copy
+# of params.bin into equivalence_runs/{baseline,candidate}/in, next to links to the rest of in_path, with that run's
+# seeds, the flat file on and named run_<i>, and database and movie output off. Flat files go in
+# equivalence_runs/{baseline,candidate}/run_<i>.txt, and bin-linux/StatEquiv/statequiv writes the report to
+# equivalence_report.txt. Exit code 0 = PASS, 1 = FAIL, 2 = error.
+
+if [ $# -lt 4 ]; then
+  echo "Usage: equivalence.sh <baseline sim> <candidate sim> <in_path> <runs> [ranks] [threads] [alpha]"
+  exit 2
+fi
+
+BASELINE=$1
+CANDIDATE=$2
+IN_PATH=$3
+RUNS=$4
+RANKS=${5:-1}
+THREADS=${6:-1}
+ALPHA=${7:-0.05}
+MPIRUN=${MPIRUN:-"mpirun --oversubscribe"}
+STATEQUIV=${STATEQUIV:-$(dirname $0)/../StatEquiv/statequiv}
+OUT=equivalence_runs
+
+IN_PATH=$(cd $IN_PATH && pwd)
+for SIDE in baseline candidate; do
+  mkdir -p $OUT/$SIDE/in
+  for f in $IN_PATH/*; do
+    if [ "$(basename $f)" != "params.bin" ]; then ln -sf $f $OUT/$SIDE/in/; fi
+  done
+done
+OUT=$(cd $OUT && pwd)
+export OMP_NUM_THREADS=$THREADS
+
+run() {   # run <baseline|candidate> <sim> <run no> <seed>
+  $STATEQUIV /params $IN_PATH/params.bin $OUT/$1/in/params.bin $4 $(($4+7919)) $OUT/$1 run_$3 > $OUT/$1/log_$3.txt 2>&1
+  if [ $? -ne 0 ]; then echo "Couldn't make the parameter file for $1 run $3 - see $OUT/$1/log_$3.txt"; exit 2; fi
+  $MPIRUN -np $RANKS $2 /in:$OUT/$1/in /ompmax:$THREADS >> $OUT/$1/log_$3.txt 2>&1
+  if [ $? -ne 0 ]; then echo "$1 run $3 failed - see $OUT/$1/log_$3.txt"; exit 2; fi
+}
+
+for i in $(seq 1 $RUNS); do
+  echo "Run $i of $RUNS"
+  run baseline $BASELINE $i $i
+  run candidate $CANDIDATE $i $((100000+i))
+done
+
+$STATEQUIV $OUT/baseline $OUT/candidate $RUNS /alpha:$ALPHA > equivalence_report.txt
+RESULT=$?
+cat equivalence_report.txt
+exit $RESULT
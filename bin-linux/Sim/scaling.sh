@@ -0,0 +1,93 @@
+#!/bin/bash
+
+# Strong/weak scaling driver for the simulator.
+#
+# Usage: scaling.sh <in_path> <steps> "<rank counts>" "<thread counts>" [strong|weak] [report file]
+#
+#   in_path      - folder containing params.bin etc. The patch decomposition (config_<rank>.lsi) is made for a
+#                  fixed number of nodes, so if the path contains %R it is replaced by the rank count, for
+#                  example ../../data/Runs/world%R  ->  ../../data/Runs/world3, ../../data/Runs/world9
+#   steps        - number of timesteps to run (/steps:) for every configuration
+#   rank counts  - list of MPI rank counts, eg "1 3 9"
+#   thread counts - list of /ompmax: values, eg "1 2 4 8"
+#   strong|weak  - efficiency is T(base)*cores(base)/(T*cores) for strong scaling, or rate/rate(base) for weak
+#                  scaling, where base is the first configuration run. Default strong.
+#   report file  - default scaling_report.txt. Raw output of each run is kept in scaling_logs/
+#
+# Runs locally with "mpirun --oversubscribe", so more ranks*threads than cores is allowed (though efficiency
+# then means little). Set MPIRUN to override, eg MPIRUN="mpirun -hostfile hosts".
+
+if [ $# -lt 4 ]; then
+  echo "Usage: scaling.sh <in_path> <steps> \"<rank counts>\" \"<thread counts>\" [strong|weak] [report file]"
+  exit 1
+fi
+
+IN_PATH=$1
+STEPS=$2
+RANKS=$3
+THREADS=$4
+MODE=${5:-strong}
+REPORT=${6:-scaling_report.txt}
+MPIRUN=${MPIRUN:-"mpirun --oversubscribe"}
+SIM=${SIM:-$(dirname $0)/sim}
+LOGS=scaling_logs
+
+mkdir -p $LOGS
+echo "# Scaling report: $MODE, $STEPS steps, input $IN_PATH" > $REPORT
+echo "# ranks threads cores steps wall_s steps_per_s efficiency comm_frac max_compute_s mean_compute_s mem_mb_per_rank max_mem_mb" >> $REPORT
+
+BASE_WALL=""
+BASE_CORES=""
+BASE_RATE=""
+
+for R in $RANKS; do
+  for TH in $THREADS; do
+    IN=${IN_PATH//%R/$R}
+    LOG=$LOGS/run_r${R}_t${TH}.txt
+    echo "Running $R ranks x $TH threads"
+    export OMP_NUM_THREADS=$TH
+    $MPIRUN -np $R $SIM /in:$IN /ompmax:$TH /steps:$STEPS /timing > $LOG 2>&1
+    if ! grep -q "^TIMING_RANK" $LOG; then
+      echo "  Run failed - see $LOG"
+      echo "$R $TH $((R*TH)) FAILED" >> $REPORT
+      continue
+    fi
+
+    # Wall time is the slowest rank's loop time. Communication fraction is the mean over ranks of time in doMessage
+    # (which includes waiting for slower nodes) over loop time. Compute = everything except doMessage.
+
+    LINE=$(awk -v R=$R -v TH=$TH '
+      /^TIMING_HEAD/ { for (i=2; i<=NF; i++) col[$i]=i; }
+      /^TIMING / { split($4,a,"="); steps=a[2]; }
+      /^TIMING_RANK/ {
+        n++;
+        total=$(col["total"]); msg=$(col["message"]); mem=$(col["mem_kb"])/1024.0;
+        if (total>wall) wall=total;
+        if (total>0) comm+=msg/total;
+        compute=total-msg;
+        if (compute>max_c) max_c=compute;
+        sum_c+=compute; sum_mem+=mem;
+        if (mem>max_mem) max_mem=mem;
+      }
+      END {
+        rate=(wall>0)?steps/wall:0;
+        printf "%d %.3f %.3f %.4f %.3f %.3f %.1f %.1f\n", steps, wall, rate, comm/n, max_c, sum_c/n, sum_mem/n, max_mem;
+      }' $LOG)
+
+    set -- $LINE
+    S=$1; WALL=$2; RATE=$3; COMM=$4; MAXC=$5; MEANC=$6; MEM=$7; MAXMEM=$8
+    CORES=$((R*TH))
+    if [ -z "$BASE_WALL" ]; then
+      BASE_WALL=$WALL; BASE_CORES=$CORES; BASE_RATE=$RATE
+    fi
+    if [ "$MODE" == "weak" ]; then
+      EFF=$(awk -v r=$RATE -v b=$BASE_RATE 'BEGIN { printf "%.3f", (b>0)?r/b:0 }')
+    else
+      EFF=$(awk -v w=$WALL -v c=$CORES -v bw=$BASE_WALL -v bc=$BASE_CORES 'BEGIN { printf "%.3f", (w*c>0)?(bw*bc)/(w*c):0 }')
+    fi
+    echo "$R $TH $CORES $S $WALL $RATE $EFF $COMM $MAXC $MEANC $MEM $MAXMEM" >> $REPORT
+  done
+done
+
+echo "# Per-phase, per-rank seconds for each run are in $LOGS/" >> $REPORT
+cat $REPORT
@@ -1,9 +1,15 @@
 chmod 755 ./src/compile_all.sh
 chmod 755 ./src/CombineSynthPopul/*.sh
+chmod 755 ./src/CommReplay/*.sh
+chmod 755 ./src/DBBench/*.sh
+chmod 755 ./src/EventLog/*.sh
+chmod 755 ./src/FlatBin/*.sh
 chmod 755 ./src/GetAdminUnits/*.sh
 chmod 755 ./src/JobCreator/*.sh
 chmod 755 ./src/MashAdminUnits/*.sh
+chmod 755 ./src/MovieConv/*.sh
 chmod 755 ./src/PatchFileMaker/*.sh
+chmod 755 ./src/StatEquiv/*.sh
 chmod 755 ./src/Sim/*.sh
 chmod 755 ./src/SynthPopul/*.sh
 chmod 755 ./bin-linux/CombineSynthPopul/combine
@@ -11,6 +17,7 @@ chmod 755 ./bin-linux/GetAdminUnits/get_admin_units.sh
 chmod 755 ./bin-linux/MashAdminUnits/mashadmin
 chmod 755 ./bin-linux/PatchFileMaker/makePatches.sh
 chmod 755 ./bin-linux/Sim/sim
+chmod 755 ./bin-linux/Sim/*.sh
 chmod 755 ./bin-linux/SynthPopul/SynthPopul
 chmod 755 ./bin-linux/SynthPopul/*.sh
 chmod 755 ./bin-linux/SynthPopul/scripts/Africa/Algeria/run__SynthPopul__Algeria.sh
@@ -0,0 +1,504 @@
+/* commreplay.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Standalone MPI benchmark replaying traffic recorded by the simulator (/traffic:)
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+
+#ifndef _WIN32
+  #define strnicmp strncasecmp
+#endif
+
+// Regenerates the exact per-timestep byte pattern that doMessage() produced in a real run, with synthetic payloads,
+// and times alternative ways of moving it. Must be run with the same number of ranks as the recording.
+//
+//   mpirun -np <ranks> commreplay <traffic file> [strategy] [/repeats:N] [/ppn:N] [/verify]
+//
+//   strategy:   all (default), alltoallv, nonblocking, neighbour, hierarchical
+//   /repeats:N  replay the whole recording N times (default 1)
+//   /ppn:N      for hierarchical, treat each block of N consecutive ranks as one node (default: group by processor name)
+//   /verify     check every received byte came from the right source, for the right step
+//
+// Every strategy first does the same MPI_Allreduce of the starter message (sizes, unit stats and status) that
+// the simulator does, and the movie MPI_Reduce if the run logged a movie. Only the bulk exchange differs.
+
+#define STRAT_ALLTOALLV 0
+#define STRAT_NONBLOCKING 1
+#define STRAT_NEIGHBOUR 2
+#define STRAT_HIERARCHICAL 3
+#define NO_STRATS 4
+
+const char* strat_names[NO_STRATS] = { "alltoallv", "nonblocking", "neighbour", "hierarchical" };
+
+int mpi_rank;
+int mpi_size;
+
+int no_steps;
+int starter_msg_size;
+int no_units;
+int image_bytes;
+int* step_T;             // [step] - simulation time of each recorded step
+int** bytes;             // [step][src*mpi_size+dest] - total bytes (requests+replies+place messages) sent from src to dest
+
+int* starter_out;
+int* starter_in;
+unsigned char* image_out;
+unsigned char* image_in;
+unsigned char* send_buf;
+unsigned char* recv_buf;
+int* counts_out;
+int* displs_out;
+int* counts_in;
+int* displs_in;
+MPI_Request* requests;
+
+// Hierarchical
+
+MPI_Comm node_comm;        // Ranks sharing a node
+MPI_Comm leader_comm;      // One rank per node (MPI_COMM_NULL elsewhere)
+int local_rank;
+int local_size;
+int no_nodes;
+int* node_of;              // [rank] - node index of each rank
+int** node_ranks;          // [node][i] - world ranks on each node, in order
+int* node_size;            // [node] - number of ranks on each node
+unsigned char* gather_buf;
+unsigned char* node_send_buf;
+unsigned char* node_recv_buf;
+int* local_counts;
+int* local_displs;
+int* node_counts_out;
+int* node_displs_out;
+int* node_counts_in;
+int* node_displs_in;
+
+#if MPI_VERSION>=3
+MPI_Comm graph_comm;       // Every pair that ever exchanged bytes in the recording
+int graph_in;
+int graph_out;
+int* graph_sources;
+int* graph_dests;
+int* graph_counts_out;
+int* graph_displs_out;
+int* graph_counts_in;
+int* graph_displs_in;
+#endif
+
+inline unsigned char pattern(int step, int src, int dest) {
+  return (unsigned char) ((step*131)+(src*31)+(dest*7));
+}
+
+int loadTraffic(char* file) {
+  FILE* f = fopen(file,"rb");
+  if (f==NULL) {
+    printf("%d: Couldn't open %s\n",mpi_rank,file);
+    return 1;
+  }
+  int rec_size;
+  fread(&rec_size,4,1,f);
+  fread(&starter_msg_size,4,1,f);
+  fread(&no_units,4,1,f);
+  fread(&image_bytes,4,1,f);
+  if (rec_size!=mpi_size) {
+    printf("%d: %s was recorded with %d ranks - run with mpirun -np %d\n",mpi_rank,file,rec_size,rec_size);
+    fclose(f);
+    return 1;
+  }
+  const int grid = mpi_size*mpi_size;
+  int step_ints = 1+(3*grid);
+  fseek(f,0,SEEK_END);
+  long file_size = ftell(f);
+  fseek(f,16,SEEK_SET);
+  no_steps = (int) ((file_size-16)/(4*step_ints));
+  step_T = new int[no_steps];
+  bytes = new int*[no_steps];
+  int* rec = new int[3*grid];
+  for (int s=0; s<no_steps; s++) {
+    fread(&step_T[s],4,1,f);
+    fread(rec,4,3*grid,f);
+    bytes[s] = new int[grid];
+    for (int src=0; src<mpi_size; src++) {
+      for (int dest=0; dest<mpi_size; dest++) {
+        int k=(dest*mpi_size)+src;                       // Starter message grids are indexed [dest][src]
+        bytes[s][(src*mpi_size)+dest]=rec[k]+rec[grid+k]+rec[(2*grid)+k];
+      }
+    }
+  }
+  delete[] rec;
+  fclose(f);
+  return 0;
+}
+
+void initNodes(int ppn) {
+  // Decide which ranks share a node - by processor name, or in blocks of ppn for testing on one machine.
+  node_of = new int[mpi_size];
+  if (ppn>0) {
+    for (int r=0; r<mpi_size; r++) node_of[r]=r/ppn;
+  } else {
+    char* names = new char[mpi_size*MPI_MAX_PROCESSOR_NAME];
+    char name[MPI_MAX_PROCESSOR_NAME];
+    int len;
+    memset(name,0,MPI_MAX_PROCESSOR_NAME);
+    MPI_Get_processor_name(name,&len);
+    MPI_Allgather(name,MPI_MAX_PROCESSOR_NAME,MPI_CHAR,names,MPI_MAX_PROCESSOR_NAME,MPI_CHAR,MPI_COMM_WORLD);
+    int next=0;
+    for (int r=0; r<mpi_size; r++) {
+      node_of[r]=-1;
+      for (int q=0; q<r; q++) {
+        if (strncmp(&names[r*MPI_MAX_PROCESSOR_NAME],&names[q*MPI_MAX_PROCESSOR_NAME],MPI_MAX_PROCESSOR_NAME)==0) {
+          node_of[r]=node_of[q];
+          q=r;
+        }
+      }
+      if (node_of[r]==-1) node_of[r]=next++;
+    }
+    delete[] names;
+  }
+  no_nodes=0;
+  for (int r=0; r<mpi_size; r++) if (node_of[r]+1>no_nodes) no_nodes=node_of[r]+1;
+  node_size = new int[no_nodes];
+  node_ranks = new int*[no_nodes];
+  for (int n=0; n<no_nodes; n++) node_size[n]=0;
+  for (int r=0; r<mpi_size; r++) node_size[node_of[r]]++;
+  for (int n=0; n<no_nodes; n++) {
+    node_ranks[n] = new int[node_size[n]];
+    node_size[n]=0;
+  }
+  for (int r=0; r<mpi_size; r++) node_ranks[node_of[r]][node_size[node_of[r]]++]=r;
+
+  MPI_Comm_split(MPI_COMM_WORLD,node_of[mpi_rank],mpi_rank,&node_comm);
+  MPI_Comm_rank(node_comm,&local_rank);
+  MPI_Comm_size(node_comm,&local_size);
+  MPI_Comm_split(MPI_COMM_WORLD,(local_rank==0)?0:MPI_UNDEFINED,node_of[mpi_rank],&leader_comm);
+  local_counts = new int[local_size];
+  local_displs = new int[local_size];
+  node_counts_out = new int[no_nodes];
+  node_displs_out = new int[no_nodes];
+  node_counts_in = new int[no_nodes];
+  node_displs_in = new int[no_nodes];
+}
+
+#if MPI_VERSION>=3
+void initGraph() {
+  // Neighbourhood = every rank this rank ever sends to / receives from, in any recorded step.
+  graph_in=0;
+  graph_out=0;
+  graph_sources = new int[mpi_size];
+  graph_dests = new int[mpi_size];
+  for (int r=0; r<mpi_size; r++) {
+    bool in=false;
+    bool out=false;
+    for (int s=0; s<no_steps; s++) {
+      if (bytes[s][(r*mpi_size)+mpi_rank]>0) in=true;
+      if (bytes[s][(mpi_rank*mpi_size)+r]>0) out=true;
+    }
+    if (in) graph_sources[graph_in++]=r;
+    if (out) graph_dests[graph_out++]=r;
+  }
+  MPI_Dist_graph_create_adjacent(MPI_COMM_WORLD,graph_in,graph_sources,MPI_UNWEIGHTED,graph_out,graph_dests,MPI_UNWEIGHTED,
+      MPI_INFO_NULL,0,&graph_comm);
+  graph_counts_out = new int[graph_out+1];
+  graph_displs_out = new int[graph_out+1];
+  graph_counts_in = new int[graph_in+1];
+  graph_displs_in = new int[graph_in+1];
+}
+#endif
+
+void allocateBuffers() {
+  int max_out=0;
+  int max_in=0;
+  int max_gather=0;
+  int max_node_out=0;
+  int max_node_in=0;
+  for (int s=0; s<no_steps; s++) {
+    int out=0;
+    int in=0;
+    for (int r=0; r<mpi_size; r++) {
+      out+=bytes[s][(mpi_rank*mpi_size)+r];
+      in+=bytes[s][(r*mpi_size)+mpi_rank];
+    }
+    if (out>max_out) max_out=out;
+    if (in>max_in) max_in=in;
+    if (local_rank==0) {                                 // Leaders hold everything their node sends and receives
+      int node_out=0;
+      int node_in=0;
+      for (int src=0; src<mpi_size; src++) {
+        for (int dest=0; dest<mpi_size; dest++) {
+          if (node_of[src]==node_of[mpi_rank]) node_out+=bytes[s][(src*mpi_size)+dest];
+          if (node_of[dest]==node_of[mpi_rank]) node_in+=bytes[s][(src*mpi_size)+dest];
+        }
+      }
+      if (node_out>max_gather) max_gather=node_out;
+      if (node_out>max_node_out) max_node_out=node_out;
+      if (node_in>max_node_in) max_node_in=node_in;
+    }
+  }
+  send_buf = new unsigned char[max_out+1];
+  recv_buf = new unsigned char[max_in+1];
+  gather_buf = new unsigned char[max_gather+1];
+  node_send_buf = new unsigned char[max_node_out+1];
+  node_recv_buf = new unsigned char[max_node_in+1];
+  starter_out = new int[starter_msg_size];
+  starter_in = new int[starter_msg_size];
+  for (int i=0; i<starter_msg_size; i++) starter_out[i]=0;
+  image_out = new unsigned char[image_bytes+1];
+  image_in = new unsigned char[image_bytes+1];
+  memset(image_out,0,image_bytes+1);
+  counts_out = new int[mpi_size];
+  displs_out = new int[mpi_size];
+  counts_in = new int[mpi_size];
+  displs_in = new int[mpi_size];
+  requests = new MPI_Request[2*mpi_size];
+}
+
+void prepareStep(int s) {
+  // Counts/displacements as doMessage() would have them, and the synthetic outgoing payload.
+  int* b = bytes[s];
+  displs_out[0]=0;
+  displs_in[0]=0;
+  for (int r=0; r<mpi_size; r++) {
+    counts_out[r]=b[(mpi_rank*mpi_size)+r];
+    counts_in[r]=b[(r*mpi_size)+mpi_rank];
+    if (r>0) {
+      displs_out[r]=displs_out[r-1]+counts_out[r-1];
+      displs_in[r]=displs_in[r-1]+counts_in[r-1];
+    }
+  }
+  for (int r=0; r<mpi_size; r++) memset(&send_buf[displs_out[r]],pattern(s,mpi_rank,r),counts_out[r]);
+}
+
+int verifyStep(int s) {
+  int errors=0;
+  for (int r=0; r<mpi_size; r++) {
+    unsigned char expect=pattern(s,r,mpi_rank);
+    for (int i=0; i<counts_in[r]; i++) if (recv_buf[displs_in[r]+i]!=expect) errors++;
+  }
+  return errors;
+}
+
+void exchangeAlltoallv() {
+  MPI_Alltoallv(send_buf,counts_out,displs_out,MPI_UNSIGNED_CHAR,recv_buf,counts_in,displs_in,MPI_UNSIGNED_CHAR,MPI_COMM_WORLD);
+}
+
+void exchangeNonBlocking() {
+  // Point-to-point only between pairs that have something to say this step.
+  int n=0;
+  for (int r=0; r<mpi_size; r++) {
+    if (counts_in[r]>0) {
+      if (r==mpi_rank) memcpy(&recv_buf[displs_in[r]],&send_buf[displs_out[r]],counts_in[r]);
+      else MPI_Irecv(&recv_buf[displs_in[r]],counts_in[r],MPI_UNSIGNED_CHAR,r,0,MPI_COMM_WORLD,&requests[n++]);
+    }
+  }
+  for (int r=0; r<mpi_size; r++) {
+    if ((counts_out[r]>0) && (r!=mpi_rank)) MPI_Isend(&send_buf[displs_out[r]],counts_out[r],MPI_UNSIGNED_CHAR,r,0,MPI_COMM_WORLD,&requests[n++]);
+  }
+  MPI_Waitall(n,requests,MPI_STATUSES_IGNORE);
+}
+
+#if MPI_VERSION>=3
+void exchangeNeighbour() {
+  for (int i=0; i<graph_out; i++) {
+    graph_counts_out[i]=counts_out[graph_dests[i]];
+    graph_displs_out[i]=displs_out[graph_dests[i]];
+  }
+  for (int i=0; i<graph_in; i++) {
+    graph_counts_in[i]=counts_in[graph_sources[i]];
+    graph_displs_in[i]=displs_in[graph_sources[i]];
+  }
+  MPI_Neighbor_alltoallv(send_buf,graph_counts_out,graph_displs_out,MPI_UNSIGNED_CHAR,
+                         recv_buf,graph_counts_in,graph_displs_in,MPI_UNSIGNED_CHAR,graph_comm);
+}
+#endif
+
+void exchangeHierarchical(int s) {
+  // 1. Gather every local rank's outgoing buffer on the node leader.
+  // 2. Leaders exchange node-to-node buffers.
+  // 3. Leaders scatter each local rank its incoming bytes, ordered by source rank as Alltoallv would.
+
+  int* b = bytes[s];
+  const int my_node = node_of[mpi_rank];
+  int total=0;
+  if (local_rank==0) {
+    for (int l=0; l<local_size; l++) {
+      int src=node_ranks[my_node][l];
+      local_counts[l]=0;
+      for (int r=0; r<mpi_size; r++) local_counts[l]+=b[(src*mpi_size)+r];
+      local_displs[l]=total;
+      total+=local_counts[l];
+    }
+  }
+  MPI_Gatherv(send_buf,displs_out[mpi_size-1]+counts_out[mpi_size-1],MPI_UNSIGNED_CHAR,
+              gather_buf,local_counts,local_displs,MPI_UNSIGNED_CHAR,0,node_comm);
+
+  if (local_rank==0) {
+    int count=0;
+    for (int n=0; n<no_nodes; n++) {                   // Pack: for each dest node, each local source, each rank on that node
+      node_displs_out[n]=count;
+      for (int l=0; l<local_size; l++) {
+        int src=node_ranks[my_node][l];
+        for (int i=0; i<node_size[n]; i++) {
+          int dest=node_ranks[n][i];
+          int offset=local_displs[l];
+          for (int r=0; r<dest; r++) offset+=b[(src*mpi_size)+r];
+          int len=b[(src*mpi_size)+dest];
+          memcpy(&node_send_buf[count],&gather_buf[offset],len);
+          count+=len;
+        }
+      }
+      node_counts_out[n]=count-node_displs_out[n];
+    }
+    count=0;
+    for (int n=0; n<no_nodes; n++) {
+      node_displs_in[n]=count;
+      for (int i=0; i<node_size[n]; i++)
+        for (int l=0; l<local_size; l++) count+=b[(node_ranks[n][i]*mpi_size)+node_ranks[my_node][l]];
+      node_counts_in[n]=count-node_displs_in[n];
+    }
+    MPI_Alltoallv(node_send_buf,node_counts_out,node_displs_out,MPI_UNSIGNED_CHAR,
+                  node_recv_buf,node_counts_in,node_displs_in,MPI_UNSIGNED_CHAR,leader_comm);
+
+    // Unpack into per-local-rank order (by source rank), reusing node_send_buf.
+
+    count=0;
+    for (int l=0; l<local_size; l++) {
+      int dest=node_ranks[my_node][l];
+      local_displs[l]=count;
+      for (int src=0; src<mpi_size; src++) {
+        int n=node_of[src];
+        int offset=node_displs_in[n];                    // Source block for (src,dest) within node n's buffer
+        int i=0;
+        while (node_ranks[n][i]!=src) {
+          for (int k=0; k<local_size; k++) offset+=b[(node_ranks[n][i]*mpi_size)+node_ranks[my_node][k]];
+          i++;
+        }
+        for (int k=0; k<l; k++) offset+=b[(src*mpi_size)+node_ranks[my_node][k]];
+        int len=b[(src*mpi_size)+dest];
+        memcpy(&node_send_buf[count],&node_recv_buf[offset],len);
+        count+=len;
+      }
+      local_counts[l]=count-local_displs[l];
+    }
+  }
+  MPI_Scatterv(node_send_buf,local_counts,local_displs,MPI_UNSIGNED_CHAR,
+               recv_buf,displs_in[mpi_size-1]+counts_in[mpi_size-1],MPI_UNSIGNED_CHAR,0,node_comm);
+}
+
+void runStrategy(int strat, int repeats, bool verify) {
+  double total_bytes=0;
+  int errors=0;
+  double max_step=0;
+  MPI_Barrier(MPI_COMM_WORLD);
+  double t0=MPI_Wtime();
+  for (int rep=0; rep<repeats; rep++) {
+    for (int s=0; s<no_steps; s++) {
+      double ts=MPI_Wtime();
+      prepareStep(s);
+      MPI_Allreduce(starter_out,starter_in,starter_msg_size,MPI_INT,MPI_SUM,MPI_COMM_WORLD);
+      if (image_bytes>0) MPI_Reduce(image_out,image_in,image_bytes,MPI_UNSIGNED_CHAR,MPI_SUM,0,MPI_COMM_WORLD);
+      if (strat==STRAT_ALLTOALLV) exchangeAlltoallv();
+      else if (strat==STRAT_NONBLOCKING) exchangeNonBlocking();
+#if MPI_VERSION>=3
+      else if (strat==STRAT_NEIGHBOUR) exchangeNeighbour();
+#endif
+      else if (strat==STRAT_HIERARCHICAL) exchangeHierarchical(s);
+      MPI_Barrier(MPI_COMM_WORLD);
+      ts=MPI_Wtime()-ts;
+      if (ts>max_step) max_step=ts;
+      if (verify) errors+=verifyStep(s);
+      for (int r=0; r<mpi_size; r++) total_bytes+=counts_out[r];
+    }
+  }
+  double t=MPI_Wtime()-t0;
+  double all_bytes=0;
+  int all_errors=0;
+  double all_max_step=0;
+  MPI_Reduce(&total_bytes,&all_bytes,1,MPI_DOUBLE,MPI_SUM,0,MPI_COMM_WORLD);
+  MPI_Reduce(&errors,&all_errors,1,MPI_INT,MPI_SUM,0,MPI_COMM_WORLD);
+  MPI_Reduce(&max_step,&all_max_step,1,MPI_DOUBLE,MPI_MAX,0,MPI_COMM_WORLD);
+  if (mpi_rank==0) {
+    int steps=no_steps*repeats;
+    printf("%-13s %8d %10.4f %10.4f %10.4f %10.2f %10.2f",strat_names[strat],steps,t,(steps>0)?1000.0*t/steps:0,
+        1000.0*all_max_step,all_bytes/1048576.0,(t>0)?all_bytes/(1048576.0*t):0);
+    if (verify) printf("  %s (%d bad bytes)",(all_errors==0)?"OK":"FAILED",all_errors);
+    printf("\n");
+    fflush(stdout);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  MPI_Init(&argc,&argv);
+  MPI_Comm_size(MPI_COMM_WORLD,&mpi_size);
+  MPI_Comm_rank(MPI_COMM_WORLD,&mpi_rank);
+
+  char* file=NULL;
+  int strat=-1;
+  int repeats=1;
+  int ppn=0;
+  bool verify=false;
+  for (int i=1; i<argc; i++) {
+    if (strnicmp("/repeats:",argv[i],9)==0) sscanf(argv[i]+9,"%d",&repeats);
+    else if (strnicmp("/ppn:",argv[i],5)==0) sscanf(argv[i]+5,"%d",&ppn);
+    else if (strnicmp("/verify",argv[i],7)==0) verify=true;
+    else if (file==NULL) file=argv[i];
+    else if (strcmp(argv[i],"all")!=0) {
+      for (int j=0; j<NO_STRATS; j++) if (strcmp(argv[i],strat_names[j])==0) strat=j;
+      if (strat==-1) {
+        if (mpi_rank==0) printf("Unknown strategy %s\n",argv[i]);
+        MPI_Finalize();
+        return 1;
+      }
+    }
+  }
+  if (file==NULL) {
+    if (mpi_rank==0) printf("Usage: commreplay <traffic file> [all|alltoallv|nonblocking|neighbour|hierarchical] [/repeats:N] [/ppn:N] [/verify]\n");
+    MPI_Finalize();
+    return 1;
+  }
+  if (loadTraffic(file)!=0) {
+    fflush(stdout);
+    MPI_Abort(MPI_COMM_WORLD,1);
+  }
+
+  initNodes(ppn);
+#if MPI_VERSION>=3
+  initGraph();
+#endif
+  allocateBuffers();
+
+  if (mpi_rank==0) {
+    printf("Replaying %s: %d ranks on %d node(s), %d steps, starter message %d ints%s\n",file,mpi_size,no_nodes,no_steps,
+        starter_msg_size,(image_bytes>0)?", with movie reduce":"");
+    printf("%-13s %8s %10s %10s %10s %10s %10s\n","strategy","steps","total_s","ms/step","max_ms","MB","MB/s");
+    fflush(stdout);
+  }
+  for (int j=0; j<NO_STRATS; j++) {
+    if ((strat==-1) || (strat==j)) {
+#if MPI_VERSION<3
+      if (j==STRAT_NEIGHBOUR) {
+        if (mpi_rank==0) printf("%-13s (needs MPI-3)\n",strat_names[j]);
+        continue;
+      }
+#endif
+      runStrategy(j,repeats,verify);
+    }
+  }
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,3 @@
+INCLUDE="../../include/linux"
+LIB="../../lib/linux"
+g++ -I$INCLUDE -L$LIB -Wall -O2 -ocommreplay commreplay.cpp -lmpich -lopa -lpthread -lrt
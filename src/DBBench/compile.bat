@@ -0,0 +1,3 @@
+set LIBS= -L..\..\lib\win32
+set INCLUDE=..\..\include\win
+g++ -I%INCLUDE% %LIBS% -Wall -O2 -fopenmp -odbbench.exe dbbench.cpp ../Sim/DBOpsPar.cpp -lodbc32
@@ -0,0 +1,3 @@
+INCLUDE="../../include/linux"
+LIB="../../lib/linux"
+g++ -I$INCLUDE -L$LIB -Wall -O2 -fopenmp -odbbench dbbench.cpp ../Sim/DBOpsPar.cpp -lodbc
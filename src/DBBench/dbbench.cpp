@@ -0,0 +1,122 @@
+/* dbbench.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Database logging benchmark - row-at-a-time against batched, array-bound inserts
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "../Sim/DBOpsPar.h"
+
+#ifndef _WIN32
+  #define strnicmp strncasecmp
+#endif
+
+// Inserts the same synthetic unit rows into a scratch table twice, and reports rows/s for each:
+//
+//   single - as logDB used to: one SQLExecute per row, and a commit after each timestep's rows
+//   batched - as the writer thread now does: rows held back to DB_FLUSH_ROWS (or /batch:), then sent
+//             DB_ARRAY_ROWS at a time as parameter arrays, with one commit per batch
+//
+// Any ODBC data source will do. For a local check without a database server, use the SQLite ODBC driver
+// (sqliteodbc) with a DSN in ~/.odbc.ini, for example
+//
+//   [gesbench]
+//   Driver=/usr/lib/x86_64-linux-gnu/odbc/libsqlite3odbc.so
+//   Database=/tmp/gesbench.db
+//
+// and run: dbbench gesbench 100000
+//
+// The table (/table:, default dbbench) is dropped and re-created, so don't point it at real output.
+
+void fillRows(int* rows, int no_rows, int row_width, int first) {
+  for (int r=0; r<no_rows; r++) {
+    int* row = &rows[r*row_width];
+    row[0]=((first+r)/500)*6;                       // 500 units logged per 6-hour timestep
+    row[1]=(first+r)%500;
+    for (int c=2; c<row_width; c++) row[c]=(first+r+c)%97;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  if (argc<2) {
+    printf("Usage: dbbench <DSN> [rows] [place types] [/user:u] [/pass:p] [/table:dbbench] [/batch:%d]\n",DB_FLUSH_ROWS);
+    return 1;
+  }
+  int no_rows=20000;
+  int no_place_types=4;
+  int batch=DB_FLUSH_ROWS;
+  char* user=(char*) "user";
+  char* pass=(char*) "password";
+  char* table=(char*) "dbbench";
+  int n=0;
+  for (int i=2; i<argc; i++) {
+    if (strnicmp("/user:",argv[i],6)==0) user=argv[i]+6;
+    else if (strnicmp("/pass:",argv[i],6)==0) pass=argv[i]+6;
+    else if (strnicmp("/table:",argv[i],7)==0) table=argv[i]+7;
+    else if (strnicmp("/batch:",argv[i],7)==0) batch=atoi(argv[i]+7);
+    else if (n==0) { no_rows=atoi(argv[i]); n++; }
+    else if (n==1) { no_place_types=atoi(argv[i]); n++; }
+  }
+  if (batch<1) batch=1;
+  int row_width=9+(2*no_place_types);
+  int* rows = new int[no_rows*row_width];
+  fillRows(rows,no_rows,row_width,0);
+  double t_single=0;
+  double t_batched=0;
+
+  try {
+    DBOps db(argv[1],user,pass);
+    db.Connect();
+    db.prepareCommands(no_place_types,table);
+
+    db.DropTable();
+    db.CreateTable();
+    db.PrepareSQLInsertStmt(1);
+    double t0=omp_get_wtime();
+    for (int r=0; r<no_rows; r++) {
+      db.InsertRecord(&rows[r*row_width]);
+      if ((r%500==499) || (r==no_rows-1)) db.CommitInsChanges();
+    }
+    t_single=omp_get_wtime()-t0;
+    db.DeleteSQLInsertStmt();
+
+    db.DropTable();
+    db.CreateTable();
+    db.PrepareSQLInsertStmt(DB_ARRAY_ROWS);
+    t0=omp_get_wtime();
+    for (int r=0; r<no_rows; r+=batch) {
+      db.InsertRecords(&rows[r*row_width],(r+batch<=no_rows)?batch:no_rows-r);
+      db.CommitInsChanges();
+    }
+    t_batched=omp_get_wtime()-t0;
+    db.DeleteSQLInsertStmt();
+    db.DropTable();
+  }
+  catch (int Error) {
+    printf("Database error %d\n",Error);
+    return 1;
+  }
+
+  printf("%d rows of %d columns\n",no_rows,row_width);
+  printf("single:  %8.3f s  %10.0f rows/s\n",t_single,no_rows/t_single);
+  printf("batched: %8.3f s  %10.0f rows/s  (%d-row arrays, commit every %d rows)\n",t_batched,no_rows/t_batched,DB_ARRAY_ROWS,batch);
+  printf("speed-up: %.1fx\n",t_single/t_batched);
+  delete[] rows;
+  return 0;
+}
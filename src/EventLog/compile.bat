@@ -0,0 +1 @@
+g++ -Wall -O2 -oevents.exe events.cpp ../Sim/lodepng.cpp
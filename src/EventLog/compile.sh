@@ -0,0 +1 @@
+g++ -Wall -O2 -oevents events.cpp ../Sim/lodepng.cpp
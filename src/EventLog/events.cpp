@@ -0,0 +1,103 @@
+/* events.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Read a transmission event log (/events:) and write it out as text
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "../Sim/lodepng.h"
+#include "../Sim/eventlog.h"
+
+// events info   <file.rank>              Number of events and chunks, and the split by setting
+// events totext <file.rank> <text file>  One line per event: infector infectee t unit setting place_type infector_node
+//
+// See ../Sim/eventlog.cpp for the format. Infector is -1 for seeded infections, and for infections by someone on
+// another node (infector_node). Each rank's file is read separately.
+
+const char* settings[5] = {"seed","household","place","community","travel"};
+
+int main(int argc, char* argv[]) {
+  if (argc<3) {
+    printf("Usage: events info <file.rank>\n");
+    printf("       events totext <file.rank> <text file>\n");
+    return 1;
+  }
+  FILE* f = fopen(argv[2],"rb");
+  char magic[8];
+  int head[4];
+  if ((f==NULL) || (fread(magic,1,8,f)!=8) || (memcmp(magic,EVENT_MAGIC,8)!=0) || (fread(head,sizeof(int),4,f)!=4)) {
+    fprintf(stderr,"%s is not an event log\n",argv[2]);
+    return 1;
+  }
+  FILE* out = NULL;
+  if ((strcmp(argv[1],"totext")==0) && (argc>3)) {
+    out = fopen(argv[3],"w");
+    if (out==NULL) {
+      fprintf(stderr,"Can't write %s\n",argv[3]);
+      return 1;
+    }
+  } else if (strcmp(argv[1],"info")!=0) {
+    fprintf(stderr,"Unknown command %s\n",argv[1]);
+    return 1;
+  }
+
+  long long no_events=0;
+  long long by_setting[5] = {0,0,0,0,0};
+  long long packed_bytes=0;
+  int chunks=0;
+  int chunk[4];
+  std::vector<unsigned char> packed,raw;
+  while (fread(chunk,sizeof(int),4,f)==4) {
+    int n=chunk[0];
+    packed.resize(chunk[2]);
+    if ((chunk[2]==0) || (fread(&packed[0],1,chunk[2],f)!=(size_t) chunk[2])) {
+      fprintf(stderr,"Chunk %d is truncated\n",chunks);
+      break;
+    }
+    raw.clear();
+    if ((LodeZlib::decompress(raw,packed)!=0) || (raw.size()!=(size_t) chunk[1])) {
+      fprintf(stderr,"Chunk %d is corrupt\n",chunks);
+      break;
+    }
+    const SIM_I64* infector = (const SIM_I64*) &raw[0];
+    const SIM_I64* infectee = infector+n;
+    const float* t = (const float*) (infectee+n);
+    const int* unit = (const int*) (t+n);
+    const unsigned char* setting = (const unsigned char*) (unit+n);
+    const unsigned char* place_type = setting+n;
+    const unsigned short* infector_node = (const unsigned short*) (place_type+n);
+    for (int i=0; i<n; i++) {
+      if (setting[i]<5) by_setting[setting[i]]++;
+      if (out!=NULL) fprintf(out,"%lld\t%lld\t%.2f\t%d\t%s\t%d\t%d\n",(long long) infector[i],(long long) infectee[i],t[i],
+                             unit[i],(setting[i]<5)?settings[setting[i]]:"?",place_type[i],infector_node[i]);
+    }
+    no_events+=n;
+    packed_bytes+=chunk[2];
+    chunks++;
+  }
+  fclose(f);
+  if (out!=NULL) fclose(out);
+
+  if (strcmp(argv[1],"info")==0) {
+    printf("Written by rank %d of %d\n",head[1],head[2]);
+    printf("Events: %lld, in %d chunks (%.1f MB compressed)\n",no_events,chunks,packed_bytes/1048576.0);
+    for (int i=0; i<5; i++) printf("  %s: %lld\n",settings[i],by_setting[i]);
+  }
+  return 0;
+}
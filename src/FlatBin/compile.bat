@@ -0,0 +1 @@
+g++ -Wall -O2 -oflatbin.exe flatbin.cpp
@@ -0,0 +1,138 @@
+/* flatbin.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Extract time series and cross-sections from a binary flat file, or convert it to text
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../Sim/flatbin.h"
+
+// flatbin info   <file>               Header, timestep range and index sizes
+// flatbin unit   <file> <unit>        Every row for one unit, in time order
+// flatbin step   <file> <T>           Every row for timestep T (hours)
+// flatbin totext <file> <text file>   The whole file, as the simulator's text flat file would have been
+//
+// Rows are printed exactly as the text flat file has them, so existing scripts can read the output.
+// Sharded files (/ffmpi:) are recognised too: they have a row for every unit every timestep, so "unit" and "step"
+// print every row, zeros included, while "totext" keeps only the rows the text flat file would have had.
+
+int shardMain(int argc, char* argv[]) {
+  flatbinShardFile fs;
+  if (!fs.open(argv[2])) {
+    fprintf(stderr,"%s: %s\n",argv[2],fs.error);
+    return 1;
+  }
+  if (strcmp(argv[1],"info")==0) {
+    printf("Sharded file, written by %d ranks\n",fs.header.no_ranks);
+    printf("Units: %d\n",fs.header.no_units);
+    printf("Place types: %d\n",fs.header.no_place_types);
+    printf("Columns: %d\n",fs.noColumns());
+    printf("Timesteps: %d",fs.noSteps());
+    if (fs.noSteps()>0) printf(" (T=0 to %d)",fs.stepT(fs.noSteps()-1));
+    if (fs.header.no_steps==0) printf(" - the run didn't finish");
+    printf("\n");
+    for (int r=0; r<fs.header.no_ranks; r++) printf("Rank %d: units %d to %d\n",r,fs.rankStart(r),fs.rankStart(r+1)-1);
+
+  } else if ((strcmp(argv[1],"unit")==0) && (argc>3)) {
+    int u=atoi(argv[3]);
+    if ((u>=0) && (u<fs.header.no_units))
+      for (int s=0; s<fs.noSteps(); s++) fs.printRow(stdout,s,u);
+
+  } else if ((strcmp(argv[1],"step")==0) && (argc>3)) {
+    int s=fs.findStep(atoi(argv[3]));
+    if (s>=0)
+      for (int u=0; u<fs.header.no_units; u++) fs.printRow(stdout,s,u);
+
+  } else if ((strcmp(argv[1],"totext")==0) && (argc>3)) {
+    FILE* f = fopen(argv[3],"w");
+    if (f==NULL) {
+      fprintf(stderr,"Can't write %s\n",argv[3]);
+      return 1;
+    }
+    for (int s=0; s<fs.noSteps(); s++)
+      for (int u=0; u<fs.header.no_units; u++)
+        if (fs.wouldLog(s,u)) fs.printRow(f,s,u);
+    fclose(f);
+
+  } else {
+    fprintf(stderr,"Unknown command %s\n",argv[1]);
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc<3) {
+    printf("Usage: flatbin info <file>\n");
+    printf("       flatbin unit <file> <unit>\n");
+    printf("       flatbin step <file> <T>\n");
+    printf("       flatbin totext <file> <text file>\n");
+    return 1;
+  }
+  char magic[8];
+  FILE* f = fopen(argv[2],"rb");
+  if ((f!=NULL) && (fread(magic,1,8,f)==8) && (memcmp(magic,FLATBIN_SHARD_MAGIC,8)==0)) {
+    fclose(f);
+    return shardMain(argc,argv);
+  }
+  if (f!=NULL) fclose(f);
+  flatbinFile fb;
+  if (!fb.open(argv[2])) {
+    fprintf(stderr,"%s: %s\n",argv[2],fb.error);
+    return 1;
+  }
+
+  if (strcmp(argv[1],"info")==0) {
+    long long rows=0;
+    for (int b=0; b<fb.noBlocks(); b++) rows+=fb.blockRows(b);
+    printf("Units: %d\n",fb.header.no_units);
+    printf("Place types: %d\n",fb.header.no_place_types);
+    printf("Columns: %d\n",fb.noColumns());
+    printf("Timesteps logged: %d",fb.noBlocks());
+    if (fb.noBlocks()>0) printf(" (T=%d to %d)",fb.blockT(0),fb.blockT(fb.noBlocks()-1));
+    printf("\nRows: %lld\n",rows);
+    printf("Unit index runs: %d\n",fb.trailer.no_runs);
+
+  } else if ((strcmp(argv[1],"unit")==0) && (argc>3)) {
+    int u=atoi(argv[3]);
+    const flatbinRun* runs = fb.unitRuns(u);
+    for (int i=0; i<fb.noRuns(u); i++)
+      for (int b=runs[i].first_block; b<runs[i].first_block+runs[i].no_blocks; b++)
+        fb.printRow(stdout,b,fb.findRow(b,u));
+
+  } else if ((strcmp(argv[1],"step")==0) && (argc>3)) {
+    int b=fb.findBlock(atoi(argv[3]));
+    if (b>=0)
+      for (int r=0; r<fb.blockRows(b); r++) fb.printRow(stdout,b,r);
+
+  } else if ((strcmp(argv[1],"totext")==0) && (argc>3)) {
+    FILE* f = fopen(argv[3],"w");
+    if (f==NULL) {
+      fprintf(stderr,"Can't write %s\n",argv[3]);
+      return 1;
+    }
+    for (int b=0; b<fb.noBlocks(); b++)
+      for (int r=0; r<fb.blockRows(b); r++) fb.printRow(f,b,r);
+    fclose(f);
+
+  } else {
+    fprintf(stderr,"Unknown command %s\n",argv[1]);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1 @@
+g++ -Wall -O2 -fopenmp -omovieconv.exe movieconv.cpp ../Sim/pngframe.cpp
@@ -0,0 +1 @@
+g++ -Wall -O2 -fopenmp -omovieconv movieconv.cpp ../Sim/pngframe.cpp
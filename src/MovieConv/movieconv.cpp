@@ -0,0 +1,87 @@
+/* movieconv.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Turn run-length movie frames (/moviefmt:rle) into PNGs
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "omp.h"
+#include "../Sim/pngframe.h"
+
+// movieconv [/threads:N] <frame.rle> [<frame.rle> ...]
+//
+// Writes frame.png beside each frame.rle, exactly as the simulator would have saved it without /moviefmt:rle.
+// Frames are converted in parallel, N at a time (default: all cores).
+
+int main(int argc, char* argv[]) {
+  int threads=omp_get_max_threads();
+  std::vector<char*> files;
+  for (int i=1; i<argc; i++) {
+    if (strncmp(argv[i],"/threads:",9)==0) threads=atoi(argv[i]+9);
+    else files.push_back(argv[i]);
+  }
+  if (files.size()==0) {
+    printf("Usage: movieconv [/threads:N] <frame.rle> [<frame.rle> ...]\n");
+    return 1;
+  }
+  if (threads<1) threads=1;
+
+  int failed=0;
+  double t0=omp_get_wtime();
+  int i;
+  #pragma omp parallel for num_threads(threads) schedule(dynamic,1) reduction(+:failed)
+  for (i=0; i<(int) files.size(); i++) {
+    std::vector<unsigned char> rle,image,png;
+    FILE* f = fopen(files[i],"rb");
+    if (f!=NULL) {
+      fseek(f,0,SEEK_END);
+      long bytes=ftell(f);
+      fseek(f,0,SEEK_SET);
+      rle.resize(bytes);
+      if ((bytes>0) && (fread(&rle[0],1,bytes,f)!=(size_t) bytes)) rle.clear();
+      fclose(f);
+    }
+    int width,height;
+    if (!frameEncoder::decodeRLE(rle,width,height,image)) {
+      fprintf(stderr,"%s is not a run-length frame\n",files[i]);
+      failed++;
+      continue;
+    }
+    frameEncoder encoder(width,height,1);
+    encoder.encodePNG(&image[0],png);
+
+    std::string name(files[i]);
+    size_t dot=name.rfind(".rle");
+    if (dot!=std::string::npos) name.erase(dot);
+    name.append(".png");
+    f = fopen(name.c_str(),"wb");
+    if (f==NULL) {
+      fprintf(stderr,"Can't write %s\n",name.c_str());
+      failed++;
+      continue;
+    }
+    fwrite(&png[0],1,png.size(),f);
+    fclose(f);
+  }
+  printf("%d frames converted in %.2f s",(int) files.size()-failed,omp_get_wtime()-t0);
+  if (failed>0) printf(", %d failed",failed);
+  printf("\n");
+  return (failed>0)?1:0;
+}
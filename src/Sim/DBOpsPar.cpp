@@ -22,8 +22,10 @@ SQLHENV DBOps::HEnv = NULL;
 const char DBOps::CrSchmStmtPrt1[] = "CREATE SCHEMA ";
 
 void DBOps::prepareCommands(int no_place_types, char* tableName) {
-  num_values = 6+(2*no_place_types);
-  Val = new int[num_values];
+  num_values = 9+(2*no_place_types);
+  array_rows = 0;
+  Cols = NULL;
+  RowStatus = NULL;
 
   string create = "CREATE TABLE ";
   string insert = "INSERT INTO ";
@@ -58,7 +60,7 @@ void DBOps::prepareCommands(int no_place_types, char* tableName) {
     }
     create.append(")");
     insert.append(") VALUES (?");
-    for (int i=0; i<(no_place_types*2)+9; i++) insert.append(", ?");
+    for (int i=1; i<(no_place_types*2)+9; i++) insert.append(", ?");
     insert.append(")");
   }
   create_table = new char[create.length()+1];
@@ -286,9 +288,11 @@ void DBOps::CreateSchema(char *SchmName)
 }
 
 
-void DBOps::PrepareSQLInsertStmt()
+void DBOps::PrepareSQLInsertStmt(int rows)
 {
 	// an appropriate table must already exist in the database!
+	// rows > 1 binds each parameter to an array of that many values (column-wise), so InsertRecords sends
+	// up to that many rows per SQLExecute instead of one round trip per row.
 
 	SQLRETURN RetCode;
 	RetCode = SQLAllocHandle(SQL_HANDLE_STMT, HDbc, &HInsStmt);
@@ -321,6 +325,25 @@ void DBOps::PrepareSQLInsertStmt()
 		throw WRONG_NUM_PARAMS;
 	}
 
+	array_rows = (rows>1) ? rows : 1;
+	if( array_rows > 1 )
+	{
+		RetCode = SQLSetStmtAttr(HInsStmt, SQL_ATTR_PARAM_BIND_TYPE, (SQLPOINTER) SQL_PARAM_BIND_BY_COLUMN, 0);
+		if( RetCode == SQL_SUCCESS || RetCode == SQL_SUCCESS_WITH_INFO )
+			RetCode = SQLSetStmtAttr(HInsStmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER) (SQLULEN) array_rows, 0);
+		if( RetCode != SQL_SUCCESS && RetCode != SQL_SUCCESS_WITH_INFO )
+		{
+			cerr << "Driver doesn't take parameter arrays - inserting one row at a time\n";
+			array_rows = 1;
+			SQLSetStmtAttr(HInsStmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER) 1, 0);
+		}
+	}
+	ParamsetSize = array_rows;
+	Cols = new int[num_values*array_rows];
+	RowStatus = new SQLUSMALLINT[array_rows];
+	SQLSetStmtAttr(HInsStmt, SQL_ATTR_PARAM_STATUS_PTR, RowStatus, 0);
+	SQLSetStmtAttr(HInsStmt, SQL_ATTR_PARAMS_PROCESSED_PTR, &RowsProcessed, 0);
+
 	SQLSMALLINT i, DataType, DecimalDigits, Nullable;
 	SQLULEN ParamSize;
 	for(i=0; i < NumParams; i++)
@@ -334,7 +357,7 @@ void DBOps::PrepareSQLInsertStmt()
 		  RetCode = SQLGetDiagField(SQL_HANDLE_STMT, HInsStmt, 1, SQL_DIAG_SQLSTATE, SQLState, SQLSTATE_CODE_LNGTH + 1, &TextLength);
       printf("Error %s\n",SQLState);
     }
-		RetCode = SQLBindParameter(HInsStmt, i+1, SQL_PARAM_INPUT, SQL_C_SLONG, DataType, ParamSize, DecimalDigits, &Val[i], sizeof(int), NULL);
+		RetCode = SQLBindParameter(HInsStmt, i+1, SQL_PARAM_INPUT, SQL_C_SLONG, DataType, ParamSize, DecimalDigits, &Cols[i*array_rows], sizeof(int), NULL);
 		if( RetCode != SQL_SUCCESS && RetCode != SQL_SUCCESS_WITH_INFO )
 		{
 			cerr << "Error binding a parameter in an SQL statement\n";
@@ -346,17 +369,36 @@ void DBOps::PrepareSQLInsertStmt()
 
 void DBOps::InsertRecord(int *InsVal)
 {
-	SQLSMALLINT i;
-	for(i=0; i < num_values; i++)
-		Val[i] = InsVal[i];
+	InsertRecords(InsVal, 1);
+}
 
+
+void DBOps::InsertRecords(int *InsVals, int no_rows)
+{
 	SQLRETURN RetCode;
-	RetCode = SQLExecute(HInsStmt);
-	if( RetCode != SQL_SUCCESS && RetCode != SQL_SUCCESS_WITH_INFO )
+	for(int start=0; start < no_rows; start += array_rows)
 	{
-		cerr << "Error inserting a record in the database\n";
-		SQLFreeHandle(SQL_HANDLE_STMT, HInsStmt);
-		throw INS_REC_ERROR;
+		int n = no_rows-start;
+		if( n > array_rows )
+			n = array_rows;
+		for(int i=0; i < num_values; i++)             // Transpose into the bound columns
+		{
+			int* col = &Cols[i*array_rows];
+			for(int r=0; r < n; r++)
+				col[r] = InsVals[((start+r)*num_values)+i];
+		}
+		if( ParamsetSize != (SQLULEN) n )
+		{
+			SQLSetStmtAttr(HInsStmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER) (SQLULEN) n, 0);
+			ParamsetSize = n;
+		}
+		RetCode = SQLExecute(HInsStmt);
+		if( RetCode != SQL_SUCCESS && RetCode != SQL_SUCCESS_WITH_INFO )
+		{
+			cerr << "Error inserting a record in the database\n";
+			SQLFreeHandle(SQL_HANDLE_STMT, HInsStmt);
+			throw INS_REC_ERROR;
+		}
 	}
 }
 
@@ -364,6 +406,10 @@ void DBOps::InsertRecord(int *InsVal)
 void DBOps::DeleteSQLInsertStmt()
 {
 	SQLFreeHandle(SQL_HANDLE_STMT, HInsStmt);
+	delete[] Cols;
+	delete[] RowStatus;
+	Cols = NULL;
+	RowStatus = NULL;
 }
 
 
@@ -51,6 +51,9 @@ using namespace std;
 #define TRAN_ROLLBACK_ERROR      15
 #define INS_REC_ERROR            16
 
+#define DB_ARRAY_ROWS 1000       // Rows bound to the INSERT as parameter arrays, sent in one SQLExecute
+#define DB_FLUSH_ROWS 10000      // Default rows held back across timesteps before they are inserted and committed (/dbbatch:)
+
 
 class DBOps
 {
@@ -67,7 +70,11 @@ private:
 	char Passwd[DBOPS_MAX_BUFF_LENGTH];     // buffer for a password
 
 	int num_values;
-	int* Val;
+	int array_rows;         // Rows per SQLExecute - 1 if the driver can't take parameter arrays
+	int* Cols;              // num_values columns of array_rows ints, bound column-wise
+	SQLUSMALLINT* RowStatus;
+	SQLULEN RowsProcessed;
+	SQLULEN ParamsetSize;   // Currently set SQL_ATTR_PARAMSET_SIZE
 	char* create_table;
 	char* insert_statement;
 	char* drop_table;
@@ -81,8 +88,9 @@ public:
 	void CreateTable();
 	void DropTable();
 	void CreateSchema(char *ShmName);
-	void PrepareSQLInsertStmt();
+	void PrepareSQLInsertStmt(int rows=1);
 	void InsertRecord(int *InsVal);
+	void InsertRecords(int *InsVals, int no_rows);   // no_rows rows of num_values ints, in DB_ARRAY_ROWS-size executes
 	void DeleteSQLInsertStmt();
 	void CommitInsChanges();
 	void RollbackInsChanges();
@@ -19,7 +19,18 @@ call %COMPILE%params.o params.cpp
 call %COMPILE%lodepng.o lodepng.cpp
 call %COMPILE%household.o household.cpp
 call %COMPILE%output.o output.cpp
+call %COMPILE%timing.o timing.cpp
+call %COMPILE%workqueue.o workqueue.cpp
+call %COMPILE%susceptibles.o susceptibles.cpp
+call %COMPILE%writer.o writer.cpp
+call %COMPILE%shardout.o shardout.cpp
+call %COMPILE%eventlog.o eventlog.cpp
+call %COMPILE%imagegrid.o imagegrid.cpp
+call %COMPILE%pngframe.o pngframe.cpp
+call %COMPILE%memreport.o memreport.cpp
+call %COMPILE%preflight.o preflight.cpp
+call %COMPILE%metrics.o metrics.cpp
 
-call %LINK%Sim.exe world.o unit.o sim.o randlib_par.o place.o person.o patch.o params.o output.o messages.o lodepng.o intervention.o initialise.o household.o gps_math.o DBOpsPar.o -lmsmpi -lodbc32
+call %LINK%Sim.exe world.o unit.o sim.o randlib_par.o place.o person.o patch.o params.o output.o messages.o lodepng.o intervention.o initialise.o household.o gps_math.o DBOpsPar.o timing.o workqueue.o susceptibles.o writer.o shardout.o eventlog.o imagegrid.o pngframe.o memreport.o preflight.o metrics.o -lmsmpi -lodbc32 -lpthread
 
 del *.o /Q
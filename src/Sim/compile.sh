@@ -1,6 +1,6 @@
 INCLUDE="../../include/linux"
 LIB="../../lib/linux"
-COMPILE="g++ -I$INCLUDE -Wl,-Bsymbolic-functions -L$LIB -lmpich -lopa -lpthread -lrt -lodbc -fopenmp -O2  -c "
+COMPILE="g++ -I$INCLUDE -Wl,-Bsymbolic-functions -L$LIB -lmpich -lopa -lpthread -lrt -lodbc -fopenmp -O2 -fno-math-errno -c "
 LINK="g++ -I$INCLUDE -L$LIB -fopenmp -lodbc -lmpich -lopa -lpthread -lrt -Wl,-Bsymbolic-functions"
 
 echo Sim
@@ -35,9 +35,31 @@ echo Household
 $COMPILE -ohousehold.o household.cpp
 echo Output
 $COMPILE -ooutput.o output.cpp
+echo Timing
+$COMPILE -otiming.o timing.cpp
+echo WorkQueue
+$COMPILE -oworkqueue.o workqueue.cpp
+echo Susceptibles
+$COMPILE -osusceptibles.o susceptibles.cpp
+echo Writer
+$COMPILE -owriter.o writer.cpp
+echo ShardOut
+$COMPILE -oshardout.o shardout.cpp
+echo EventLog
+$COMPILE -oeventlog.o eventlog.cpp
+echo ImageGrid
+$COMPILE -oimagegrid.o imagegrid.cpp
+echo PngFrame
+$COMPILE -opngframe.o pngframe.cpp
+echo MemReport
+$COMPILE -omemreport.o memreport.cpp
+echo PreFlight
+$COMPILE -opreflight.o preflight.cpp
+echo Metrics
+$COMPILE -ometrics.o metrics.cpp
 
 echo Link
 
-$LINK -oSim world.o unit.o sim.o randlib_par.o place.o person.o patch.o params.o output.o messages.o lodepng.o intervention.o initialise.o household.o gps_math.o DBOpsPar.o
+$LINK -oSim world.o unit.o sim.o randlib_par.o place.o person.o patch.o params.o output.o messages.o lodepng.o intervention.o initialise.o household.o gps_math.o DBOpsPar.o timing.o workqueue.o susceptibles.o writer.o shardout.o eventlog.o imagegrid.o pngframe.o memreport.o preflight.o metrics.o
 
 rm *.o
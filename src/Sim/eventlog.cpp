@@ -0,0 +1,82 @@
+/* eventlog.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Optional per-thread log of who infected whom
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+#include "eventlog.h"
+#include "world.h"
+
+// /events:file records every infection: who infected whom, when, in what setting, and the infectee's unit. The
+// infection sites in sim.cpp append a fixed-size record to their thread's own buffer - no locks, and nothing done
+// unless the log is on - and at the end of each timestep the master gathers the buffers. Every EVENT_CHUNK events
+// the chunk goes to the output writer thread, which compresses and writes it (see writer.cpp), so the main loop
+// never formats or compresses anything.
+//
+// Each rank writes its own file, file.<rank>:
+//
+//   "GESEVNT1", int version, int rank, int no_ranks, int record bytes
+//   for each chunk:  int events, int raw bytes, int compressed bytes, int 0, then zlib data
+//
+// A chunk decompresses to the records' fields one column at a time - infector[n] then infectee[n] (8 bytes each),
+// t[n] (float), unit[n] (int), setting[n], place_type[n] (1 byte each), infector_node[n] (2 bytes) - which
+// compresses much better than whole records. Infections of people on this node by an infector on another node
+// (remote community and place contacts) have infector EVENT_NO_INFECTOR and the infector's node.
+
+eventLog::eventLog(world* w, const char* file) {
+  thread_count=w->thread_count;
+  buffers = new eventBuffer[thread_count];
+  for (int i=0; i<thread_count; i++) buffers[i].events.reserve(4096);
+  chunk.reserve(EVENT_CHUNK);
+  no_events=0;
+  chunks=0;
+  char* name = new char[strlen(file)+16];
+  sprintf(name,"%s.%d",file,w->mpi_rank);
+  f=fopen(name,"wb");
+  if (f==NULL) {
+    printf("%d: Couldn't open event log %s\n",w->mpi_rank,name);
+    fflush(stdout);
+  } else {
+    int head[4] = {1,w->mpi_rank,w->mpi_size,(int) sizeof(transmissionEvent)};
+    fwrite(EVENT_MAGIC,1,8,f);
+    fwrite(head,sizeof(int),4,f);
+  }
+  delete[] name;
+}
+
+eventLog::~eventLog() {
+  delete[] buffers;
+  if (f!=NULL) fclose(f);
+}
+
+void eventLog::collect(world* w, bool last) {
+  for (int i=0; i<thread_count; i++) {
+    std::vector<transmissionEvent>& b = buffers[i].events;
+    if (b.size()>0) {
+      chunk.insert(chunk.end(),b.begin(),b.end());
+      no_events+=b.size();
+      b.clear();
+    }
+  }
+  if ((chunk.size()>=EVENT_CHUNK) || ((last) && (chunk.size()>0))) {
+    if ((f!=NULL) && (w->writer!=NULL)) {
+      writerJob* job = w->writer->claim(JOB_EVENTS);
+      job->events.swap(chunk);               // The writer's emptied vector comes back, capacity and all
+      w->writer->submit(job);
+      chunks++;
+    }
+    chunk.clear();
+  }
+}
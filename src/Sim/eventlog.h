@@ -0,0 +1,91 @@
+/* eventlog.h, part of the Global Epidemic Simulation v1.0 BETA
+/* Optional per-thread log of who infected whom
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <stdio.h>
+#include <vector>
+#include "simINT64.h"
+
+#define EVENT_SEED 0           // Settings. Seeded infection - no infector
+#define EVENT_HOUSEHOLD 1
+#define EVENT_PLACE 2          // place_type says which
+#define EVENT_COMMUNITY 3
+#define EVENT_TRAVEL 4         // A visitor's home-country identity, marked infected when the visit is
+#define EVENT_NO_INFECTOR -1   // Seeded, or the infector is on another node (infector_node says which)
+
+#define EVENT_CHUNK 65536      // Events gathered before a chunk is handed to the writer thread
+#define EVENT_MAGIC "GESEVNT1"
+
+class world;
+
+// A person is identified by their home patch and their index in that patch's people:
+// (((y/20)*2160+(x/20))<<32) + index, where x,y are the patch's landscan indices (0..43199, 0..21599) - so the
+// high half is the patch's cell in the 2160x1080 grid of 20x20 landscan patches. To decode, with cell = id>>32:
+// x = (cell%2160)*20, y = (cell/2160)*20, index = id & 0xFFFFFFFF. Stable for a given input set (and /noreorder or not).
+
+struct transmissionEvent {     // 32 bytes
+  SIM_I64 infector;
+  SIM_I64 infectee;
+  float t;                     // Time of the contact (hours)
+  int unit;                    // Infectee's unit
+  unsigned char setting;
+  unsigned char place_type;
+  unsigned short infector_node;
+  int reserved;
+};
+
+struct eventBuffer {           // One per thread, each on its own cache lines
+  std::vector<transmissionEvent> events;
+  char pad[64-sizeof(std::vector<transmissionEvent>)];
+};
+
+class eventLog {
+  public:
+    eventLog(world* w, const char* file);
+    ~eventLog();
+
+    inline void add(int thread_no, SIM_I64 infector, unsigned short infector_node, SIM_I64 infectee, int unit,
+                    float t, unsigned char setting, unsigned char place_type) {
+      transmissionEvent e;
+      e.infector=infector;
+      e.infectee=infectee;
+      e.t=t;
+      e.unit=unit;
+      e.setting=setting;
+      e.place_type=place_type;
+      e.infector_node=infector_node;
+      e.reserved=0;
+      buffers[thread_no].events.push_back(e);
+    }
+
+    void collect(world* w, bool last);  // Master thread, end of timestep: gather the threads' events, and pass a full chunk on
+
+    FILE* f;
+    SIM_I64 no_events;
+
+  private:
+    eventBuffer* buffers;
+    int thread_count;
+    std::vector<transmissionEvent> chunk;
+    int chunks;
+};
+
+#endif
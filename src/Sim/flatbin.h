@@ -0,0 +1,343 @@
+/* flatbin.h, part of the Global Epidemic Simulation v1.0 BETA
+/* Binary columnar flat file - format and memory-mapped reader
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#ifndef FLATBIN_H
+#define FLATBIN_H
+
+// The binary flat file (/ffbin:file) holds the same rows as the text flat file, a block per timestep:
+//
+//   flatbinHeader
+//   for each timestep with any rows:  flatbinBlock, then no_columns columns of no_rows ints each -
+//                                     unit, contact makers, comm cases, hh cases, place cases[no_place_types],
+//                                     comm infs, hh infs, place infs[no_place_types], current sympt, current non-sympt
+//   (padding to 8 bytes)
+//   flatbinStep[no_blocks]            timestep index: T, rows and file offset of each block, in T order
+//   int[no_units+1]                   unit index: runs of unit u are unit_runs[run_start[u]..run_start[u+1]-1]
+//   flatbinRun[no_runs]               ...each a run of consecutive blocks in which the unit has a row
+//   flatbinTrailer
+//
+// Rows within a block are in unit order, as in the text file, so a unit's row in a block is found by binary search
+// of the unit column. Everything is little-endian ints, laid out so the file can be mapped and used in place.
+// The index is written when the run finishes; a file without a valid trailer is incomplete.
+
+#include <stdio.h>
+#include <string.h>
+
+#define FLATBIN_MAGIC "GESFLAT1"
+#define FLATBIN_END "GESFEND1"
+#define FLATBIN_VERSION 1
+
+struct flatbinHeader {
+  char magic[8];
+  int version;
+  int no_place_types;
+  int no_columns;           // 8+(2*no_place_types)
+  int no_units;             // Units in the simulation - the size of the unit index
+  int reserved[2];
+};
+
+struct flatbinBlock {
+  int T;
+  int no_rows;
+};
+
+struct flatbinStep {
+  int T;
+  int no_rows;
+  long long offset;         // Of the flatbinBlock
+};
+
+struct flatbinRun {
+  int first_block;
+  int no_blocks;
+};
+
+struct flatbinTrailer {
+  long long steps_at;       // File offsets of the timestep index, the unit run starts and the runs
+  long long run_start_at;
+  long long runs_at;
+  int no_blocks;
+  int no_runs;
+  char magic[8];
+};
+
+inline int flatbinColumns(int no_place_types) { return 8+(2*no_place_types); }
+
+// The sharded file (/ffmpi:file, see shardout.cpp) has a fixed layout instead, so every rank can write its own
+// units' rows into it at once:
+//
+//   flatbinShardHeader
+//   int[no_ranks+1]                   unit_start: rank r writes units unit_start[r]..unit_start[r+1]-1
+//   unsigned char[no_units]           1 if the unit is logged (the text flat file only has rows for these)
+//   (padding to data_at)
+//   for each timestep s, at data_at+(s*step_bytes):   no_units rows of flatbinColumns() ints, in unit order
+//
+// Every unit has a row every timestep, zeros included, so unit u at timestep s (T=s*timestep_hours) is at
+// data_at+(s*step_bytes)+(u*row_bytes). Contact makers are summed over all ranks here; the text and binary flat
+// files have rank 0's.
+
+#define FLATBIN_SHARD_MAGIC "GESSHRD1"
+#define FLATBIN_SHARD_ALIGN 4096  // data_at is a multiple of this
+
+struct flatbinShardHeader {
+  char magic[8];
+  int version;
+  int no_place_types;
+  int no_columns;
+  int no_units;
+  int no_ranks;
+  int timestep_hours;
+  int no_steps;             // Filled in at the end of the run. 0 = didn't finish - then the file size says how many.
+  int row_bytes;
+  long long step_bytes;
+  long long data_at;
+};
+
+#ifndef FLATBIN_FORMAT_ONLY      // The simulator only writes the format; the reader is for the FlatBin tool
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+// Read-only mapping of a whole file, shared by the readers below
+
+class flatbinMap {
+  public:
+    const char* error;
+
+    flatbinMap() {
+      base=NULL;
+      size=0;
+      error="";
+      #ifdef _WIN32
+        fh=INVALID_HANDLE_VALUE;
+        mh=NULL;
+      #else
+        fd=-1;
+      #endif
+    }
+
+    ~flatbinMap() { unmap(); }
+
+  protected:
+    bool map(const char* file, long long min_size) {
+      unmap();
+      #ifdef _WIN32
+        fh=CreateFileA(file,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+        if (fh==INVALID_HANDLE_VALUE) return fail("can't open file");
+        LARGE_INTEGER li;
+        GetFileSizeEx(fh,&li);
+        size=li.QuadPart;
+        if (size<min_size) return fail("file too short");
+        mh=CreateFileMappingA(fh,NULL,PAGE_READONLY,0,0,NULL);
+        if (mh==NULL) return fail("can't map file");
+        base=(const char*) MapViewOfFile(mh,FILE_MAP_READ,0,0,0);
+      #else
+        fd=::open(file,O_RDONLY);
+        if (fd<0) return fail("can't open file");
+        struct stat st;
+        fstat(fd,&st);
+        size=st.st_size;
+        if (size<min_size) return fail("file too short");
+        void* m=mmap(NULL,size,PROT_READ,MAP_SHARED,fd,0);
+        base=(m==MAP_FAILED)?NULL:(const char*) m;
+      #endif
+      if (base==NULL) return fail("can't map file");
+      return true;
+    }
+
+    void unmap() {
+      #ifdef _WIN32
+        if (base!=NULL) UnmapViewOfFile(base);
+        if (mh!=NULL) CloseHandle(mh);
+        if (fh!=INVALID_HANDLE_VALUE) CloseHandle(fh);
+        fh=INVALID_HANDLE_VALUE;
+        mh=NULL;
+      #else
+        if (base!=NULL) munmap((void*) base,size);
+        if (fd>=0) ::close(fd);
+        fd=-1;
+      #endif
+      base=NULL;
+      size=0;
+    }
+
+    bool fail(const char* why) {
+      error=why;
+      unmap();
+      return false;
+    }
+
+    const char* base;
+    long long size;
+
+  private:
+    #ifdef _WIN32
+      HANDLE fh;
+      HANDLE mh;
+    #else
+      int fd;
+    #endif
+};
+
+// Read-only view of a binary flat file. Nothing is read up front beyond the header and trailer - the timestep
+// index is binary-searched, and a unit's series touches only the pages holding its rows.
+
+class flatbinFile : public flatbinMap {
+  public:
+    flatbinHeader header;
+    flatbinTrailer trailer;
+
+    // Map the file and check it is complete. On failure, error says why.
+    bool open(const char* file) {
+      if (!map(file,sizeof(flatbinHeader)+sizeof(flatbinTrailer))) return false;
+      memcpy(&header,base,sizeof(flatbinHeader));
+      memcpy(&trailer,base+size-sizeof(flatbinTrailer),sizeof(flatbinTrailer));
+      if (memcmp(header.magic,FLATBIN_MAGIC,8)!=0) return fail("not a binary flat file");
+      if (header.version!=FLATBIN_VERSION) return fail("unknown version");
+      if (memcmp(trailer.magic,FLATBIN_END,8)!=0) return fail("no index - the run didn't finish");
+      steps=(const flatbinStep*) (base+trailer.steps_at);
+      run_start=(const int*) (base+trailer.run_start_at);
+      runs=(const flatbinRun*) (base+trailer.runs_at);
+      return true;
+    }
+
+    int noBlocks() { return trailer.no_blocks; }
+    int noColumns() { return header.no_columns; }
+    int blockT(int b) { return steps[b].T; }
+    int blockRows(int b) { return steps[b].no_rows; }
+
+    // Block holding timestep T, or -1 if nothing was logged then
+    int findBlock(int T) {
+      int lo=0;
+      int hi=trailer.no_blocks-1;
+      while (lo<=hi) {
+        int mid=(lo+hi)/2;
+        if (steps[mid].T==T) return mid;
+        if (steps[mid].T<T) lo=mid+1; else hi=mid-1;
+      }
+      return -1;
+    }
+
+    // Column c of block b - blockRows(b) ints
+    const int* column(int b, int c) {
+      return (const int*) (base+steps[b].offset+sizeof(flatbinBlock))+((long long) c*steps[b].no_rows);
+    }
+
+    // Row of unit u in block b, or -1
+    int findRow(int b, int u) {
+      const int* units=column(b,0);
+      int lo=0;
+      int hi=steps[b].no_rows-1;
+      while (lo<=hi) {
+        int mid=(lo+hi)/2;
+        if (units[mid]==u) return mid;
+        if (units[mid]<u) lo=mid+1; else hi=mid-1;
+      }
+      return -1;
+    }
+
+    // Copy row r of block b into values[noColumns()]
+    void getRow(int b, int r, int* values) {
+      for (int c=0; c<header.no_columns; c++) values[c]=column(b,c)[r];
+    }
+
+    // Runs of blocks in which unit u has a row - see flatbinRun
+    int noRuns(int u) {
+      if ((u<0) || (u>=header.no_units)) return 0;
+      return run_start[u+1]-run_start[u];
+    }
+    const flatbinRun* unitRuns(int u) { return &runs[run_start[u]]; }
+
+    // Write row r of block b as the text flat file does
+    void printRow(FILE* f, int b, int r) {
+      fprintf(f,"%d",steps[b].T);
+      for (int c=0; c<header.no_columns; c++) fprintf(f,"\t%d",column(b,c)[r]);
+      fprintf(f,"\n");
+    }
+
+  private:
+    const flatbinStep* steps;
+    const int* run_start;
+    const flatbinRun* runs;
+};
+
+// Read-only view of a sharded file
+
+class flatbinShardFile : public flatbinMap {
+  public:
+    flatbinShardHeader header;
+
+    bool open(const char* file) {
+      if (!map(file,sizeof(flatbinShardHeader))) return false;
+      memcpy(&header,base,sizeof(flatbinShardHeader));
+      if (memcmp(header.magic,FLATBIN_SHARD_MAGIC,8)!=0) return fail("not a sharded flat file");
+      if (header.version!=FLATBIN_VERSION) return fail("unknown version");
+      if (size<header.data_at) return fail("file too short");
+      unit_start=(const int*) (base+sizeof(flatbinShardHeader));
+      logged=(const unsigned char*) (unit_start+header.no_ranks+1);
+      no_steps=header.no_steps;
+      if (no_steps==0) no_steps=(int) ((size-header.data_at)/header.step_bytes);
+      return true;
+    }
+
+    int noSteps() { return no_steps; }
+    int noColumns() { return header.no_columns; }
+    int stepT(int s) { return s*header.timestep_hours; }
+    int findStep(int T) {
+      if ((header.timestep_hours<=0) || (T%header.timestep_hours!=0)) return -1;
+      int s=T/header.timestep_hours;
+      return ((s>=0) && (s<no_steps))?s:-1;
+    }
+    int rankStart(int r) { return unit_start[r]; }
+
+    // Row of unit u at timestep s - noColumns() ints
+    const int* row(int s, int u) {
+      return (const int*) (base+header.data_at+(s*header.step_bytes)+((long long) u*header.row_bytes));
+    }
+
+    // Whether the text flat file would have had this row: a logged unit, with something other than contact makers
+    bool wouldLog(int s, int u) {
+      if (!logged[u]) return false;
+      const int* r=row(s,u);
+      for (int c=2; c<header.no_columns; c++) if (r[c]>0) return true;
+      return false;
+    }
+
+    void printRow(FILE* f, int s, int u) {
+      const int* r=row(s,u);
+      fprintf(f,"%d",stepT(s));
+      for (int c=0; c<header.no_columns; c++) fprintf(f,"\t%d",r[c]);
+      fprintf(f,"\n");
+    }
+
+  private:
+    const int* unit_start;
+    const unsigned char* logged;
+    int no_steps;
+};
+
+#endif
+
+#endif
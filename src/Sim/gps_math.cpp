@@ -34,6 +34,28 @@ bool eq(double f1, double f2) {
 
 // Spherical distance between to lat/lon co-ordinates. See Wikipedia!
 
+SIM_I64 hilbertIndex(int order, unsigned int x, unsigned int y) {
+  // Distance of (x,y) along a Hilbert curve filling a 2^order square. Points close on the curve are close in space,
+  // so sorting by this keeps neighbours together in memory.
+  unsigned int n = 1U<<order;
+  SIM_I64 d=0;
+  for (unsigned int s=n/2; s>0; s/=2) {
+    unsigned int rx = ((x & s)>0)?1:0;
+    unsigned int ry = ((y & s)>0)?1:0;
+    d += (SIM_I64) s * (SIM_I64) s * (SIM_I64) ((3*rx)^ry);
+    if (ry==0) {                       // Rotate the quadrant
+      if (rx==1) {
+        x = n-1-x;
+        y = n-1-y;
+      }
+      unsigned int t = x;
+      x = y;
+      y = t;
+    }
+  }
+  return d;
+}
+
 double haversine(double lon1, double lat1, double lon2, double lat2) {
   const double R = 6371.297; // km
   const double PId180 = 3.14159265359/180.0;
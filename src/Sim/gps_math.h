@@ -37,4 +37,5 @@ double landscan_x_distance(int y, int x1, int x2);
 double landscan_y_distance(int x, int y1, int y2);
 double landscan_diagonal_distance(int x1, int y1, int x2, int y2);
 bool eq(double f1, double f2);
+SIM_I64 hilbertIndex(int order, unsigned int x, unsigned int y);
 #endif
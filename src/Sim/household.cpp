@@ -19,11 +19,84 @@
 #include "household.h"
 
 
+#ifdef COMPACT_PEOPLE
+household* household::all=NULL;
+unsigned int household::no_all=0;
+householdWindows* household::window_blocks[MAX_WINDOW_BLOCKS];
+int household::no_windows=0;
+#endif
+
 household::household() {
   unit=-1;
+#ifdef COMPACT_PEOPLE
+  windows=-1;
+#endif
 }
 household::~household() {}
 
+#ifdef COMPACT_PEOPLE
+householdWindows* household::getWindows() {
+  // Households on different threads may need an entry at once. Blocks are never moved or freed during the run,
+  // so readers (getPphStart() etc) need no lock - but 'windows' is only published, with an atomic write, after the
+  // entry and its block have been flushed, and readers flush after an atomic read that finds one. The values
+  // themselves are read and written atomically too.
+  int w_no;
+  #pragma omp atomic read
+  w_no=windows;
+  if (w_no<0) {
+    #pragma omp critical (household_windows)
+    {
+      #pragma omp atomic read
+      w_no=windows;
+      if (w_no<0) {
+        w_no=no_windows;
+        if (w_no%WINDOW_BLOCK==0) {
+          if (w_no/WINDOW_BLOCK>=MAX_WINDOW_BLOCKS) { printf("ERROR - household window table full\n"); fflush(stdout); exit(1); }
+          window_blocks[w_no/WINDOW_BLOCK] = new householdWindows[WINDOW_BLOCK];
+        }
+        householdWindows* hw = &window_blocks[w_no/WINDOW_BLOCK][w_no%WINDOW_BLOCK];
+        hw->pph_start=-1;
+        hw->pph_end=-1;
+        hw->q_start=-1;
+        hw->q_end=-1;
+        no_windows++;
+        #pragma omp flush
+        #pragma omp atomic write
+        windows=w_no;
+      }
+    }
+  }
+  #pragma omp flush
+  return &window_blocks[w_no/WINDOW_BLOCK][w_no%WINDOW_BLOCK];
+}
+
+void household::setProphylaxis(float start, float end) {
+  householdWindows* hw = getWindows();
+  #pragma omp atomic write
+  hw->pph_start=start;
+  #pragma omp atomic write
+  hw->pph_end=end;
+}
+
+void household::setQuarantine(float start, float end) {
+  householdWindows* hw = getWindows();
+  #pragma omp atomic write
+  hw->q_start=start;
+  #pragma omp atomic write
+  hw->q_end=end;
+}
+#else
+void household::setProphylaxis(float start, float end) {
+  pph_start=start;
+  pph_end=end;
+}
+
+void household::setQuarantine(float start, float end) {
+  q_start=start;
+  q_end=end;
+}
+#endif
+
 void household::applyProphylaxis(world* w, int thread_no) {
   for (int i=first_person; i<no_people; i++) {
     if (ranf_mt(thread_no)<w->a_units[unit].pph_household) {
@@ -31,16 +104,16 @@ void household::applyProphylaxis(world* w, int thread_no) {
         w->localPatchList[patch]->people[i].status += PROPHYLAXED;
     } 
   }
-  if ((pph_start<=0) || (w->T>pph_end)) {
-    pph_start=(float) (w->T+(w->a_units[unit].pph_delay*24.0));
-    pph_end=(float) (pph_start+w->T+(w->a_units[unit].pph_duration*24.0));
+  if ((getPphStart()<=0) || (w->T>getPphEnd())) {
+    float start=(float) (w->T+(w->a_units[unit].pph_delay*24.0));
+    setProphylaxis(start,(float) (start+w->T+(w->a_units[unit].pph_duration*24.0)));
   }
 }
 
 void household::applyQuarantine(world* w, int thread_no) {
   if (ranf_mt(thread_no)<w->a_units[unit].q_compliance) {
-    q_start=(float) (w->T+(w->a_units[unit].q_delay*24.0));
-    q_end=(float) (q_start+(w->a_units[unit].q_duration*24.0));
+    float start=(float) (w->T+(w->a_units[unit].q_delay*24.0));
+    setQuarantine(start,(float) (start+(w->a_units[unit].q_duration*24.0)));
   }
 }
 
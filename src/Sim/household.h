@@ -20,29 +20,77 @@
 
 #include "person.h"
 
+#ifdef COMPACT_PEOPLE
+struct householdWindows {      // Prophylaxis and quarantine periods - only for households that have had either.
+  float pph_start;             // Start of prophylaxis (delay included)
+  float pph_end;               // End of prophylax period
+  float q_start;               // Start of quarantine 
+  float q_end;                 // End of quarantine
+};
+
+#define WINDOW_BLOCK 65536     // householdWindows are allocated in blocks of this many, and never move.
+#define MAX_WINDOW_BLOCKS 4096
+#endif
+
 class household {
   public:
     float lat;                 // Latitude of household
     float lon;                 // Longitude of household
-    unsigned char country;     // Country of household
     int unit;                  // index of administrative unit
-    unsigned char no_people;   // No. of people in household
-
     int patch;                 // Index of patch that household is in
     int first_person;          // Index into patch->people of the first person in this household. (They are contiguous)
+    unsigned char country;     // Country of household
+    unsigned char no_people;   // No. of people in household
     char susc_people; // No. of susceptible people in this house. (when zero, don't do household alg).
 
+#ifdef COMPACT_PEOPLE
+    int windows;               // Index into the side table of householdWindows, or -1 if none (most households)
+
+    static household* all;                     // Every household on this node. localPatch::households are slices of it.
+    static unsigned int no_all;
+    static householdWindows* window_blocks[MAX_WINDOW_BLOCKS];
+    static int no_windows;
+
+    inline float windowValue(float householdWindows::* field) {   // -1 if the household has no entry. See getWindows
+      int w_no;
+      #pragma omp atomic read
+      w_no=windows;
+      if (w_no<0) return -1;                   // (Most households - no flush needed)
+      #pragma omp flush
+      float* f=&(window_blocks[w_no/WINDOW_BLOCK][w_no%WINDOW_BLOCK].*field);
+      float v;
+      #pragma omp atomic read
+      v=*f;
+      return v;
+    }
+    inline float getPphStart() { return windowValue(&householdWindows::pph_start); }
+    inline float getPphEnd() { return windowValue(&householdWindows::pph_end); }
+    inline float getQStart() { return windowValue(&householdWindows::q_start); }
+    inline float getQEnd() { return windowValue(&householdWindows::q_end); }
+    householdWindows* getWindows();            // Creates this household's entry if needed
+#else
     float pph_start;           // Start of prophylaxis (delay included)
     float pph_end;             // End of prophylax period
 
     float q_start;             // Start of quarantine 
     float q_end;               // End of quarantine
+
+    inline float getPphStart() { return pph_start; }
+    inline float getPphEnd() { return pph_end; }
+    inline float getQStart() { return q_start; }
+    inline float getQEnd() { return q_end; }
+#endif
     
+    void setProphylaxis(float start, float end);
+    void setQuarantine(float start, float end);
     void applyProphylaxis(world* w, int thread_no);
     void applyQuarantine(world* w, int thread_no);
     household();
     ~household();
     
 };
+
+#define HOUSEHOLD_CLASS_DEFINED
+#include "household_inline.h"
     
 #endif
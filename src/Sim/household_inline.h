@@ -0,0 +1,29 @@
+/* household_inline.h, part of the Global Epidemic Simulation v1.0 BETA
+/* Inline person/household accessors that need both classes to be complete
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+// person.h and household.h include each other, so whichever finishes second defines these.
+
+#if defined(PERSON_CLASS_DEFINED) && defined(HOUSEHOLD_CLASS_DEFINED) && !defined(HOUSEHOLD_INLINE_H)
+#define HOUSEHOLD_INLINE_H
+
+#ifdef COMPACT_PEOPLE
+inline household* person::getHouse() { return &household::all[hh]; }
+inline void person::setHouse(household* h) { hh=(unsigned int) (h-household::all); }
+#endif
+
+#endif
@@ -0,0 +1,199 @@
+/* imagegrid.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Sparse, tiled infection/immunity counts for the movie, and the tile-delta reduction to rank 0
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#include "imagegrid.h"
+#include "world.h"
+
+// The movie shows, for every patch, the fraction of infected or immune people who are immune. Each thread counts its
+// own changes, so the counts are per thread. They used to be [x][y][thread] arrays for the whole globe - 2.3 million
+// tiny allocations, hundreds of MB at 32 threads, mostly ocean - and every node reduced its whole 2.3 MB image on
+// rank 0 every timestep.
+//
+// Now the globe is cut into IMAGE_TILE x IMAGE_TILE tiles, and a tile's counts (all threads) are one allocation,
+// made only for tiles where this node has households. Other tiles are made on first use, which only happens for
+// visitors' homes. update() redraws only the tiles whose counts changed, and gather() sends rank 0 only the tiles
+// whose pixels changed, as differences from what was last sent. The differences are mod 256, so adding them up
+// gives the same wrapped sum of the nodes' images that MPI_SUM of unsigned chars gave. (Some Open MPI builds
+// saturate at 255 instead. Nodes only share a pixel where a visitor's home falls in another node's patches.)
+
+imageGrid::imageGrid(world* w) {
+  thread_count=w->thread_count;
+  tiles = new imageTile*[IMAGE_TILES_X*IMAGE_TILES_Y];
+  list = new int[IMAGE_TILES_X*IMAGE_TILES_Y];
+  dirty = new int[IMAGE_TILES_X*IMAGE_TILES_Y];
+  for (int i=0; i<IMAGE_TILES_X*IMAGE_TILES_Y; i++) tiles[i]=NULL;
+  no_tiles=0;
+  no_dirty=0;
+  image = new unsigned char[PNG_WIDTH*PNG_HEIGHT];
+  memset(image,0,PNG_WIDTH*PNG_HEIGHT);
+  frame=NULL;
+  if (w->mpi_rank==0) {
+    frame = new unsigned char[PNG_WIDTH*PNG_HEIGHT];
+    memset(frame,0,PNG_WIDTH*PNG_HEIGHT);
+  }
+  counts_in = new int[w->mpi_size];
+  displs_in = new int[w->mpi_size];
+  gathers=0;
+  bytes_sent=0;
+
+  for (unsigned int i=0; i<w->noLocalPatches; i++) {
+    localPatch* lp = w->localPatchList[i];
+    for (int j=0; j<lp->no_households; j++) {
+      const int x = lonToLsIndex(lp->households[j].lon)/(43200/PNG_WIDTH);
+      const int y = latToLsIndex(lp->households[j].lat)/(21600/PNG_HEIGHT);
+      if ((x>=0) && (x<PNG_WIDTH) && (y>=0) && (y<PNG_HEIGHT)) {
+        int tile = ((y/IMAGE_TILE)*IMAGE_TILES_X)+(x/IMAGE_TILE);
+        if (tiles[tile]==NULL) allocate(tile);
+      }
+    }
+  }
+}
+
+imageGrid::~imageGrid() {
+  for (int i=0; i<no_tiles; i++) {
+    delete[] tiles[list[i]]->counts;
+    delete[] tiles[list[i]]->sent;
+    delete tiles[list[i]];
+  }
+  delete[] tiles;
+  delete[] list;
+  delete[] dirty;
+  delete[] image;
+  delete[] frame;
+  delete[] counts_in;
+  delete[] displs_in;
+}
+
+void imageGrid::allocate(int tile) {
+  #pragma omp critical (image_tile)
+  {
+  if (tiles[tile]==NULL) {
+    imageTile* t = new imageTile;
+    t->counts = new int[thread_count*2*IMAGE_TILE_PIXELS];
+    memset(t->counts,0,thread_count*2*IMAGE_TILE_PIXELS*sizeof(int));
+    t->sent = new unsigned char[IMAGE_TILE_PIXELS];
+    memset(t->sent,0,IMAGE_TILE_PIXELS);
+    t->dirty=0;
+    t->pending=0;
+    list[no_tiles++]=tile;
+    #pragma omp flush
+    tiles[tile]=t;
+  }
+  }
+}
+
+void imageGrid::update(world* w) {
+  int i;
+  #pragma omp single
+  {
+  no_dirty=0;
+  for (i=0; i<no_tiles; i++)
+    if (tiles[list[i]]->dirty) dirty[no_dirty++]=list[i];
+  }
+
+  #pragma omp for schedule(dynamic,4)
+  for (i=0; i<no_dirty; i++) {
+    imageTile* t = tiles[dirty[i]];
+    int inf[IMAGE_TILE_PIXELS];
+    int imm[IMAGE_TILE_PIXELS];
+    t->dirty=0;
+    t->pending=1;
+    memset(inf,0,sizeof(inf));
+    memset(imm,0,sizeof(imm));
+    for (int z=0; z<thread_count; z++) {
+      const int* c = &t->counts[z*2*IMAGE_TILE_PIXELS];
+      for (int px=0; px<IMAGE_TILE_PIXELS; px++) {
+        inf[px]+=c[px];
+        imm[px]+=c[IMAGE_TILE_PIXELS+px];
+      }
+    }
+    unsigned char* row = &image[((dirty[i]/IMAGE_TILES_X)*IMAGE_TILE*PNG_WIDTH)+((dirty[i]%IMAGE_TILES_X)*IMAGE_TILE)];
+    for (int px=0; px<IMAGE_TILE_PIXELS; px++) {
+      unsigned char val=0;
+      if (inf[px]+imm[px]!=0) val = (unsigned char) (1+(254.0*((float)imm[px]/(imm[px]+inf[px]))));
+      row[((px/IMAGE_TILE)*PNG_WIDTH)+(px%IMAGE_TILE)]=val;
+    }
+  }
+}
+
+static void addTiles(unsigned char* frame, unsigned char* msg, int bytes) {
+  for (int pos=0; pos<bytes; pos+=IMAGE_TILE_MSG) {
+    int tile = *(int*) &msg[pos];
+    unsigned char* delta = &msg[pos+sizeof(int)];
+    unsigned char* row = &frame[((tile/IMAGE_TILES_X)*IMAGE_TILE*PNG_WIDTH)+((tile%IMAGE_TILES_X)*IMAGE_TILE)];
+    for (int px=0; px<IMAGE_TILE_PIXELS; px++) row[((px/IMAGE_TILE)*PNG_WIDTH)+(px%IMAGE_TILE)]+=delta[px];
+  }
+}
+
+void imageGrid::gather(world* w) {
+  msg_out.resize((no_tiles+1)*IMAGE_TILE_MSG);
+  int bytes=0;
+  for (int i=0; i<no_tiles; i++) {
+    imageTile* t = tiles[list[i]];
+    if (!t->pending) continue;
+    t->pending=0;
+    unsigned char* row = &image[((list[i]/IMAGE_TILES_X)*IMAGE_TILE*PNG_WIDTH)+((list[i]%IMAGE_TILES_X)*IMAGE_TILE)];
+    unsigned char* delta = &msg_out[bytes+sizeof(int)];
+    bool changed=false;
+    for (int px=0; px<IMAGE_TILE_PIXELS; px++) {
+      unsigned char val = row[((px/IMAGE_TILE)*PNG_WIDTH)+(px%IMAGE_TILE)];
+      delta[px] = (unsigned char) (val-t->sent[px]);
+      if (delta[px]!=0) changed=true;
+      t->sent[px]=val;
+    }
+    if (changed) {
+      *(int*) &msg_out[bytes]=list[i];
+      bytes+=IMAGE_TILE_MSG;
+    }
+  }
+  gathers++;
+  bytes_sent+=bytes;
+
+#ifdef _USEMPI
+  MPI_Gather(&bytes,1,MPI_INT,counts_in,1,MPI_INT,0,MPI_COMM_WORLD);
+  int total=0;
+  if (w->mpi_rank==0) {
+    for (int r=0; r<w->mpi_size; r++) {
+      displs_in[r]=total;
+      total+=counts_in[r];
+    }
+    msg_in.resize(total+1);
+  }
+  MPI_Gatherv(&msg_out[0],bytes,MPI_UNSIGNED_CHAR,(w->mpi_rank==0)?&msg_in[0]:NULL,counts_in,displs_in,MPI_UNSIGNED_CHAR,0,MPI_COMM_WORLD);
+  if (w->mpi_rank==0) addTiles(frame,&msg_in[0],total);
+#else
+  addTiles(frame,&msg_out[0],bytes);
+#endif
+}
+
+long long imageGrid::memoryBytes() {
+  long long bytes = no_tiles*(long long) (sizeof(imageTile)+(thread_count*2*IMAGE_TILE_PIXELS*sizeof(int))+IMAGE_TILE_PIXELS);
+  bytes+=IMAGE_TILES_X*IMAGE_TILES_Y*(sizeof(imageTile*)+(2*sizeof(int)));   // tiles, list and dirty
+  bytes+=PNG_WIDTH*PNG_HEIGHT;                                                // image
+  if (frame!=NULL) bytes+=PNG_WIDTH*PNG_HEIGHT;                               // frame
+  bytes+=msg_out.capacity()+msg_in.capacity();
+  return bytes;
+}
+
+void imageGrid::report(world* w) {
+  printf("%d: Movie: %d image tiles (%.1f MB of counts), %.1f KB of changed tiles sent per frame (the full frame is %d KB)\n",
+         w->mpi_rank,no_tiles,(no_tiles*(thread_count*2.0*IMAGE_TILE_PIXELS*sizeof(int)+IMAGE_TILE_PIXELS))/1048576.0,
+         (gathers>0)?(bytes_sent/1024.0)/gathers:0.0,(PNG_WIDTH*PNG_HEIGHT)/1024);
+  fflush(stdout);
+}
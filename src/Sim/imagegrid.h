@@ -0,0 +1,87 @@
+/* imagegrid.h, part of the Global Epidemic Simulation v1.0 BETA
+/* Sparse, tiled infection/immunity counts for the movie, and the tile-delta reduction to rank 0
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#ifndef IMAGEGRID_H
+#define IMAGEGRID_H
+
+#include <stddef.h>
+#include <vector>
+
+#define PNG_WIDTH 2160
+#define PNG_HEIGHT 1080
+
+#define IMAGE_TILE 20                                   // Tiles are IMAGE_TILE x IMAGE_TILE pixels (a pixel is one patch)
+#define IMAGE_TILE_PIXELS (IMAGE_TILE*IMAGE_TILE)
+#define IMAGE_TILES_X (PNG_WIDTH/IMAGE_TILE)
+#define IMAGE_TILES_Y (PNG_HEIGHT/IMAGE_TILE)
+#define IMAGE_TILE_MSG (sizeof(int)+IMAGE_TILE_PIXELS)  // Tile index, then a byte per pixel
+
+class world;
+
+struct imageTile {
+  int* counts;                 // [thread][infected, immune][pixel] - each thread's counts are contiguous
+  unsigned char* sent;         // This node's pixels as rank 0 last saw them
+  int dirty;                   // A count changed since update()
+  int pending;                 // update() redrew the tile since gather()
+};
+
+class imageGrid {
+  public:
+    imageGrid(world* w);
+    ~imageGrid();
+
+    inline void add(int x, int y, int thread_no, int delta_inf, int delta_imm) {
+      int tile = ((y/IMAGE_TILE)*IMAGE_TILES_X)+(x/IMAGE_TILE);
+      if (tiles[tile]==NULL) allocate(tile);             // Only for households outside this node's patches
+      imageTile* t = tiles[tile];
+      int* c = &t->counts[thread_no*2*IMAGE_TILE_PIXELS];
+      int px = ((y%IMAGE_TILE)*IMAGE_TILE)+(x%IMAGE_TILE);
+      c[px]+=delta_inf;
+      c[IMAGE_TILE_PIXELS+px]+=delta_imm;
+      t->dirty=1;
+    }
+
+    void update(world* w);     // Whole team: redraw this node's image where counts changed
+    void gather(world* w);     // Master, every node: send the changed tiles to rank 0, which adds them into frame
+    void report(world* w);
+    long long memoryBytes();   // Everything allocated here, for reportMemory
+
+    unsigned char* image;      // This node's own image
+    unsigned char* frame;      // Rank 0: every node's image summed, as the movie shows it
+
+  private:
+    void allocate(int tile);
+
+    int thread_count;
+    imageTile** tiles;         // [IMAGE_TILES_Y*IMAGE_TILES_X], NULL where this node has no-one
+    int* list;                 // Indexes of the allocated tiles
+    int no_tiles;
+    int* dirty;                // update()'s work list
+    int no_dirty;
+
+    std::vector<unsigned char> msg_out;
+    std::vector<unsigned char> msg_in;
+    int* counts_in;
+    int* displs_in;
+
+    int gathers;
+    long long bytes_sent;
+};
+
+#endif
@@ -17,6 +17,7 @@
 */
 
 #include "initialise.h"
+#include <algorithm>
 
 void clearBuffer(world* w) {
   w->buffer_pointer=0;
@@ -69,17 +70,31 @@ void loadOverlay(world *w, char *file) {
     }
   }
   fclose(f);
+#ifdef COMPACT_PEOPLE
+  // People refer to households by a 32-bit index into one node-wide array, so allocate that, and give each patch a slice.
+  SIM_I64 total_households=0;
   for (int i=0; i<2160; i++) {
     for (int j=0; j<1080; j++) {
-      if (w->localPatchLookup[i][j]>=0) {
-        p=w->localPatchList[w->localPatchLookup[i][j]];
-        p->households = new household[w->localPatchList[w->localPatchLookup[i][j]]->no_households];
-        p->people = new person[w->localPatchList[w->localPatchLookup[i][j]]->no_people];
-        p->no_people=0;
-        p->no_households=0;
-      }
+      if (w->localPatchLookup[i][j]>=0) total_households+=w->localPatchList[w->localPatchLookup[i][j]]->no_households;
     }
   }
+  if (total_households>=(SIM_I64) 0xFFFFFFFFL) { printf("%d: ERROR - too many households on this node for 32-bit indexes\n",w->mpi_rank); fflush(stdout); exit(1); }
+  household::no_all=(unsigned int) total_households;
+  household::all = new household[household::no_all];
+  total_households=0;
+#endif
+  for (unsigned int i=0; i<w->noLocalPatches; i++) {     // In localPatchList order, so the household slices follow it
+    p=w->localPatchList[i];
+#ifdef COMPACT_PEOPLE
+    p->households = &household::all[total_households];
+    total_households+=p->no_households;
+#else
+    p->households = new household[p->no_households];
+#endif
+    p->people = new person[p->no_people];
+    p->no_people=0;
+    p->no_households=0;
+  }
   errline=1165;
 }
 
@@ -187,21 +202,35 @@ void loadHouseholdFile(world *w,  char* file, unsigned char country, int**** tpg
 
       for (j=0; j<hosts_in_household; j++) {
         person *p = &w->localPatchList[the_patch]->people[w->localPatchList[the_patch]->no_people];
-        p->house=h;
-        read(f,1,(char*)&p->age,w); // DUMMY - age index group
-        read(f,4,(char*)&p->age,w); // Actual age (Float)
+        p->setHouse(h);
+        read(f,1,(char*)&age,w); // DUMMY - age index group
+        read(f,4,(char*)&age,w); // Actual age (Float)
         int k=0;
-        while ((k<w->no_age_bands-1) && (w->max_age_band[k]<p->age)) k++;
+        while ((k<w->no_age_bands-1) && (w->max_age_band[k]<age)) k++;
+#ifdef COMPACT_PEOPLE
+        p->age_band=k;
+#else
+        p->age=age;
         p->susceptibility=(float)w->init_susceptibility[k];
+#endif
         read(f,2,(char*)&place_type,w);
+#ifdef COMPACT_PEOPLE
+        p->place_type = (place_type<PLACE_TYPE_NONE)?place_type:PLACE_TYPE_NONE;
+#else
         p->place_type = (unsigned char) place_type;
+#endif
         read(f,4,(char*)&p->place,w);
-        read(f,2,(char*)&p->group,w);
+        read(f,2,(char*)&group,w);
+        p->group=group;
 
         if (p->place_type<w->P->no_place_types) {
           tot[p->place_type]++;
           if (p->place<w->no_places[country][p->place_type]) {
-            if (p->group==65535) p->group=w->places[country][p->place_type].at(p->place)->no_groups-1;
+            if (group==65535) group=w->places[country][p->place_type].at(p->place)->no_groups-1;
+#ifdef COMPACT_PEOPLE
+            if (group>=MAX_GROUPS) { printf("%d: ERROR - group %d too large for compact person\n",w->mpi_rank,group); fflush(stdout); exit(1); }
+#endif
+            p->group=group;
             tpgn[p->place_type][p->place][p->group][w->mpi_rank]++;
             
           } else 
@@ -273,11 +302,15 @@ void loadHouseholdFile(world *w,  char* file, unsigned char country, int**** tpg
 void linkPeopleToEstablishments(world* w, int country, int**** tpgn) {
   errline=11279;
   for (unsigned int i=0; i<w->P->no_place_types; i++) {
-    for (unsigned int j=0; j<w->no_places[country][i]; j++) {
-      place* p = w->places[country][i].at(j);
-      p->group_member_count=new unsigned int[p->no_groups];
-      for (unsigned int m=0; m<p->no_groups; m++) p->group_member_count[m]=0;
+    placeList* pl = &w->places[country][i];
+
+    // First pass - check totals, count nodes, and size the flattened arrays.
 
+    unsigned int no_node_counts=0;
+    unsigned int no_members=0;
+    pl->no_groups=0;
+    for (unsigned int j=0; j<w->no_places[country][i]; j++) {
+      place* p = pl->at(j);
       unsigned int total=0;
       for (int m=0; m<w->mpi_size; m++) {
         for (unsigned int k=0; k<p->no_groups; k++) {
@@ -290,7 +323,6 @@ void linkPeopleToEstablishments(world* w, int country, int**** tpgn) {
         p->total_hosts=total;
       }
 
-      
       p->no_nodes=0;
       for (int m=0; m<w->mpi_size; m++) {
         for (unsigned int k=0; k<p->no_groups; k++) {
@@ -300,27 +332,48 @@ void linkPeopleToEstablishments(world* w, int country, int**** tpgn) {
           }
         }
       }
-
-      p->group_member_node_count = new unsigned int*[p->no_groups];
       if (p->no_nodes>1) p->no_nodes=w->mpi_size;
-      for (unsigned int m=0; m<p->no_groups; m++) {
-        p->group_member_node_count[m]=new unsigned int[p->no_nodes];
-      }
 
+      p->first_group=pl->no_groups;
+      p->first_node_count=no_node_counts;
+      pl->no_groups+=p->no_groups;
+      no_node_counts+=p->no_groups*p->no_nodes;
+      for (unsigned int k=0; k<p->no_groups; k++) no_members+=tpgn[i][j][k][w->mpi_rank];
+    }
+
+    pl->group_member_count = new unsigned int[pl->no_groups];
+    pl->group_first_host = new unsigned int[pl->no_groups];
+    pl->node_first_host = new unsigned int[no_node_counts];
+    pl->member_start = new unsigned int[pl->no_groups+1];
+    pl->members = new person*[no_members];
+
+    // Second pass - fill in the counts. member_start is filled in as a running offset, and used as the
+    // cursor for adding people below; it is shifted back into place afterwards.
+
+    unsigned int member_offset=0;
+    for (unsigned int j=0; j<w->no_places[country][i]; j++) {
+      place* p = pl->at(j);
+      unsigned int first_host=0;
       for (unsigned int k=0; k<p->no_groups; k++) {
-        p->local_members[k]=new person*[tpgn[i][j][k][w->mpi_rank]];
+        unsigned int g=p->first_group+k;
+        pl->group_member_count[g]=0;
+        for (int m=0; m<w->mpi_size; m++) pl->group_member_count[g]+=tpgn[i][j][k][m];
+        pl->group_first_host[g]=first_host;
+        first_host+=pl->group_member_count[g];
         if (p->no_nodes==1) {
-          p->group_member_node_count[k][0]=0;   // Use as counter
-          p->group_member_count[k]+=tpgn[i][j][k][w->mpi_rank];
-        } else {
+          pl->node_first_host[p->first_node_count+k]=pl->group_first_host[g];
+        } else if (p->no_nodes>1) {
+          unsigned int node_first=pl->group_first_host[g];
           for (int m=0; m<w->mpi_size; m++) {
-            p->group_member_count[k]+=tpgn[i][j][k][m];
-            if (m==w->mpi_rank) p->group_member_node_count[k][m]=0;    // Use as counter
-            else p->group_member_node_count[k][m]=tpgn[i][j][k][m];    // Use the value - nothing to count.
+            pl->node_first_host[p->first_node_count+(k*p->no_nodes)+m]=node_first;
+            node_first+=tpgn[i][j][k][m];
           }
         }
+        pl->member_start[g]=member_offset;
+        member_offset+=tpgn[i][j][k][w->mpi_rank];
       }
     }
+    pl->member_start[pl->no_groups]=member_offset;
   }
   
   
@@ -331,24 +384,24 @@ void linkPeopleToEstablishments(world* w, int country, int**** tpgn) {
           
       for (unsigned char k=0; k<lp->households[j].no_people; k++) {
         person* p = &lp->people[lp->households[j].first_person+k];
-        if (p->house->country==country) {
+        if (p->getHouse()->country==country) {
           if (p->place_type<w->P->no_place_types) {
             if (p->place<w->no_places[country][p->place_type]) {
-              place* e = w->places[country][p->place_type].at(p->place);
-              if (e->no_nodes==1) {
-                e->local_members[p->group][e->group_member_node_count[p->group][0]++]=p;
-     
-              } else if (e->no_nodes>1) {
-                
-                e->local_members[p->group][e->group_member_node_count[p->group][w->mpi_rank]++]=p;
-
-              }
+              placeList* pl = &w->places[country][p->place_type];
+              place* e = pl->at(p->place);
+              pl->members[pl->member_start[e->first_group+p->group]++]=p;
             }
           } 
         }
       }
     }
   }
+
+  for (unsigned int i=0; i<w->P->no_place_types; i++) {    // Each group's cursor has moved to the start of the next group.
+    placeList* pl = &w->places[country][i];
+    for (unsigned int g=pl->no_groups; g>0; g--) pl->member_start[g]=pl->member_start[g-1];
+    pl->member_start[0]=0;
+  }
   errline=11357;
 }
 
@@ -362,8 +415,9 @@ void loadPlaces(world *w,char* file,unsigned char country,unsigned char place_ty
   FILE* f = fopen(&file[0],"rb");
   read(f,2,(char*)&dummy2,w);  // ID of file. (should == place_type)
   read(f,4,(char*)&w->no_places[country][place_type],w);
+  w->places[country][place_type].allocate(w->no_places[country][place_type]);
   for (unsigned int i=0; i<w->no_places[country][place_type]; i++) {
-    place* e = new place();
+    place* e = w->places[country][place_type].at(i);
     e->country=country;
     read(f,8,(char*)&e->lat,w);
     read(f,8,(char*)&e->lon,w);
@@ -372,9 +426,6 @@ void loadPlaces(world *w,char* file,unsigned char country,unsigned char place_ty
     e->no_groups+=2;                    // So no. groups = +1, then +1 for extra "65535" meaning staff/no group.
     read(f,4,(char*)&e->unit,w);
     errline=11381;
-    e->local_members = new person**[e->no_groups];
-    w->places[country][place_type].push_back(e);
-    errline=11384;  
   }      
   fclose(f);
 }
@@ -531,9 +582,101 @@ void loadPatches(world *w) {
   }
   read(iniFile,4,(char*)&x,w);    // This should be a -1
   fclose(iniFile);
+
+  if (w->reorder_population) {
+    // Renumber local patches along a Hilbert curve through their positions, so patches that are close in space
+    // (and the households that loadOverlay allocates for them) are close in memory.
+    SIM_I64* keys = new SIM_I64[w->noLocalPatches];
+    localPatch** file_order = new localPatch*[w->noLocalPatches];
+    for (unsigned int i=0; i<w->noLocalPatches; i++) {
+      file_order[i]=w->localPatchList[i];
+      keys[i]=(hilbertIndex(12,file_order[i]->x/20,file_order[i]->y/20)<<31) | (SIM_I64) i;   // Key, then old index
+    }
+    std::sort(keys,keys+w->noLocalPatches);
+    for (unsigned int i=0; i<w->noLocalPatches; i++) {
+      localPatch* p = file_order[keys[i] & 0x7FFFFFFF];
+      w->localPatchList[i]=p;
+      pi_d20=p->x/20;
+      pj_d20=p->y/20;
+      if ((pi_d20>=0) && (pi_d20<2160) && (pj_d20>=0) && (pj_d20<1080)) w->localPatchLookup[pi_d20][pj_d20]=i;
+    }
+    delete[] keys;
+    delete[] file_order;
+  }
   errline=11544;
 }
 
+unsigned int hilbertCoord(double f) {
+  // Quantise f in [0,1] to the 16-bit grid used for household keys.
+  if (f<=0) return 0;
+  if (f>=1) return 65535;
+  return (unsigned int) (f*65535.0);
+}
+
+void reorderPopulation(world* w) {
+  // Sort each local patch's households along a Hilbert curve through their lat/lon, and lay the people out again in
+  // the new household order. Neighbouring households share places and infect each other, so this keeps the people
+  // touched together on the same cache lines and pages. Everything that refers to people by address or index
+  // (house, first_person, place members) is fixed up. The old people arrays are kept until the places are done,
+  // because an old person still leads (via its house) to its patch, and hence to its new index.
+  errline=11546;
+  person** new_people = new person*[w->noLocalPatches];
+  int** new_index = new int*[w->noLocalPatches];       // [patch][old person index] = new person index
+
+  for (unsigned int i=0; i<w->noLocalPatches; i++) {
+    localPatch* lp = w->localPatchList[i];
+    new_people[i] = new person[lp->no_people];
+    new_index[i] = new int[lp->no_people];
+    if (lp->no_households==0) continue;
+
+    SIM_I64* keys = new SIM_I64[lp->no_households];
+    household* file_order = new household[lp->no_households];
+    for (int j=0; j<lp->no_households; j++) {
+      household* h = &lp->households[j];
+      keys[j]=(hilbertIndex(16,hilbertCoord((h->lon+180.0)/360.0),hilbertCoord((90.0-h->lat)/180.0))<<31) | (SIM_I64) j;
+      file_order[j]=*h;
+    }
+    std::sort(keys,keys+lp->no_households);
+
+    int next=0;
+    for (int j=0; j<lp->no_households; j++) {
+      household* h = &lp->households[j];
+      *h=file_order[keys[j] & 0x7FFFFFFF];
+      for (int k=0; k<h->no_people; k++) {
+        new_index[i][h->first_person+k]=next;
+        new_people[i][next]=lp->people[h->first_person+k];
+        new_people[i][next].setHouse(h);
+        next++;
+      }
+      h->first_person=next-h->no_people;
+    }
+    delete[] keys;
+    delete[] file_order;
+  }
+
+  errline=11547;
+  for (int c=0; c<w->no_countries; c++) {
+    for (unsigned int t=0; t<w->P->no_place_types; t++) {
+      placeList* pl = &w->places[c][t];
+      if (pl->member_start==NULL) continue;          // Country not loaded on this node
+      for (unsigned int m=0; m<pl->member_start[pl->no_groups]; m++) {
+        person* p = pl->members[m];
+        int pa = p->getHouse()->patch;
+        pl->members[m]=&new_people[pa][new_index[pa][p-w->localPatchList[pa]->people]];
+      }
+    }
+  }
+
+  for (unsigned int i=0; i<w->noLocalPatches; i++) {
+    delete[] w->localPatchList[i]->people;
+    w->localPatchList[i]->people=new_people[i];
+    delete[] new_index[i];
+  }
+  delete[] new_people;
+  delete[] new_index;
+  errline=11548;
+}
+
 void calculateQ(world* w) {
   errline=11548;
   int thread_no;
@@ -560,7 +703,7 @@ void calculateQ(world* w) {
       
         for (k_prime=0; k_prime<w->totalPatches; k_prime++) {
     	  p_kprime=w->allPatchList[k_prime];
-          q_temp=(unit::kernel_F(&w->a_units[p_klocal->households[0].unit],patch::distance(p_k,p_kprime))*w->patch_populations[k_prime]);
+          q_temp=(unitHot::kernel_F(&w->unit_hot[p_klocal->households[0].unit],patch::distance(p_k,p_kprime))*w->patch_populations[k_prime]);
           if (q_temp>0) {
             Z_k+=q_temp;
             p_klocal->no_qpatches++;
@@ -576,7 +719,7 @@ void calculateQ(world* w) {
           cumulative=0;
           for (k_prime=0; k_prime<w->totalPatches; k_prime++) {
             p_kprime = w->allPatchList[k_prime];
-            q_temp = (unit::kernel_F(&w->a_units[p_klocal->households[0].unit],patch::distance(p_k,p_kprime))*w->patch_populations[k_prime]*Z_k);
+            q_temp = (unitHot::kernel_F(&w->unit_hot[p_klocal->households[0].unit],patch::distance(p_k,p_kprime))*w->patch_populations[k_prime]*Z_k);
             if (q_temp>0) {
               cumulative+=q_temp;
               p_klocal->q_patch[p_klocal->no_qpatches]=k_prime;
@@ -590,6 +733,26 @@ void calculateQ(world* w) {
   errline=11600;
 }
 
+void reportPopulationMemory(world* w, const char* when) {
+  // Bytes used on this node by people and households - the bulk of memory for a large population.
+  SIM_I64 n_people=0,n_households=0;
+  for (unsigned int i=0; i<w->noLocalPatches; i++) {
+    n_people+=w->localPatchList[i]->no_people;
+    n_households+=w->localPatchList[i]->no_households;
+  }
+  SIM_I64 bytes=(n_people*(SIM_I64)sizeof(person))+(n_households*(SIM_I64)sizeof(household));
+#ifdef COMPACT_PEOPLE
+  SIM_I64 side_bytes=(SIM_I64) ((household::no_windows+WINDOW_BLOCK-1)/WINDOW_BLOCK)*WINDOW_BLOCK*(SIM_I64)sizeof(householdWindows);
+  printf("%d: Population memory (%s, compact): %lld people x %d + %lld households x %d bytes = %.1f MB, window table %d entries = %.1f MB\n",
+    w->mpi_rank,when,(long long) n_people,(int) sizeof(person),(long long) n_households,(int) sizeof(household),bytes/1048576.0,
+    household::no_windows,side_bytes/1048576.0);
+#else
+  printf("%d: Population memory (%s): %lld people x %d + %lld households x %d bytes = %.1f MB\n",
+    w->mpi_rank,when,(long long) n_people,(int) sizeof(person),(long long) n_households,(int) sizeof(household),bytes/1048576.0);
+#endif
+  fflush(stdout);
+}
+
 void loadBinaryInitFile(world* w, string file) {
   errline=11604;
    w->read_buffer = new char[BUFFER_SIZE];
@@ -601,10 +764,10 @@ void loadBinaryInitFile(world* w, string file) {
 
   fread(&w->P->no_place_types,4,1,f);
   
-  w->places = new lwv::vector<place*>*[w->no_countries];
+  w->places = new placeList*[w->no_countries];
   w->no_places = new unsigned int*[w->no_countries];
   for (int i=0; i<w->no_countries; i++) {
-    w->places[i] = new lwv::vector<place*>[w->P->no_place_types];
+    w->places[i] = new placeList[w->P->no_place_types];
     w->no_places[i] = new unsigned int[w->P->no_place_types];
   }
 
@@ -776,6 +939,8 @@ void loadBinaryInitFile(world* w, string file) {
   fread(&w->no_units,4,1,f);
   
   w->a_units = new unit[w->no_units];
+  w->unit_hot_block = new char[(w->no_units*sizeof(unitHot))+UNIT_HOT_ALIGN];
+  w->unit_hot = (unitHot*) (w->unit_hot_block+(UNIT_HOT_ALIGN-(((size_t) w->unit_hot_block)%UNIT_HOT_ALIGN)));
   for (int i=0; i<w->no_units; i++) {
     w->a_units[i].log=false;
     w->a_units[i].no_nodes=0;
@@ -877,15 +1042,23 @@ void loadBinaryInitFile(world* w, string file) {
     int log;
     fread(&log,4,1,f);
     w->a_units[i].log=(log==1);
+    w->a_units[i].updateMultipliers(0);
+    w->a_units[i].syncHot(&w->unit_hot[i]);
 
   }
   errline=11893;
+  unitHot::exact=w->exact_kernels;
+  unitHot::buildKernelTables(w);
   resetUnitStats(w);
 
   // Seeding initialisation
 
   fread(&w->P->seed1,4,1,f);
   fread(&w->P->seed2,4,1,f);
+  if (w->seed_override) {                     // Seeds given on the command line (/seed:) take precedence
+    w->P->seed1=w->seed1;
+    w->P->seed2=w->seed2;
+  }
   initSeeds(w->P->seed1,w->P->seed2);
   fread(&w->P->no_seeds,4,1,f);
   
@@ -906,6 +1079,14 @@ void loadBinaryInitFile(world* w, string file) {
 
   // Params for Initialising population
   fread(&w->no_age_bands,4,1,f);
+#ifdef COMPACT_PEOPLE
+  if ((w->no_age_bands>MAX_AGE_BANDS) || (w->P->no_place_types>PLACE_TYPE_NONE)) {
+    printf("%d: ERROR - %d age bands and %d place types won't fit in a compact person (max %d, %d)\n",w->mpi_rank,
+      w->no_age_bands,w->P->no_place_types,MAX_AGE_BANDS,PLACE_TYPE_NONE);
+    fflush(stdout);
+    exit(1);
+  }
+#endif
   w->max_age_band=new float[w->no_age_bands];
   w->init_susceptibility = new double[w->no_age_bands];
   for (int i=0; i<w->no_age_bands; i++) {
@@ -949,9 +1130,25 @@ void loadBinaryInitFile(world* w, string file) {
     strcat(ff_file,"/");
     strcat(ff_file,w->ff_file);
     strcat(ff_file,".txt");
-    if (w->mpi_rank==0) w->ff=fopen(&ff_file[0],"w");
+    if ((w->mpi_rank==0) && (w->ff_override==NULL)) w->ff=fopen(&ff_file[0],"w");
   } else w->log_flat=false;
 
+  if (w->ff_override!=NULL) {                 // Flat file named on the command line (/ffout:) - turns flat file output on if necessary
+    w->log_flat=true;
+    if (w->mpi_rank==0) w->ff=fopen(w->ff_override,"w");
+  }
+
+  if (w->fb_file!=NULL) {                     // Binary flat file (/ffbin:) - on its own, or as well as the text one
+    w->log_flat=true;
+    if (w->mpi_rank==0) {
+      w->fb=fopen(w->fb_file,"wb");
+      if (w->fb==NULL) {
+        printf("%d: Couldn't open binary flat file %s\n",w->mpi_rank,w->fb_file);
+        fflush(stdout);
+      }
+    }
+  }
+
   fread(&dummy,4,1,f);
   if (dummy==1) {
     w->log_movie=true;
@@ -1065,11 +1262,19 @@ void loadBinaryInitFile(world* w, string file) {
   }
   errline=111089;
   fclose(f);
+  if (w->reorder_population) {
+    printf("%d:  Reordering households along a Hilbert curve\n",w->mpi_rank);
+    fflush(stdout);
+    reorderPopulation(w);
+  }
   printf("%d:  Calculating q matrix\n",w->mpi_rank);
   fflush(stdout);
   calculateQ(w);
+  buildSusceptibleIndex(w);
+  if (w->log_movie) w->grid = new imageGrid(w);   // Tiles where this node has households
   
   delete w->read_buffer;
+  reportPopulationMemory(w,"loaded");
 
   syncAdminUnitUse(w);    // Agree on which admin units are relevant to multiple nodes.
   syncPPCPN(w);           // Agree on how many people per country on each node.
@@ -48,6 +48,7 @@ using std::string;
 void initHouseholds(world *w);
 void readInitFiles(world *w);
 void loadBinaryInitFile(world* w, string file);
+void reportPopulationMemory(world* w, const char* when);
 void loadPlaces(world *w,char* file,unsigned char country,unsigned char place_type, int*** no_est_members);
 void loadHouseholdFile(world* w, string file,unsigned char country);
 
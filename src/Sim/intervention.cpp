@@ -136,6 +136,7 @@ void LiveIntervention::checkStatus(world* w) {
 void LiveIntervention::turnOn(world* w) {
   active=true;
   w->a_units[unit].live_interventions++;
+  w->a_units[unit].mul_stale=true;
   if (w->interventions[int_no].type==BORDER_CONTROL_ID) ((BorderControlInt*) w->interventions[int_no].sub_type)->on(w,this);
   else if (w->interventions[int_no].type==TREATMENT_ID) ((TreatmentInt*) w->interventions[int_no].sub_type)->on(w,this);
   else if (w->interventions[int_no].type==PROPHYLAXIS_ID) ((ProphylaxisInt*) w->interventions[int_no].sub_type)->on(w,this);
@@ -144,11 +145,13 @@ void LiveIntervention::turnOn(world* w) {
   else if (w->interventions[int_no].type==PLACE_CLOSE_ID) ((PlaceClosureInt*) w->interventions[int_no].sub_type)->on(w,this);
   else if (w->interventions[int_no].type==AREA_QUARANTINE_ID) ((AreaQuarantineInt*) w->interventions[int_no].sub_type)->on(w,this);
   else if (w->interventions[int_no].type==BLANKET_ID) ((BlanketTravelInt*) w->interventions[int_no].sub_type)->on(w,this);
+  w->a_units[unit].syncHot(&w->unit_hot[unit]);
 }
 
 void LiveIntervention::turnOff(world* w) {
   active=false;
   w->a_units[unit].live_interventions--;
+  w->a_units[unit].mul_stale=true;
   if (w->interventions[int_no].type==BORDER_CONTROL_ID) ((BorderControlInt*) w->interventions[int_no].sub_type)->off(w,this);
   else if (w->interventions[int_no].type==TREATMENT_ID) ((TreatmentInt*) w->interventions[int_no].sub_type)->off(w,this);
   else if (w->interventions[int_no].type==PROPHYLAXIS_ID) ((ProphylaxisInt*) w->interventions[int_no].sub_type)->off(w,this);
@@ -157,6 +160,7 @@ void LiveIntervention::turnOff(world* w) {
   else if (w->interventions[int_no].type==PLACE_CLOSE_ID) ((PlaceClosureInt*) w->interventions[int_no].sub_type)->off(w,this);
   else if (w->interventions[int_no].type==AREA_QUARANTINE_ID) ((AreaQuarantineInt*) w->interventions[int_no].sub_type)->off(w,this);
   else if (w->interventions[int_no].type==BLANKET_ID) ((BlanketTravelInt*) w->interventions[int_no].sub_type)->off(w,this);
+  w->a_units[unit].syncHot(&w->unit_hot[unit]);
 
 }
 
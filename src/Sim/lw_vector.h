@@ -144,6 +144,9 @@ public:
 	/* returns the size of the vector (number of elements) */
 	SIM_I64 size();
 
+	/* returns the number of elements the vector has room for before it reallocates */
+	SIM_I64 capacity();
+
 	/* tests if there are any elements in the vector */
 	bool empty();
 
@@ -492,6 +495,14 @@ template <class lwvType> inline SIM_I64 lw_vector<lwvType>::size()
 
 
 
+/* returns the number of elements the vector has room for before it reallocates */
+template <class lwvType> inline SIM_I64 lw_vector<lwvType>::capacity()
+{
+	return alloc_size;
+}
+
+
+
 /* tests if there are any elements in the vector */
 template <class lwvType> inline bool lw_vector<lwvType>::empty()
 {
@@ -0,0 +1,176 @@
+/* memreport.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Memory used by each part of the simulation on each node, reported by category
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+#include "memreport.h"
+#include "world.h"
+
+// reportMemory adds up what each part of the simulation has allocated on this node, from the sizes of its arrays
+// and the capacities of its vectors, and sets that beside what Linux says the process is using (VmRSS), has used
+// at most (VmHWM) and has mapped (VmSize). It runs at the end of startup, every /memreport:N timesteps and at
+// the end of the run. Rank 0 prints one line per rank; "other" is VmRSS less everything counted - heap overhead
+// and fragmentation, MPI's own buffers, code and libraries.
+//
+// Infected people come and go, so they can't be counted from array sizes: infectedPerson counts its bytes into
+// live_memory as it allocates and frees them.
+
+liveMemory* live_memory=NULL;
+
+const char* mem_names[NO_MEM] = { "patches", "people", "households", "places", "q_tables", "queues", "infected",
+                                  "messages", "stats", "image" };
+
+void initLiveMemory(int threads) {
+  live_memory = new liveMemory[threads];
+  for (int i=0; i<threads; i++) {
+    live_memory[i].infected=0;
+    live_memory[i].travel=0;
+    live_memory[i].contacts=0;
+  }
+}
+
+SIM_I64 procStatusKB(const char* field) {          // A "Vm...:" line of /proc/self/status, in KB. 0 if not Linux.
+  SIM_I64 kb=0;
+#ifndef _WIN32
+  FILE* f = fopen("/proc/self/status","r");
+  if (f!=NULL) {
+    char line[256];
+    int len=(int) strlen(field);
+    while (fgets(line,256,f)!=NULL) {
+      if (strncmp(line,field,len)==0) {
+        long long v=0;
+        sscanf(line+len,"%lld",&v);
+        kb=v;
+        break;
+      }
+    }
+    fclose(f);
+  }
+#endif
+  return kb;
+}
+
+SIM_I64 unitMemory(int threads, int place_types, int timesteps_per_day, int no_interventions) {
+  // One admin unit, with the arrays initialise.cpp gives it, and its share of world's delta_* arrays.
+  const SIM_I64 hist=10*timesteps_per_day;
+  return sizeof(unit)+sizeof(unitHot)+(threads*sizeof(int))+                                   // contact_makers
+         (place_types*((6*sizeof(double))+(3*sizeof(int))+sizeof(int*)))+
+         ((place_types+2)*hist*sizeof(int))+                                                    // Case histories
+         (no_interventions*(SIM_I64) sizeof(LiveIntervention))+
+         (8*sizeof(int*))+(threads*((2*sizeof(int*))+(6*sizeof(int))+(2*place_types*sizeof(int))));   // delta_*
+}
+
+template <class T> SIM_I64 vectorBytes(lwv::vector<T>& v) {
+  return v.capacity()*(SIM_I64) sizeof(T);
+}
+
+template <class T> SIM_I64 nestedVectorBytes(lwv::vector<lwv::vector<T> >& v) {
+  SIM_I64 bytes=vectorBytes(v);
+  for (SIM_I64 i=0; i<v.size(); i++) bytes+=vectorBytes(v[i]);
+  return bytes;
+}
+
+void countMemory(world* w, SIM_I64* bytes) {
+  const SIM_I64 threads=w->thread_count;
+  const SIM_I64 place_types=w->P->no_place_types;
+  for (int i=0; i<NO_MEM; i++) bytes[i]=0;
+
+  bytes[MEM_PATCHES]=(w->noLocalPatches*(SIM_I64) sizeof(localPatch))+(w->noRemotePatches*(SIM_I64) sizeof(patch))+
+                     sizeof(w->localPatchLookup)+sizeof(w->allPatchLookup)+
+                     ((w->noLocalPatches+w->totalPatches)*(SIM_I64) sizeof(patch*));
+  for (unsigned int i=0; i<w->noLocalPatches; i++) {
+    localPatch* lp = w->localPatchList[i];
+    bytes[MEM_PEOPLE]+=lp->no_people*(SIM_I64) sizeof(person);
+    bytes[MEM_HOUSEHOLDS]+=lp->no_households*(SIM_I64) sizeof(household);
+    bytes[MEM_Q]+=lp->no_qpatches*(SIM_I64) (sizeof(float)+sizeof(int));
+  }
+#ifdef COMPACT_PEOPLE
+  bytes[MEM_HOUSEHOLDS]+=(SIM_I64) ((household::no_windows+WINDOW_BLOCK-1)/WINDOW_BLOCK)*WINDOW_BLOCK*(SIM_I64) sizeof(householdWindows);
+#endif
+
+  for (int c=0; c<w->no_countries; c++) {
+    for (SIM_I64 t=0; t<place_types; t++) {
+      placeList* pl = &w->places[c][t];
+      bytes[MEM_PLACES]+=(pl->no_places*(SIM_I64) sizeof(place))+(((3*(SIM_I64) pl->no_groups)+1)*sizeof(unsigned int));
+      for (unsigned int e=0; e<pl->no_places; e++)
+        bytes[MEM_PLACES]+=pl->list[e].no_groups*(SIM_I64) pl->list[e].no_nodes*sizeof(unsigned int);   // node_first_host
+      if (pl->member_start!=NULL) bytes[MEM_PLACES]+=pl->member_start[pl->no_groups]*(SIM_I64) sizeof(person*);
+    }
+  }
+
+  for (int t=0; t<threads; t++) {
+    for (int s=0; s<2; s++) bytes[MEM_QUEUES]+=vectorBytes(w->confirmQueue[t][s]);
+    for (int s=0; s<w->P->infectionWindow; s++)
+      bytes[MEM_QUEUES]+=vectorBytes(w->contactQueue[t][s])+vectorBytes(w->symptomQueue[t][s])+vectorBytes(w->recoveryQueue[t][s]);
+    bytes[MEM_QUEUES]+=vectorBytes(w->susc_removed[t])+(w->P->infectionWindow*(SIM_I64) sizeof(int));   // queued_events
+
+    bytes[MEM_INFECTED]+=live_memory[t].infected+live_memory[t].travel+live_memory[t].contacts;
+
+    for (int n=0; n<w->mpi_size; n++)
+      bytes[MEM_MESSAGES]+=vectorBytes(w->remoteRequests[t][n])+vectorBytes(w->remoteReplies[t][n])+vectorBytes(w->placeInfMsg[t][n])+
+                           vectorBytes(w->placeClosureMsg[t][n])+vectorBytes(w->placeProphMsg[t][n]);
+    for (int s=0; s<2; s++)
+      bytes[MEM_MESSAGES]+=vectorBytes(w->reqHostAddresses[t][s])+nestedVectorBytes(w->reqOrders[t][s])+nestedVectorBytes(w->reqContactAddresses[t][s]);
+  }
+  bytes[MEM_MESSAGES]+=(SIM_I64) w->total_req_bytes_in+w->total_rep_bytes_in+w->total_est_bytes_in;   // message_in
+
+  for (int i=0; i<w->no_units; i++)
+    bytes[MEM_STATS]+=unitMemory(w->thread_count,w->P->no_place_types,w->P->timesteps_per_day,w->a_units[i].no_interventions);
+  if (unitHot::kernel_tables!=NULL) {
+    bytes[MEM_STATS]+=w->no_units*(SIM_I64) sizeof(kernelTable);
+    for (int i=0; i<unitHot::no_kernel_tables; i++) bytes[MEM_STATS]+=(unitHot::kernel_tables[i].n+2)*(SIM_I64) sizeof(double);
+  }
+
+  if (w->grid!=NULL) bytes[MEM_IMAGE]=w->grid->memoryBytes();
+}
+
+void reportMemory(world* w, const char* when) {
+  // Collective - every rank calls it at the same point, from the master thread.
+
+  const int rec_size=NO_MEM+3;
+  SIM_I64 bytes[NO_MEM];
+  countMemory(w,bytes);
+  double rec[NO_MEM+3];
+  for (int i=0; i<NO_MEM; i++) rec[i]=bytes[i]/1048576.0;
+  rec[NO_MEM]=procStatusKB("VmRSS:")/1024.0;
+  rec[NO_MEM+1]=procStatusKB("VmHWM:")/1024.0;
+  rec[NO_MEM+2]=procStatusKB("VmSize:")/1024.0;
+  double* all_recs = NULL;
+  if (w->mpi_rank==0) all_recs = new double[rec_size*w->mpi_size];
+  #ifdef _USEMPI
+    MPI_Gather(rec,rec_size,MPI_DOUBLE,all_recs,rec_size,MPI_DOUBLE,0,MPI_COMM_WORLD);
+  #else
+    for (int i=0; i<rec_size; i++) all_recs[i]=rec[i];
+  #endif
+  if (w->mpi_rank==0) {
+    printf("MEMORY when=%s step=%d ranks=%d threads=%d (MB)\n",when,w->steps_done,w->mpi_size,w->thread_count);
+    printf("MEMORY_HEAD rank");
+    for (int i=0; i<NO_MEM; i++) printf(" %s",mem_names[i]);
+    printf(" counted other rss peak_rss vsize\n");
+    for (int r=0; r<w->mpi_size; r++) {
+      double* rr = &all_recs[r*rec_size];
+      double counted=0;
+      printf("MEMORY_RANK %d",r);
+      for (int i=0; i<NO_MEM; i++) {
+        printf(" %.1f",rr[i]);
+        counted+=rr[i];
+      }
+      printf(" %.1f %.1f %.1f %.1f %.1f\n",counted,rr[NO_MEM]-counted,rr[NO_MEM],rr[NO_MEM+1],rr[NO_MEM+2]);
+    }
+    fflush(stdout);
+    delete[] all_recs;
+  }
+}
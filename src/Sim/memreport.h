@@ -0,0 +1,54 @@
+/* memreport.h, part of the Global Epidemic Simulation v1.0 BETA
+/* Header for the per-category memory report
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#ifndef MEMREPORT_H
+#define MEMREPORT_H
+
+#include "simINT64.h"
+
+#define MEM_PATCHES 0       // Local and remote patches, and the landscan lookup tables
+#define MEM_PEOPLE 1        // People, and the susceptible index
+#define MEM_HOUSEHOLDS 2    // Households, and their intervention windows
+#define MEM_PLACES 3        // Establishments, their groups and members
+#define MEM_Q 4             // Each local patch's table of community contact patches
+#define MEM_QUEUES 5        // Confirm, contact, symptom and recovery queues, and susc_removed
+#define MEM_INFECTED 6      // Live infectedPersons, travelPlans and contact lists - see liveMemory
+#define MEM_MESSAGES 7      // MPI message buffers
+#define MEM_STATS 8         // Admin units - parameters, case histories, kernel tables - and per-thread deltas
+#define MEM_IMAGE 9         // Movie tiles and images - see imagegrid.cpp
+#define NO_MEM 10
+
+class world;
+
+struct liveMemory {         // Bytes of infected state allocated (+) and freed (-) by each thread. Threads free
+  SIM_I64 infected;         // each other's, so only the sum over threads means anything.
+  SIM_I64 travel;
+  SIM_I64 contacts;
+  char pad[104];            // Keep each thread's counters on their own cache line
+};
+
+extern liveMemory* live_memory;   // [thread]
+extern const char* mem_names[NO_MEM];
+
+void initLiveMemory(int threads);
+SIM_I64 procStatusKB(const char* field);
+SIM_I64 unitMemory(int threads, int place_types, int timesteps_per_day, int no_interventions);
+void reportMemory(world* w, const char* when);
+
+#endif
@@ -18,7 +18,6 @@
 
 #include "messages.h"
 
-unsigned char* image_message;    // This is a buffer for assembling the data for movie PNG files.
 
 int* starter_msg_out;    // The first message sorts out all the sizes... it is annoying that MPI needs this separately.
 int* starter_msg_in;     // MSG_size_out is an array of 3* (mpi_size*mpi_size) - node-to-node grids for (1) requests, (2) replies
@@ -29,17 +28,19 @@ int* msg_displs_in;
 
 int starter_msg_size=0;
 
+FILE* traffic_log=NULL;  // Optional record of the byte matrices exchanged each timestep (/traffic:file). Rank 0 only.
+                         // Format - header:   int mpi_size, int starter_msg_size, int no_units, int image_bytes (0 if no movie)
+                         //          image_bytes is a whole frame - the most the movie gather can send (see imagegrid.cpp)
+                         //          per step: int T, then the first three blocks of the starter message (3*mpi_size*mpi_size ints)
+                         // Read by src/CommReplay.
+
 void initialiseMessages(world* w) {
 #ifdef _USEMPI
-  if (w->mpi_rank==0) {
-    image_message = new unsigned char[PNG_WIDTH*PNG_HEIGHT];   // Image size specified here. Use node 0 to compile the image.
-  } else {
-    image_message = new unsigned char[1];
-  }
-
   starter_msg_size = (w->mpi_size*w->mpi_size*3);                 // BLOCKS 1,2,3
   starter_msg_size+= (w->no_units*(6+(2*w->P->no_place_types)));  // BLOCK 4 
   starter_msg_size++;                                             // BLOCK 5        -  see comments in doMessage()
+  if (w->fast_forward) starter_msg_size+=w->mpi_size;             // BLOCK 6, unless /noskip
+  if (w->metrics_spec!=NULL) starter_msg_size+=w->mpi_size*NO_METRICS;   // BLOCK 7, only with /metrics
 
   starter_msg_in = new int[starter_msg_size];
   starter_msg_out = new int[starter_msg_size];
@@ -48,13 +49,31 @@ void initialiseMessages(world* w) {
   msg_counts_in = new int[w->mpi_size];
   msg_displs_in = new int[w->mpi_size];
 
+  if ((w->traffic_file!=NULL) && (w->mpi_rank==0)) {
+    traffic_log = fopen(w->traffic_file,"wb");
+    if (traffic_log==NULL) {
+      printf("%d: Couldn't open traffic file %s - not recording\n",w->mpi_rank,w->traffic_file);
+      fflush(stdout);
+    } else {
+      int image_bytes = (w->log_movie)?PNG_WIDTH*PNG_HEIGHT:0;
+      fwrite(&w->mpi_size,4,1,traffic_log);
+      fwrite(&starter_msg_size,4,1,traffic_log);
+      fwrite(&w->no_units,4,1,traffic_log);
+      fwrite(&image_bytes,4,1,traffic_log);
+    }
+  }
 
-#else
-  image_message = new unsigned char[1];
 #endif
 }
 
 
+void finaliseMessages(world* w) {
+  if (traffic_log!=NULL) {
+    fclose(traffic_log);
+    traffic_log=NULL;
+  }
+}
+
 void addFirstRemoteRequest(world* w, unsigned short thread_no,float lon, float lat, infectedPerson* infected,unsigned short node, unsigned short n_remotes) {
   // Only called from addRemoteRequest
   //
@@ -111,7 +130,7 @@ void addRemoteRequest(world* w, unsigned short thread_no,patch* location_suscept
 void addTravelRequest(world* w, unsigned short thread_no,infectedPerson* infected,float new_contact_time,unsigned short contact_no, unsigned char first_flag, unsigned short travel_type) {
 #ifdef _USEMPI
   if (w->req_base[thread_no][infected->travel_plan->travel_node]==-1) {                                                                   // Is this the first request added?
-    addFirstRemoteRequest(w, thread_no,infected->personPointer->house->lon, infected->personPointer->house->lat, infected,infected->travel_plan->travel_node,(unsigned short)1);  // If so, call special initialiser
+    addFirstRemoteRequest(w, thread_no,infected->personPointer->getHouse()->lon, infected->personPointer->getHouse()->lat, infected,infected->travel_plan->travel_node,(unsigned short)1);  // If so, call special initialiser
     for (int i=0; i<2; i++) w->remoteRequests[thread_no][infected->travel_plan->travel_node].push_back(((unsigned char*)(&(contact_no)))[i]);    // The "index" of requests in the contacts order.
     for (int i=0; i<4; i++) w->remoteRequests[thread_no][infected->travel_plan->travel_node].push_back(((unsigned char*)(&new_contact_time))[i]); // Time of contact (float)
     unsigned short s = (unsigned short) infected->travel_plan->country;
@@ -395,6 +414,54 @@ void processStatusInfo(world* w) {
 
 }
 
+int stepsToNextEvent(world* w) {
+  // Part-way through a timestep (called from doMessage, once this node's buffers are packed): how many of the
+  // timesteps after this one this node could skip, because nothing at all would happen in them. 0 means there may be
+  // work next step. NO_EVENTS means nothing is queued and there are no seeds left.
+  // Only the rest of this step can add to the queues before then. Incoming requests and replies show in the byte
+  // matrices (see processSkipInfo); here it's the confirmations, and the symptoms and recoveries due in this step's
+  // slot. Those are also all that change the unit stats after this message has carried them, so the stats deltas
+  // need no scan of their own.
+
+  for (int i=0; i<w->thread_count; i++) {
+    if ((w->confirmQueue[i][0].size()>0) || (w->confirmQueue[i][1].size()>0)) return 0;    // Contacts still awaiting confirmation
+    if ((w->reqHostAddresses[i][0].size()>0) || (w->reqHostAddresses[i][1].size()>0)) return 0;  // Remote contacts awaiting replies
+    if (w->queued_events[i][w->infectionMod]>0) return 0;                                 // Symptoms and recoveries still to come this step
+  }
+
+  int steps=NO_EVENTS;
+  if (w->P->next_seed<w->P->no_seeds) {                    // Steps until the next seeding, counted from the next step
+    int hours = w->P->seed_ts[w->P->next_seed]-((int)w->T+(int)w->P->timestep_hours);
+    if (hours<=0) return 0;
+    steps = (hours+(int)w->P->timestep_hours-1)/(int)w->P->timestep_hours;
+  }
+  for (int k=0; (k<w->P->infectionWindow) && (k<steps); k++) {   // First slot after this step's with something queued
+    int slot = (w->infectionMod+1+k) % w->P->infectionWindow;
+    for (int i=0; i<w->thread_count; i++) {
+      if (w->queued_events[i][slot]>0) return k;
+    }
+  }
+  return steps;
+}
+
+void addSkipInfo(world* w, int* block) {
+  // Fast-forwarding needs the smallest stepsToNextEvent over the nodes. The starter message is reduced with MPI_SUM,
+  // so each node puts its own value in its own slot, and everyone takes the minimum afterwards - no extra Allreduce.
+  block[w->mpi_rank]=stepsToNextEvent(w);
+}
+
+void processSkipInfo(world* w, int* block) {
+  w->skip_next=NO_EVENTS;
+  for (int i=0; i<w->mpi_size; i++)
+    if (block[i]<w->skip_next) w->skip_next=block[i];
+  for (int i=0; i<w->mpi_size*w->mpi_size*3; i++) {          // Any requests, replies or place messages in flight (beyond
+    if (starter_msg_in[i]>((i>=2*w->mpi_size*w->mpi_size)?12:0)) {   // the three 4-byte place counts) will make
+      w->skip_next=0;                                          // work for next step somewhere.
+      i=w->mpi_size*w->mpi_size*3;
+    }
+  }
+}
+
 void doMessage(world* w) {
   
 #ifdef _USEMPI
@@ -428,6 +495,16 @@ void doMessage(world* w) {
   //               length:       1
   //               format:       flag: 0 = "No more work to do" for each node. else 1. (Fine to reduce to a SUM)
   // 
+  // SIXTH BLOCK: unless /noskip
+  //               starts at:    3*(mpi_size*mpi_size)+(no_units*(6+(2_no_place_types)))+1
+  //               length:       mpi_size
+  //               format:       each node's stepsToNextEvent, in its own slot - see addSkipInfo
+  //
+  // SEVENTH BLOCK: only while /metrics is on
+  //               starts at:    after the sixth (or in its place, under /noskip)
+  //               length:       mpi_size*NO_METRICS
+  //               format:       each node's own values, in its own slot - see metrics.h
+  //
 
   // Calculate number of bytes to send to each other node.
 
@@ -524,12 +601,22 @@ void doMessage(world* w) {
   // And receive how many bytes are for us.
   prepareUnitInfo(w);
   addStatusInfo(w);
+  int skip_start = 3*(w->mpi_size*w->mpi_size)+(w->no_units*(6+(2*w->P->no_place_types)))+1;
+  int metrics_start = skip_start+((w->fast_forward)?w->mpi_size:0);
+  if (w->fast_forward) addSkipInfo(w,&starter_msg_out[skip_start]);
+  if (w->metrics_spec!=NULL) addMetricsInfo(w,&starter_msg_out[metrics_start]);
   error_code = MPI_Allreduce(starter_msg_out,starter_msg_in,starter_msg_size,MPI_INT,MPI_SUM,MPI_COMM_WORLD);                // Everyone ends up with a full copy of what messages are going where.
   processUnitInfo(w);
   processStatusInfo(w);
+  if (w->fast_forward) processSkipInfo(w,&starter_msg_in[skip_start]);
+  if (w->metrics!=NULL) w->metrics->update(w,&starter_msg_in[metrics_start],starter_msg_in,starter_msg_size);
+  if (traffic_log!=NULL) {                                         // Record who sent how many bytes to whom this step.
+    fwrite(&w->T,4,1,traffic_log);
+    fwrite(starter_msg_in,4,3*w->mpi_size*w->mpi_size,traffic_log);
+  }
 
 
-  if (w->log_movie) error_code = MPI_Reduce(&(w->image[0]),&image_message[0],PNG_WIDTH*PNG_HEIGHT,MPI_UNSIGNED_CHAR,MPI_SUM,0,MPI_COMM_WORLD);      // Do the image bit here too. Merge?
+  if (w->log_movie) w->grid->gather(w);    // Do the image bit here too - just the tiles that changed, see imagegrid.cpp
 
   // Arrange incoming memory space, with counts and displacements for MPI message
   
@@ -562,12 +649,13 @@ void doMessage(world* w) {
   
 
   delete[] message_out;
-  if ((w->log_movie) && (w->mpi_rank==0)) {
-    for (int i=0; i<PNG_WIDTH*PNG_HEIGHT; i++) w->image[i]=image_message[i];
+  if ((w->log_movie) && (w->mpi_rank==0)) saveImage(w);
+#else
+  if (w->fast_forward) w->skip_next=stepsToNextEvent(w);
+  if (w->log_movie) {
+    w->grid->gather(w);
     saveImage(w);
   }
-#else
-  if (w->log_movie) saveImage(w);
 #endif
 
 }
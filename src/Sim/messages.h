@@ -38,6 +38,7 @@ class patch;
 
 void initialiseMessages(world* w);
 void doMessage(world* w);
+void finaliseMessages(world* w);
 void syncAdminUnitUse(world* w);
 void syncPPCPN(world* w);
 void addRemoteRequest(world* w, unsigned short thread_no,patch* location_susceptible,float lon, float lat, infectedPerson* infected,float new_contact_time,unsigned short contact_no, unsigned short node);
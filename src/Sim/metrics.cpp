@@ -0,0 +1,360 @@
+/* metrics.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Live Prometheus metrics on rank 0 (/metrics:port or /metrics:path)
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+#include "metrics.h"
+#include "world.h"
+#include <stdarg.h>
+#ifndef _WIN32
+  #include <sys/socket.h>
+  #include <sys/un.h>
+  #include <netinet/in.h>
+  #include <arpa/inet.h>
+  #include <poll.h>
+  #include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+  #define MSG_NOSIGNAL 0
+#endif
+
+// /metrics:port serves Prometheus text format at http://127.0.0.1:port/metrics on rank 0, for watching a long run
+// without reading its stdout. /metrics:path serves the same over HTTP on a Unix domain socket instead (eg
+// curl --unix-socket path http://localhost/metrics). Only localhost or the socket file's permissions guard it.
+//
+// No extra communication: while it is on, the starter message that doMessage already reduces every timestep has
+// one more block, with NO_METRICS ints per rank. Each rank fills its own slot and leaves the rest zero, so the
+// MPI_SUM delivers every rank's values to rank 0. Bytes sent and received come from the byte matrices in the same
+// message. Rank 0 copies it all into the server under a lock, and a thread answers scrapes from that copy - a slow
+// scraper never holds up the main loop. With /metrics off the block isn't there and none of this runs.
+//
+// Values arrive at doMessage, so phase times lag by part of a step, and nothing changes while timesteps are
+// being fast-forwarded.
+
+static double last_phase[NO_PHASES];     // This rank's phase_time and busy_time at the last message
+static double* last_busy=NULL;
+static double rss_time=-1;               // When VmRSS was last read
+static int rss_kb=0;
+
+void addMetricsInfo(world* w, int* block) {
+  int* b = &block[w->mpi_rank*NO_METRICS];
+  if (last_busy==NULL) {
+    last_busy = new double[w->thread_count];
+    for (int i=0; i<w->thread_count; i++) last_busy[i]=0;
+    for (int i=0; i<NO_PHASES; i++) last_phase[i]=0;
+  }
+  for (int i=0; i<NO_PHASES; i++) {
+    double us=(w->phase_time[i]-last_phase[i])*1000000.0;
+    b[METRIC_PHASE+i]=(us<2000000000.0)?(int) (us+0.5):2000000000;
+    last_phase[i]=w->phase_time[i];
+  }
+  int queued=0,confirm=0;
+  for (int i=0; i<w->thread_count; i++) {
+    queued+=w->queued_total[i];
+    confirm+=(int) (w->confirmQueue[i][0].size()+w->confirmQueue[i][1].size());
+  }
+  b[METRIC_QUEUED]=queued;
+  b[METRIC_CONFIRM]=confirm;
+  double now=phaseClock();
+  if ((rss_time<0) || (now-rss_time>=1.0)) {
+    rss_kb=(int) procStatusKB("VmRSS:");
+    rss_time=now;
+  }
+  b[METRIC_RSS]=rss_kb;
+  double max_busy=0,sum_busy=0;
+  for (int i=0; i<w->thread_count; i++) {
+    double d=w->busy_time[i]-last_busy[i];
+    last_busy[i]=w->busy_time[i];
+    sum_busy+=d;
+    if (d>max_busy) max_busy=d;
+  }
+  b[METRIC_THREADS]=(sum_busy>0)?(int) (1000.0*max_busy/(sum_busy/w->thread_count)):1000;
+}
+
+metricsServer::metricsServer(world* w, const char* spec) {
+  listen_fd=-1;
+  unix_path=NULL;
+  running=false;
+  stopping=false;
+  ranks=w->mpi_size;
+  threads=w->thread_count;
+  starter_bytes=0;
+  steps=0;
+  steps_skipped=0;
+  t_day=0;
+  rate=0;
+  rate_time=-1;
+  rate_steps=0;
+  rank_imbalance=1.0;
+  symptomatic=0;
+  nonsymptomatic=0;
+  phase_seconds = new double[ranks*NO_PHASES];
+  for (int i=0; i<ranks*NO_PHASES; i++) phase_seconds[i]=0;
+  rank_values = new int[ranks*NO_METRICS];
+  for (int i=0; i<ranks*NO_METRICS; i++) rank_values[i]=0;
+  bytes_sent = new SIM_I64[ranks];
+  bytes_sent_total = new SIM_I64[ranks];
+  bytes_received = new SIM_I64[ranks];
+  for (int i=0; i<ranks; i++) {
+    bytes_sent[i]=0;
+    bytes_sent_total[i]=0;
+    bytes_received[i]=0;
+  }
+  pthread_mutex_init(&lock,NULL);
+
+#ifdef _WIN32
+  printf("%d: /metrics needs POSIX sockets - carrying on without it\n",w->mpi_rank);
+  fflush(stdout);
+#else
+  bool tcp=(spec[0]!=0);
+  for (int i=0; spec[i]!=0; i++) if ((spec[i]<'0') || (spec[i]>'9')) tcp=false;
+  int ok=-1;
+  if (tcp) {
+    listen_fd=socket(AF_INET,SOCK_STREAM,0);
+    if (listen_fd>=0) {
+      int one=1;
+      setsockopt(listen_fd,SOL_SOCKET,SO_REUSEADDR,&one,sizeof(one));
+      struct sockaddr_in addr;
+      memset(&addr,0,sizeof(addr));
+      addr.sin_family=AF_INET;
+      addr.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+      addr.sin_port=htons((unsigned short) atoi(spec));
+      ok=bind(listen_fd,(struct sockaddr*) &addr,sizeof(addr));
+    }
+  } else {
+    struct sockaddr_un addr;
+    memset(&addr,0,sizeof(addr));
+    addr.sun_family=AF_UNIX;
+    if (strlen(spec)<sizeof(addr.sun_path)) {
+      strcpy(addr.sun_path,spec);
+      listen_fd=socket(AF_UNIX,SOCK_STREAM,0);
+      if (listen_fd>=0) {
+        unlink(spec);                            // A socket file left by an earlier run
+        ok=bind(listen_fd,(struct sockaddr*) &addr,sizeof(addr));
+        if (ok==0) {
+          unix_path = new char[strlen(spec)+1];
+          strcpy(unix_path,spec);
+        }
+      }
+    }
+  }
+  if (ok==0) ok=listen(listen_fd,8);
+  if ((ok==0) && (pthread_create(&thread,NULL,run,this)==0)) running=true;
+  if (running) {
+    if (tcp) printf("%d: Serving metrics at http://127.0.0.1:%s/metrics\n",w->mpi_rank,spec);
+    else printf("%d: Serving metrics on Unix socket %s\n",w->mpi_rank,spec);
+  } else {
+    printf("%d: Couldn't open metrics endpoint %s - carrying on without it\n",w->mpi_rank,spec);
+    if (listen_fd>=0) close(listen_fd);
+    listen_fd=-1;
+  }
+  fflush(stdout);
+#endif
+}
+
+metricsServer::~metricsServer() {
+  pthread_mutex_lock(&lock);
+  stopping=true;
+  pthread_mutex_unlock(&lock);
+  if (running) pthread_join(thread,NULL);
+#ifndef _WIN32
+  if (listen_fd>=0) close(listen_fd);
+  if (unix_path!=NULL) unlink(unix_path);
+#endif
+  delete[] unix_path;
+  delete[] phase_seconds;
+  delete[] rank_values;
+  delete[] bytes_sent;
+  delete[] bytes_sent_total;
+  delete[] bytes_received;
+  pthread_mutex_destroy(&lock);
+}
+
+void metricsServer::update(world* w, int* block, int* traffic, int starter_size) {
+  SIM_I64 sympt=0,nonsympt=0;
+  for (int i=0; i<w->no_units; i++) {
+    sympt+=w->a_units[i].current_symptomatic_inf;
+    nonsympt+=w->a_units[i].current_nonsymptomatic_inf;
+  }
+  double now=phaseClock();
+  int grid=ranks*ranks;
+
+  pthread_mutex_lock(&lock);
+  steps=w->steps_done;
+  steps_skipped=w->steps_skipped;
+  t_day=w->T_day;
+  starter_bytes=starter_size*4;
+  symptomatic=sympt;
+  nonsymptomatic=nonsympt;
+  if (rate_time<0) {
+    rate_time=now;
+    rate_steps=steps;
+  } else if (now-rate_time>=1.0) {
+    rate=(steps-rate_steps)/(now-rate_time);
+    rate_time=now;
+    rate_steps=steps;
+  }
+  double max_compute=0,sum_compute=0;
+  for (int r=0; r<ranks; r++) {
+    int* b = &block[r*NO_METRICS];
+    double compute=0;
+    for (int i=0; i<NO_PHASES; i++) {
+      phase_seconds[r*NO_PHASES+i]+=b[METRIC_PHASE+i]/1000000.0;
+      if (i!=PHASE_MESSAGE) compute+=b[METRIC_PHASE+i];
+    }
+    sum_compute+=compute;
+    if (compute>max_compute) max_compute=compute;
+    for (int i=0; i<NO_METRICS; i++) rank_values[r*NO_METRICS+i]=b[i];
+    SIM_I64 sent=0,received=0;
+    for (int k=0; k<3; k++) {                  // Requests, replies and place messages - [k][dest][src]
+      for (int n=0; n<ranks; n++) {
+        sent+=traffic[(k*grid)+(n*ranks)+r];
+        received+=traffic[(k*grid)+(r*ranks)+n];
+      }
+    }
+    bytes_sent[r]=sent;
+    bytes_sent_total[r]+=sent;
+    bytes_received[r]=received;
+  }
+  rank_imbalance=(sum_compute>0)?max_compute/(sum_compute/ranks):1.0;
+  pthread_mutex_unlock(&lock);
+}
+
+static void metricHead(std::string& out, const char* name, const char* type, const char* help) {
+  out+="# HELP ";
+  out+=name;
+  out+=" ";
+  out+=help;
+  out+="\n# TYPE ";
+  out+=name;
+  out+=" ";
+  out+=type;
+  out+="\n";
+}
+
+static void metricLine(std::string& out, const char* format, ...) {
+  char line[256];
+  va_list args;
+  va_start(args,format);
+  vsnprintf(line,256,format,args);
+  va_end(args);
+  out+=line;
+}
+
+void metricsServer::render(std::string& out) {   // Called with the lock held
+  metricHead(out,"gsim_timestep","gauge","Timesteps completed");
+  metricLine(out,"gsim_timestep %u\n",steps);
+  metricHead(out,"gsim_timesteps_skipped","gauge","Timesteps fast-forwarded because no node had anything to do");
+  metricLine(out,"gsim_timesteps_skipped %u\n",steps_skipped);
+  metricHead(out,"gsim_sim_day","gauge","Simulated time in days");
+  metricLine(out,"gsim_sim_day %.4f\n",t_day);
+  metricHead(out,"gsim_timesteps_per_second","gauge","Timesteps per wall-clock second, over at least the last second");
+  metricLine(out,"gsim_timesteps_per_second %.4f\n",rate);
+  metricHead(out,"gsim_ranks","gauge","MPI ranks");
+  metricLine(out,"gsim_ranks %d\n",ranks);
+  metricHead(out,"gsim_threads","gauge","OpenMP threads per rank");
+  metricLine(out,"gsim_threads %d\n",threads);
+  metricHead(out,"gsim_infected","gauge","People currently infected, over all ranks");
+  metricLine(out,"gsim_infected{state=\"symptomatic\"} %lld\n",(long long) symptomatic);
+  metricLine(out,"gsim_infected{state=\"nonsymptomatic\"} %lld\n",(long long) nonsymptomatic);
+  metricHead(out,"gsim_rank_imbalance","gauge","Slowest rank's compute time over the mean, last timestep (1 = even)");
+  metricLine(out,"gsim_rank_imbalance %.4f\n",rank_imbalance);
+  metricHead(out,"gsim_starter_message_bytes","gauge","Size of the starter message reduced every timestep");
+  metricLine(out,"gsim_starter_message_bytes %d\n",starter_bytes);
+
+  metricHead(out,"gsim_phase_seconds_total","counter","Seconds in each phase of the main loop");
+  for (int r=0; r<ranks; r++)
+    for (int i=0; i<NO_PHASES; i++)
+      metricLine(out,"gsim_phase_seconds_total{rank=\"%d\",phase=\"%s\"} %.6f\n",r,phase_names[i],phase_seconds[r*NO_PHASES+i]);
+  metricHead(out,"gsim_thread_imbalance","gauge","Busiest thread's queue time over the mean, last timestep (1 = even)");
+  for (int r=0; r<ranks; r++) metricLine(out,"gsim_thread_imbalance{rank=\"%d\"} %.3f\n",r,rank_values[r*NO_METRICS+METRIC_THREADS]/1000.0);
+  metricHead(out,"gsim_queued_events","gauge","Contact, symptom and recovery events waiting");
+  for (int r=0; r<ranks; r++) metricLine(out,"gsim_queued_events{rank=\"%d\"} %d\n",r,rank_values[r*NO_METRICS+METRIC_QUEUED]);
+  metricHead(out,"gsim_confirm_queue","gauge","Contacts waiting to be confirmed");
+  for (int r=0; r<ranks; r++) metricLine(out,"gsim_confirm_queue{rank=\"%d\"} %d\n",r,rank_values[r*NO_METRICS+METRIC_CONFIRM]);
+  metricHead(out,"gsim_mpi_bytes_sent","gauge","Bytes sent to other ranks in the last timestep's exchange");
+  for (int r=0; r<ranks; r++) metricLine(out,"gsim_mpi_bytes_sent{rank=\"%d\"} %lld\n",r,(long long) bytes_sent[r]);
+  metricHead(out,"gsim_mpi_bytes_received","gauge","Bytes received from other ranks in the last timestep's exchange");
+  for (int r=0; r<ranks; r++) metricLine(out,"gsim_mpi_bytes_received{rank=\"%d\"} %lld\n",r,(long long) bytes_received[r]);
+  metricHead(out,"gsim_mpi_bytes_sent_total","counter","Bytes sent to other ranks");
+  for (int r=0; r<ranks; r++) metricLine(out,"gsim_mpi_bytes_sent_total{rank=\"%d\"} %lld\n",r,(long long) bytes_sent_total[r]);
+  metricHead(out,"gsim_resident_bytes","gauge","Resident set size (VmRSS), read at most once a second");
+  for (int r=0; r<ranks; r++) metricLine(out,"gsim_resident_bytes{rank=\"%d\"} %lld\n",r,1024LL*rank_values[r*NO_METRICS+METRIC_RSS]);
+}
+
+void metricsServer::serve(int fd) {
+#ifndef _WIN32
+  char req[1024];
+  int got=0;
+  req[0]=0;
+  while (got<1023) {                             // Just the request line matters, but read the headers too
+    struct pollfd p;
+    p.fd=fd;
+    p.events=POLLIN;
+    p.revents=0;
+    if (poll(&p,1,1000)<=0) break;
+    int n=(int) recv(fd,req+got,1023-got,0);
+    if (n<=0) break;
+    got+=n;
+    req[got]=0;
+    if ((strstr(req,"\r\n\r\n")!=NULL) || (strstr(req,"\n\n")!=NULL)) break;
+  }
+  std::string body;
+  const char* status="200 OK";
+  if ((strncmp(req,"GET /metrics",12)==0) || (strncmp(req,"GET / ",6)==0)) {
+    pthread_mutex_lock(&lock);
+    render(body);
+    pthread_mutex_unlock(&lock);
+  } else {
+    status="404 Not Found";
+    body="Try /metrics\n";
+  }
+  char head[256];
+  snprintf(head,256,"HTTP/1.0 %s\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\nConnection: close\r\n\r\n",
+           status,(int) body.size());
+  std::string out=head;
+  out+=body;
+  size_t sent=0;
+  while (sent<out.size()) {
+    int n=(int) send(fd,out.data()+sent,out.size()-sent,MSG_NOSIGNAL);   // No SIGPIPE if the scraper hangs up
+    if (n<=0) break;
+    sent+=n;
+  }
+#endif
+}
+
+void* metricsServer::run(void* arg) {          // The server thread: one connection at a time
+#ifndef _WIN32
+  metricsServer* m = (metricsServer*) arg;
+  while (true) {
+    pthread_mutex_lock(&m->lock);
+    bool stop=m->stopping;
+    pthread_mutex_unlock(&m->lock);
+    if (stop) break;
+    struct pollfd p;
+    p.fd=m->listen_fd;
+    p.events=POLLIN;
+    p.revents=0;
+    if (poll(&p,1,250)<=0) continue;             // Wake now and then to see if the run has finished
+    int fd=accept(m->listen_fd,NULL,NULL);
+    if (fd<0) continue;
+    m->serve(fd);
+    close(fd);
+  }
+#endif
+  return NULL;
+}
@@ -0,0 +1,79 @@
+/* metrics.h, part of the Global Epidemic Simulation v1.0 BETA
+/* Live Prometheus metrics on rank 0 (/metrics:port or /metrics:path)
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <pthread.h>
+#include <string>
+#include "simINT64.h"
+#include "timing.h"
+
+// Each rank's block of the starter message while /metrics is on - see doMessage. Ints, so times are in
+// microseconds and memory in KB.
+
+#define METRIC_PHASE 0                    // NO_PHASES fields: time in each phase since the last message
+#define METRIC_QUEUED (NO_PHASES)         // Contact, symptom and recovery events waiting
+#define METRIC_CONFIRM (NO_PHASES+1)      // Contacts waiting to be confirmed
+#define METRIC_RSS (NO_PHASES+2)          // Resident set size, KB (re-read at most once a second)
+#define METRIC_THREADS (NO_PHASES+3)      // Thread imbalance since the last message (max/mean busy time), x1000
+#define NO_METRICS (NO_PHASES+4)
+
+class world;
+
+class metricsServer {
+  public:
+    metricsServer(world* w, const char* spec);
+    ~metricsServer();
+    void update(world* w, int* block, int* traffic, int starter_size);  // From the starter message - rank 0, every step
+
+  private:
+    void render(std::string& out);
+    void serve(int fd);
+    static void* run(void* arg);
+
+    int listen_fd;            // -1 if the endpoint couldn't be opened
+    char* unix_path;          // Socket file to remove at the end, or NULL for TCP
+    pthread_t thread;
+    pthread_mutex_t lock;     // Guards everything below, and stopping
+    bool running;
+    bool stopping;
+
+    int ranks;
+    int threads;
+    int starter_bytes;
+    unsigned int steps;
+    unsigned int steps_skipped;
+    float t_day;
+    double rate;              // Timesteps per second, over at least the last second
+    double rate_time;
+    unsigned int rate_steps;
+    double rank_imbalance;    // Max/mean compute time (everything but the message phase) over ranks, last step
+    SIM_I64 symptomatic;
+    SIM_I64 nonsymptomatic;
+    double* phase_seconds;    // [rank*NO_PHASES+phase], accumulated
+    int* rank_values;         // [rank*NO_METRICS] - the last block from each rank
+    SIM_I64* bytes_sent;      // [rank] last step, and in total
+    SIM_I64* bytes_sent_total;
+    SIM_I64* bytes_received;
+};
+
+void addMetricsInfo(world* w, int* block);   // This rank's values, into its own slot of the block
+
+#endif
@@ -21,23 +21,32 @@
 void setInfected(double lon, double lat, int delta,int thread_no, world *wo) {
   const int x = lonToLsIndex(lon)/(43200/PNG_WIDTH);
   const int y = latToLsIndex(lat)/(21600/PNG_HEIGHT);
-  if ((x<0) || (x>PNG_WIDTH) || (y<0) || (y>PNG_HEIGHT)) {
+  if ((wo->grid==NULL) || (delta==0)) return;    // No movie, or nothing to change
+  if ((x<0) || (x>=PNG_WIDTH) || (y<0) || (y>=PNG_HEIGHT)) {
     printf("Range error\n");
-  } else wo->infected_grid[x][y][thread_no]+=delta;
- 
+  } else wo->grid->add(x,y,thread_no,delta,0);
+
 }
 
 void setImmune(double lon, double lat, int delta, int thread_no, world *wo) {
   const int x = lonToLsIndex(lon)/(43200/PNG_WIDTH);
   const int y = latToLsIndex(lat)/(21600/PNG_HEIGHT);
-  if ((x<0) || (x>PNG_WIDTH) || (y<0) || (y>PNG_HEIGHT)) {
+  if ((wo->grid==NULL) || (delta==0)) return;    // No movie, or nothing to change
+  if ((x<0) || (x>=PNG_WIDTH) || (y<0) || (y>=PNG_HEIGHT)) {
     printf("Range error\n");
-  } else wo->immune_grid[x][y][thread_no]+=delta;
+  } else wo->grid->add(x,y,thread_no,0,delta);
 }
 
 void logFlatfile(world *wo) {
+  // Copy the rows for this timestep into a writer job.
   int i;
   unsigned int j;
+  writerJob* job = wo->writer->claim(JOB_FLAT);
+  if (job->max_rows<wo->no_units) {
+    delete[] job->rows;
+    job->max_rows=wo->no_units;
+    job->rows = new int[job->max_rows*wo->writer->row_width];
+  }
   for (i=0; i<wo->no_units; i++) {
     unit* u = &wo->a_units[i];
     if (u->log) { // Only log to flatfile if one of the fields is non-zero.
@@ -57,23 +66,36 @@ void logFlatfile(world *wo) {
       }
 
       if (ok) {
-        fprintf(wo->ff,"%d\t%d\t%d\t%d\t%d\t",wo->T,i,u->contact_makers[0],u->new_comm_cases,u->new_hh_cases);
-        for (j=0; j<wo->P->no_place_types; j++) fprintf(wo->ff,"%d\t",u->new_place_cases[j]);
-        fprintf(wo->ff,"%d\t%d\t",u->new_comm_infs,u->new_hh_infs);
-        for (j=0; j<wo->P->no_place_types; j++) fprintf(wo->ff,"%d\t",u->new_place_infs[j]);
-        fprintf(wo->ff,"%d\t%d\n",u->current_symptomatic_inf,u->current_nonsymptomatic_inf);
-       
+        int* row = &job->rows[job->no_rows*wo->writer->row_width];
+        j=0;
+        row[j++]=wo->T;
+        row[j++]=i;
+        row[j++]=u->contact_makers[0];
+        row[j++]=u->new_comm_cases;
+        row[j++]=u->new_hh_cases;
+        for (unsigned int k=0; k<wo->P->no_place_types; k++) row[j++]=u->new_place_cases[k];
+        row[j++]=u->new_comm_infs;
+        row[j++]=u->new_hh_infs;
+        for (unsigned int k=0; k<wo->P->no_place_types; k++) row[j++]=u->new_place_infs[k];
+        row[j++]=u->current_symptomatic_inf;
+        row[j++]=u->current_nonsymptomatic_inf;
+        job->no_rows++;
       }
     }
   }
-  fflush(wo->ff);
+  wo->writer->submit(job);              // Formatted and written by the writer thread - see writer.cpp
 }
 
 void logDB(world *wo) {
-  int* dbdata;
+  // Copy the rows for this timestep into a writer job - batched into the database by the writer thread.
   unsigned int j;
   int i;
-  
+  writerJob* job = wo->writer->claim(JOB_DB);
+  if (job->max_rows<wo->no_units) {
+    delete[] job->rows;
+    job->max_rows=wo->no_units;
+    job->rows = new int[job->max_rows*wo->writer->row_width];
+  }
   for (i=0; i<wo->no_units; i++) {
     if (wo->a_units[i].log) {
       
@@ -91,10 +113,9 @@ void logDB(world *wo) {
         }
       }
 
-      if (ok) {
+      if (ok) {                       // Don't put all-ZERO data into database.
+        int* dbdata = &job->rows[job->no_rows*wo->writer->row_width];
         j=0;
-
-        dbdata = new int[9+(2*wo->P->no_place_types)];
         dbdata[j++]=(int) wo->T;
         dbdata[j++]=i;
         dbdata[j++]=wo->a_units[i].contact_makers[0];
@@ -108,12 +129,11 @@ void logDB(world *wo) {
           dbdata[j++]=wo->a_units[i].new_place_cases[k];
           dbdata[j++]=wo->a_units[i].new_place_infs[k];
         }
-        wo->db->InsertRecord(dbdata); // Don't put all-ZERO data into database.
-        delete dbdata;
+        job->no_rows++;
       }
     }
   }
-  wo->db->CommitInsChanges();
+  wo->writer->submit(job);
 }
 
 void resetAllUnitStats(world *wo) {
@@ -140,7 +160,8 @@ void resetAllUnitStats(world *wo) {
 }
 
 
-void resetUnitStats(world *wo) {         // Reset timestep-based counters.
+void resetUnitStats(world *wo) {         // Reset timestep-based counters. Called by the whole team in runSim's parallel region.
+  #pragma omp for schedule(static)
   for (int i=0; i<wo->no_units; i++) {
     unit* u = &wo->a_units[i];
     for (int j=0; j<wo->thread_count; j++) u->contact_makers[j]=0;
@@ -155,11 +176,15 @@ void resetUnitStats(world *wo) {         // Reset timestep-based counters.
     
     // NB - don't reset current_nonsymptomatic_inf / current_symptomatic_inf - these are meant to accumulate.
   }
+  #pragma omp single
+  {
   wo->log_10day_slot++;
   if (wo->log_10day_slot>=10*wo->P->timesteps_per_day) wo->log_10day_slot=0;
+  }
 }
 
-void statsTimestep(world *wo) {                     
+void statsTimestep(world *wo) {                     // Units are independent, so the team shares them out.
+  #pragma omp for schedule(static)
   for (int i=0; i<wo->no_units; i++) {
     for (int j=0; j<wo->thread_count; j++) {
       if (j>0) wo->a_units[i].contact_makers[0]+=wo->a_units[i].contact_makers[j];
@@ -184,90 +209,38 @@ void statsTimestep(world *wo) {
         wo->delta_place_infs[i][j][k]=0;
       }
     }
+
+    // 10-day history for this unit. (This used to be an inner loop over all units, repeated for each unit - the
+    // repeats were no-ops, since each one subtracts and re-adds the same slot.)
+
+    wo->a_units[i].comm_10day_accumulator-=wo->a_units[i].hist_comm_cases[wo->log_10day_slot];
+    for (unsigned int k=0; k<wo->P->no_place_types; k++)
+      wo->a_units[i].place_10day_accumulator[k]-=wo->a_units[i].hist_place_cases[k][wo->log_10day_slot];
+    wo->a_units[i].hh_10day_accumulator-=wo->a_units[i].hist_hh_cases[wo->log_10day_slot];
     
-    for (int i=0; i<wo->no_units; i++) {  
-      wo->a_units[i].comm_10day_accumulator-=wo->a_units[i].hist_comm_cases[wo->log_10day_slot];
-      for (unsigned int k=0; k<wo->P->no_place_types; k++)
-  	    wo->a_units[i].place_10day_accumulator[k]-=wo->a_units[i].hist_place_cases[k][wo->log_10day_slot];
-	    wo->a_units[i].hh_10day_accumulator-=wo->a_units[i].hist_hh_cases[wo->log_10day_slot];
-    
-      wo->a_units[i].comm_10day_accumulator+=wo->a_units[i].new_comm_cases;
-      for (unsigned int k=0; k<wo->P->no_place_types; k++)
-        wo->a_units[i].place_10day_accumulator[k]+=wo->a_units[i].new_place_cases[k];
-      wo->a_units[i].hh_10day_accumulator+=wo->a_units[i].new_hh_cases;
+    wo->a_units[i].comm_10day_accumulator+=wo->a_units[i].new_comm_cases;
+    for (unsigned int k=0; k<wo->P->no_place_types; k++)
+      wo->a_units[i].place_10day_accumulator[k]+=wo->a_units[i].new_place_cases[k];
+    wo->a_units[i].hh_10day_accumulator+=wo->a_units[i].new_hh_cases;
 
-      wo->a_units[i].hist_comm_cases[wo->log_10day_slot]=wo->a_units[i].new_comm_cases;
-      for (unsigned int k=0; k<wo->P->no_place_types; k++)
-        wo->a_units[i].hist_place_cases[k][wo->log_10day_slot]=wo->a_units[i].new_place_cases[k];
-      wo->a_units[i].hist_hh_cases[wo->log_10day_slot]=wo->a_units[i].new_hh_cases;
-    }
+    wo->a_units[i].hist_comm_cases[wo->log_10day_slot]=wo->a_units[i].new_comm_cases;
+    for (unsigned int k=0; k<wo->P->no_place_types; k++)
+      wo->a_units[i].hist_place_cases[k][wo->log_10day_slot]=wo->a_units[i].new_place_cases[k];
+    wo->a_units[i].hist_hh_cases[wo->log_10day_slot]=wo->a_units[i].new_hh_cases;
   }
 }
 
 
 void updateImage(world *wo) {
-  int thread_no,total_inf, total_imm,x,y,z;
-
-  #pragma omp parallel for private (thread_no,total_inf,total_imm,x,y,z)
-  for (thread_no=0; thread_no<wo->thread_count; thread_no++) {
-    for (x=thread_no; x<PNG_WIDTH; x+=wo->thread_count) {
-      for (y=0; y<PNG_HEIGHT; y++) {
-        total_inf=0;
-        total_imm=0;
-        for (z=0; z<wo->thread_count; z++) {
-          total_inf+=wo->infected_grid[x][y][z];
-          total_imm+=wo->immune_grid[x][y][z];
-        }
-          
-        if (total_inf+total_imm==0) {
-          wo->image[(PNG_WIDTH*y)+x]=(unsigned char) 0;
-        } else {
-          unsigned char val = (unsigned char) (1+(254.0*((float)total_imm/(total_imm+total_inf))));
-          wo->image[(PNG_WIDTH*y)+x]=val;
-        }
-      }
-    }
-  }
+  wo->grid->update(wo);                      // Only the tiles whose counts changed - see imagegrid.cpp
 }
 
 void saveImage(world *wo) {
-  string filename;
-  filename.append(wo->mv_path);
-  filename.append("/");
-  filename.append(wo->mv_file);
-  std::stringstream noConverter;
-  int no = (int) ((float)wo->T/wo->P->timestep_hours);
-  if (no<1000) filename.append("0");
-  if (no<100) filename.append("0");
-  if (no<10) filename.append("0");
-  noConverter << (no);
-  filename.append(noConverter.str());
-  filename.append(".png");
-  char* fpointer = &filename[0];
-
-  //create encoder and set settings and info (optional)
-  
-  LodePNG::Encoder encoder;
-  encoder.addPalette((unsigned char)0, (unsigned char)0, (unsigned char)0, (unsigned char)0);
-  
-  for (int i=0; i<127; i++) encoder.addPalette((unsigned char)255,(unsigned char)i*2,(unsigned char) 0,(unsigned char)255);
-  for (int i=0; i<127; i++) encoder.addPalette((unsigned char)(255-(2*i)),(unsigned char)255,(unsigned char)0,(unsigned char)255);
-
-  encoder.addPalette((unsigned char)0,(unsigned char)255,(unsigned char)0,(unsigned char)255);
-  
-  //both the raw image and the encoded image must get colorType 3 (palette)
-  encoder.getInfoPng().color.colorType = 3; //if you comment this line, and store the palette in InfoRaw instead (use getInfoRaw() in the previous lines), then you get the same image in a RGBA PNG.
-  encoder.getInfoRaw().color.colorType = 3;
-
-  /* end */
-  encoder.getSettings().zlibsettings.windowSize = 2048;
-
-  //encode and save
- 
-  vector<unsigned char> buffer;
-  encoder.encode(buffer, &(wo->image[0]), PNG_WIDTH, PNG_HEIGHT);
-  LodePNG::saveFile(buffer, fpointer);
-  buffer.clear();
+  // Hand a copy of the frame to the writer thread, which compresses and saves it - see writer.cpp
+  writerJob* job = wo->writer->claim(JOB_IMAGE);
+  job->frame = (int) ((float)wo->T/wo->P->timestep_hours);
+  memcpy(job->image,wo->grid->frame,PNG_WIDTH*PNG_HEIGHT);
+  wo->writer->submit(job);
 }
 
 void initDB(world* w) {
@@ -285,6 +258,6 @@ void initDB(world* w) {
         cerr << "Error initialising database\n";
     }
     MPI_Barrier(MPI_COMM_WORLD);  // Make sure DB is created before binding parameters etc.
-    w->db->PrepareSQLInsertStmt();
+    w->db->PrepareSQLInsertStmt(DB_ARRAY_ROWS);
   }
 }
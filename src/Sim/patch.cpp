@@ -21,7 +21,9 @@
 localPatch::~localPatch() {
   delete [] q_prob;
   delete [] q_patch;
-  delete [] households;
+#ifndef COMPACT_PEOPLE
+  delete [] households;     // (Otherwise a slice of household::all)
+#endif
   delete [] people;
   
 }
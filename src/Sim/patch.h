@@ -60,6 +60,7 @@ class localPatch : public patch {
 
 
     int no_people;
+    int no_susceptible;        // Susceptibles among people, as of the end of the last timestep - see susceptibles.cpp
     int no_households;
     int rem_no_households;
     float p_visitor;
@@ -33,39 +33,37 @@ bool person::isSusceptible(int delta_status) {
 }
 
 float person::getSusceptibility(world* w,int thread_no) {
-  double susc = susceptibility;
+  // The unit caches the multiplier for each prophylaxis/vaccination state - see unit::updateMultipliers.
+  household* house = getHouse();
+  int state=((status & VACCINATED)>0)?MUL_VACC:0;
   if ((status & PROPHYLAXED)>0) {
-    if (house->pph_start>=0) {
-      if ((w->T>=house->pph_start) && (w->T<=house->pph_end)) {
-        susc*=w->a_units[house->unit].pph_susc;
-      }
+    if (house->getPphStart()>=0) {
+      if ((w->T>=house->getPphStart()) && (w->T<=house->getPphEnd())) state+=MUL_PPH;
     } else {
-      if (w->places[house->country][place_type].at(place)->pph_start>=0) {
-        if ((w->T>=w->places[house->country][place_type].at(place)->pph_start) &&
-            (w->T<=w->places[house->country][place_type].at(place)->pph_end)) {
-          susc*=w->a_units[house->unit].pph_susc;
-        }
-      }
+      ::place* e = w->places[house->country][place_type].at(place);
+      if ((e->pph_start>=0) && (w->T>=e->pph_start) && (w->T<=e->pph_end)) state+=MUL_PPH;
     }
   }
+  return (float) (getBaseSusceptibility(w)*w->a_units[house->unit].susc_mul[state]);
+}
 
-  if ((status & VACCINATED)>0) {
-    susc*=w->a_units[house->unit].v_m_susc;
-  }
-  return (float) susc;
+#ifdef COMPACT_PEOPLE
+float person::getBaseSusceptibility(world* w) {
+  return (float) w->init_susceptibility[age_band];
 }
+#endif
 
 person::~person() {}
 
 void infectedPerson::updateStats(world* w,int thread_no, int delta_inf,int delta_imm) {
   
   if ((flags & SYMPTOMATIC)>0)
-    w->a_units[personPointer->house->unit].delta_sympt_case(w,personPointer->house->unit,thread_no,delta_inf);
+    w->a_units[personPointer->getHouse()->unit].delta_sympt_case(w,personPointer->getHouse()->unit,thread_no,delta_inf);
   else
-    w->a_units[personPointer->house->unit].delta_non_sympt_case(w,personPointer->house->unit,thread_no,delta_inf);
+    w->a_units[personPointer->getHouse()->unit].delta_non_sympt_case(w,personPointer->getHouse()->unit,thread_no,delta_inf);
   
-  setInfected(personPointer->house->lon,personPointer->house->lat,delta_inf,thread_no,w);
-  setImmune(personPointer->house->lon,personPointer->house->lat,delta_imm,thread_no,w);
+  setInfected(personPointer->getHouse()->lon,personPointer->getHouse()->lat,delta_inf,thread_no,w);
+  setImmune(personPointer->getHouse()->lon,personPointer->getHouse()->lat,delta_imm,thread_no,w);
 }
 
 infectedPerson::infectedPerson(world* w, int thread_no,person* personPtr) {
@@ -75,32 +73,45 @@ infectedPerson::infectedPerson(world* w, int thread_no,person* personPtr) {
   contacts=NULL;
   contact_order=NULL;
   n_contacts=0;
+  contacts_alloc=0;
   flags=0;
-  double p_sympt_adjust = w->a_units[personPtr->house->unit].p_symptomatic;
+  live_memory[thread_no].infected+=sizeof(infectedPerson);
+  double p_sympt_adjust = w->a_units[personPtr->getHouse()->unit].p_symptomatic;
   
   if ((personPointer->status & VACCINATED)>0) {
-    p_sympt_adjust*=w->a_units[personPointer->house->unit].v_m_clin;
+    p_sympt_adjust*=w->a_units[personPointer->getHouse()->unit].v_m_clin;
   }
 
   if ((personPointer->status & PROPHYLAXED)>0) {
-    p_sympt_adjust*=w->a_units[personPointer->house->unit].pph_clin;
+    p_sympt_adjust*=w->a_units[personPointer->getHouse()->unit].pph_clin;
   }
 
   if (ranf_mt(thread_no)<p_sympt_adjust) {
     flags+=SYMPTOMATIC;
-    if (ranf_mt(thread_no)<w->a_units[personPtr->house->unit].p_severe) {
+    if (ranf_mt(thread_no)<w->a_units[personPtr->getHouse()->unit].p_severe) {
       flags+=SEVERE;
-      if (ranf_mt(thread_no)<w->a_units[personPtr->house->unit].p_detect_severe) flags+=DETECTED;
+      if (ranf_mt(thread_no)<w->a_units[personPtr->getHouse()->unit].p_detect_severe) flags+=DETECTED;
     } else {
-      if (ranf_mt(thread_no)<w->a_units[personPtr->house->unit].p_detect_sympt) flags+=DETECTED;
+      if (ranf_mt(thread_no)<w->a_units[personPtr->getHouse()->unit].p_detect_sympt) flags+=DETECTED;
     }
   }
 }
 
 infectedPerson::~infectedPerson() {
-  if (travel_plan!=NULL) delete travel_plan;
-  if (contacts!=NULL) delete [] contacts;
-  if (contact_order!=NULL) delete [] contact_order;
+  liveMemory* live = &live_memory[omp_get_thread_num()];
+  live->infected-=sizeof(infectedPerson);
+  if (travel_plan!=NULL) {
+    delete travel_plan;
+    live->travel-=sizeof(travelPlan);
+  }
+  if (contacts!=NULL) {
+    delete [] contacts;
+    live->contacts-=contacts_alloc*sizeof(infectedPerson*);
+  }
+  if (contact_order!=NULL) {
+    delete [] contact_order;
+    live->contacts-=contacts_alloc*sizeof(unsigned short);
+  }
 }
 
 double infectedPerson::getInfectiousness(world* w, double t,int thread_no) { 
@@ -108,10 +119,18 @@ double infectedPerson::getInfectiousness(world* w, double t,int thread_no) {
   if (!w->P->infectiousness_fixed) 
     inf_ness = w->P->infectiousness_profile[(int)((t-w->T)/w->P->timestep_hours)];   //NB w->T is now end of incubation period
   
-  unit* u = &w->a_units[personPointer->house->unit];
+  household* house = personPointer->getHouse();
+  unit* u = &w->a_units[house->unit];
 
-  if ((flags & SEVERE)>0) inf_ness*= u->mul_severe_inf;
-  else if ((flags & SYMPTOMATIC)>0) inf_ness*= u->mul_sympt_inf;
+  // Severity, prophylaxis and vaccination multipliers are cached by the unit - see unit::updateMultipliers.
+  // Only the household's prophylaxis window is checked: a place's window never changed infectiousness.
+
+  int state=MUL_SEVERITY*(((flags & SYMPTOMATIC)>0)+((flags & SEVERE)>0));
+  if ((personPointer->status & VACCINATED)>0) state+=MUL_VACC;
+  if ((personPointer->status & PROPHYLAXED)>0) {
+    if ((house->getPphStart()>=0) && (w->T>=house->getPphStart()) && (w->T<=house->getPphEnd())) state+=MUL_PPH;
+  }
+  inf_ness*=u->inf_mul[state];
 
   // Deal with "instantaneous" treatment effects.
   
@@ -122,22 +141,6 @@ double infectedPerson::getInfectiousness(world* w, double t,int thread_no) {
       }
     }
   }
-  
-  if ((personPointer->status & PROPHYLAXED)>0) {
-    if (personPointer->house->pph_start>=0) {
-      if ((w->T>=personPointer->house->pph_start) && (w->T<=personPointer->house->pph_end)) {
-        if (ranf_mt(thread_no)<u->pph_household) inf_ness*=u->pph_inf;
-      }
-    } else if (w->places[personPointer->house->country][personPointer->place_type].at(personPointer->place)->pph_start>=0) {
-      if ((w->T>=personPointer->house->pph_start) && (w->T<=personPointer->house->pph_end)) {
-        if (ranf_mt(thread_no)<u->pph_social) inf_ness*=u->pph_inf;
-      }
-    }
-  }
-
-  if ((personPointer->status & VACCINATED)>0) {
-    if (w->T>=u->v_start) inf_ness*=u->v_m_inf;
-  }
   return inf_ness;
 }
 
@@ -148,7 +151,7 @@ void infectedPerson::createTravelPlan(world* w, infectedPerson* p, int thread_no
   double p_visit = ranf_mt(thread_no);
   
   
-  if ((p_travel<(p->t_inf/24.0)*w->prob_travel[p->personPointer->house->country]) && (p_visit<(p->t_inf/24.0)*w->prob_visit[p->personPointer->house->country])) {
+  if ((p_travel<(p->t_inf/24.0)*w->prob_travel[p->personPointer->getHouse()->country]) && (p_visit<(p->t_inf/24.0)*w->prob_visit[p->personPointer->getHouse()->country])) {
     if (ranf_mt(thread_no)<0.5) {
       p_travel=1*(p->t_inf/24.0);     // Ensure that p_travel fails
       p_visit=0;
@@ -159,18 +162,19 @@ void infectedPerson::createTravelPlan(world* w, infectedPerson* p, int thread_no
     }
   }
 
-  if (p_travel<(1-exp(-(p->t_inf/24.0)*w->prob_travel[p->personPointer->house->country]))) {
+  if (p_travel<(1-exp(-(p->t_inf/24.0)*w->prob_travel[p->personPointer->getHouse()->country]))) {
     double destination = ranf_mt(thread_no);
     int index=0;
-    while ((index<w->no_countries) && (w->prob_dest[p->personPointer->house->country][index]<destination)) index++;
+    while ((index<w->no_countries) && (w->prob_dest[p->personPointer->getHouse()->country][index]<destination)) index++;
     if (index>=w->no_countries) {
       printf("%d,%d Time=%d, Had to correct index\n",w->mpi_rank,thread_no,w->T);
       fflush(stdout);
       index=w->no_countries-1;
     }
     p->travel_plan=new travelPlan();
+    live_memory[thread_no].travel+=sizeof(travelPlan);
     p->travel_plan->traveller=TRAVELLER;
-    p->travel_plan->country=w->prob_dest_country[p->personPointer->house->country][index];
+    p->travel_plan->country=w->prob_dest_country[p->personPointer->getHouse()->country][index];
     p->travel_plan->duration=(float) (ranf_mt(thread_no)*p->t_inf);
     p->travel_plan->t_start=(float) (latent_end+(ranf_mt(thread_no)*p->t_inf));
     if ((p->travel_plan->t_start+p->travel_plan->duration)>latent_end+p->t_inf) {
@@ -178,7 +182,7 @@ void infectedPerson::createTravelPlan(world* w, infectedPerson* p, int thread_no
     }
     
     if ((p->travel_plan->country<0) || (p->travel_plan->country>w->no_countries)) {
-      printf("%d,%d: Time=%d, Country error: index=%d, p->tp->country=%d, p->country=%d\n",w->mpi_rank,thread_no,w->T,index,p->travel_plan->country,p->personPointer->house->country);
+      printf("%d,%d: Time=%d, Country error: index=%d, p->tp->country=%d, p->country=%d\n",w->mpi_rank,thread_no,w->T,index,p->travel_plan->country,p->personPointer->getHouse()->country);
       fflush(stdout);
     }
     unsigned int total_people = 0;
@@ -205,15 +209,16 @@ void infectedPerson::createTravelPlan(world* w, infectedPerson* p, int thread_no
       fflush(stdout);
     }
 
-  } else if (p_visit<(1-exp(-(p->t_inf/24.0)*w->prob_visit[p->personPointer->house->country]))) {
+  } else if (p_visit<(1-exp(-(p->t_inf/24.0)*w->prob_visit[p->personPointer->getHouse()->country]))) {
     double origin = ranf_mt(thread_no);
     int index=0;
-    while ((index<w->no_countries) && (w->prob_orig[p->personPointer->house->country][index]<origin)) index++;
+    while ((index<w->no_countries) && (w->prob_orig[p->personPointer->getHouse()->country][index]<origin)) index++;
   
     if (index>=w->no_countries) index--;
     p->travel_plan=new travelPlan();
+    live_memory[thread_no].travel+=sizeof(travelPlan);
     p->travel_plan->traveller=VISITOR;
-    p->travel_plan->country=w->prob_orig_country[p->personPointer->house->country][index];
+    p->travel_plan->country=w->prob_orig_country[p->personPointer->getHouse()->country][index];
     p->travel_plan->duration=(float) (ranf_mt(thread_no)*p->t_inf);
     p->travel_plan->t_start=(float) latent_end;
 
@@ -267,26 +272,27 @@ void infectedPerson::locateTravel(world* w, infectedPerson* ip, int thread_no) {
 
 localPatch* infectedPerson::getPatchForPerson(world* w, int person, unsigned char country, int thread_no) {
   
-  int patch_no = 0;
-  int people_count = person;
-  while ((patch_no<w->country_patch_pop[country].size()) && (people_count>w->country_patch_pop[country].at(patch_no))) {
-    people_count-=w->country_patch_pop[country].at(patch_no);
-    patch_no++;
+  // First patch whose running total reaches 'person' - binary search over country_patch_cum.
+  int lo = 0;
+  int hi = (int) w->country_patch_pop[country].size()-1;
+  while (lo<hi) {
+    int mid = (lo+hi)/2;
+    if (w->country_patch_cum[country][mid]<person) lo=mid+1;
+    else hi=mid;
   }
-  if (patch_no>=w->country_patch_pop[country].size()) patch_no--;
-  return w->localPatchList[w->patches_in_country[country].at(patch_no)];
+  return w->localPatchList[w->patches_in_country[country].at(lo)];
 
 }
 
 void infectedPerson::setFlags(world* w, int thread_no) {
   flags=0;
-  if (ranf_mt(thread_no)<w->a_units[personPointer->house->unit].p_symptomatic) {
+  if (ranf_mt(thread_no)<w->a_units[personPointer->getHouse()->unit].p_symptomatic) {
     flags=flags + SYMPTOMATIC;
-    if (ranf_mt(thread_no)<w->a_units[personPointer->house->unit].p_severe) {
+    if (ranf_mt(thread_no)<w->a_units[personPointer->getHouse()->unit].p_severe) {
       flags = flags + SEVERE;
-      if (ranf_mt(thread_no)<w->a_units[personPointer->house->unit].p_detect_severe) flags=flags + DETECTED;
+      if (ranf_mt(thread_no)<w->a_units[personPointer->getHouse()->unit].p_detect_severe) flags=flags + DETECTED;
     } else {
-      if (ranf_mt(thread_no)<w->a_units[personPointer->house->unit].p_detect_sympt) flags=flags + DETECTED;
+      if (ranf_mt(thread_no)<w->a_units[personPointer->getHouse()->unit].p_detect_sympt) flags=flags + DETECTED;
     }
   }
 }
@@ -40,6 +40,24 @@ class world;
 
 class person {
   public:
+#ifdef COMPACT_PEOPLE
+    // 12 bytes per person. Use getHouse()/setHouse() rather than the index, and getAgeBand() for age.
+    unsigned int hh;                        // Index of the person's household in household::all (node-wide)
+    unsigned int place;                     // Index into that place_type (for person's country)
+    unsigned int status:9;                  // Status of infection (STATUS_ and intervention flags below)
+    unsigned int place_type:3;              // Which place is the person member of (PLACE_TYPE_NONE if the file gave >=7)
+    unsigned int age_band:5;                // Index into w->init_susceptibility - the age, quantised to the file's age bands
+    unsigned int group:15;                  // Group number within workplace.
+
+#define PLACE_TYPE_NONE 7
+#define MAX_AGE_BANDS 32
+#define MAX_GROUPS 32767
+
+    inline household* getHouse();           // Defined in household.h (needs both classes complete)
+    inline void setHouse(household* h);
+    inline int getAgeBand() { return age_band; }
+    float getBaseSusceptibility(world* w);
+#else
     household* house;                       // Index of patch->households for the person's household
     float age;                              // The age!
     unsigned short status;                  // Status of infection
@@ -48,6 +66,11 @@ class person {
     unsigned short group;                   // Group number within workplace. (65535 = none)
     float susceptibility;                   // Susceptibility!
     float vaccination_mul;                  // Multiply susceptibility by this vaccination factor
+
+    inline household* getHouse() { return house; }
+    inline void setHouse(household* h) { house=h; }
+    inline float getBaseSusceptibility(world* w) { return susceptibility; }
+#endif
     
     bool isSusceptible(int delta_status);
     float getSusceptibility(world* w,int thread_no);
@@ -70,9 +93,13 @@ class person {
     
 };
 
+#define PERSON_CLASS_DEFINED
+#include "household_inline.h"
+
 class infectedPerson {
   public:
     unsigned short n_contacts;
+    unsigned short contacts_alloc;  // Size of contacts and contact_order - n_contacts may be cut afterwards
     infectedPerson** contacts;
     unsigned short* contact_order;
     travelPlan* travel_plan;
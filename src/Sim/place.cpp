@@ -22,6 +22,9 @@ place::place() {
   pph_start=-1;       // Default: prophylax is off
   closure_start=-1;   //          closure is off
   acc_cases=0;        //          accumulated cases since last intervention is zero
+  no_nodes=0;
+  first_group=0;
+  first_node_count=0;
 }
 
 place::~place() {
@@ -29,11 +32,12 @@ place::~place() {
 }
 
 void place::applyProphylaxis(world* w, int thread_no, unsigned char place_type, int est_no) {
-  int node_index=0;     // Usually, no_nodes=1, and no_hosts[0] is the number of hosts on this node.
-  if (no_nodes>1) node_index=w->mpi_rank;  // However, if no_nodes>1, then we want no_hosts[our rank]
+  placeList* pl = &w->places[country][place_type];
   for (unsigned int i=0; i<no_groups; i++) {
-    for (unsigned int j=0; j<group_member_node_count[i][node_index]; i++) {
-      person* p = this->local_members[i][j];
+    person** members = pl->groupMembers(this,i);       // Members of group i on this node
+    unsigned int n = pl->localMembers(this,i);
+    for (unsigned int j=0; j<n; j++) {
+      person* p = members[j];
       if (ranf_mt(thread_no)<w->a_units[unit].pph_social) {        // pph_social is probability of host being prophylaxed due to establishment
         if ((p->status & PROPHYLAXED) ==0) p->status += PROPHYLAXED;   // and only do it if they've not been prophylaxed already
       }
@@ -51,13 +55,14 @@ void place::applyProphylaxis(world* w, int thread_no, unsigned char place_type,
   }
 }
 
-void place::applyProphylaxisRemote(world* w,int thread_no, float start, float end) {
+void place::applyProphylaxisRemote(world* w,int thread_no, unsigned char place_type, float start, float end) {
   // This is called when a message is received saying prophylaxis has happened for this establishment, on another node.
-  int node_index=0;     // Usually, no_nodes=1, and no_hosts[0] is the number of hosts on this node.
-  if (no_nodes>1) node_index=w->mpi_rank;  // However, if no_nodes>1, then we want no_hosts[our rank]
+  placeList* pl = &w->places[country][place_type];
   for (unsigned int i=0; i<no_groups; i++) {
-    for (unsigned int j=0; j<group_member_node_count[i][node_index]; j++) {
-      person* p= local_members[i][j];
+    person** members = pl->groupMembers(this,i);
+    unsigned int n = pl->localMembers(this,i);
+    for (unsigned int j=0; j<n; j++) {
+      person* p= members[j];
       if (ranf_mt(thread_no)<w->a_units[unit].pph_social) {        // pph_social is probability of host being prophylaxed due to establishment
         if ((p->status & PROPHYLAXED) ==0) p->status += PROPHYLAXED;   // and only do it if they've not been prophylaxed already
       }
@@ -93,3 +98,29 @@ void place::applyClosureRemote(world* w, float start, float end) {
   closure_start=start;
   closure_end=end;
 }
+
+placeList::placeList() {
+  no_places=0;
+  list=NULL;
+  no_groups=0;
+  group_member_count=NULL;
+  group_first_host=NULL;
+  node_first_host=NULL;
+  member_start=NULL;
+  members=NULL;
+}
+
+placeList::~placeList() {
+  delete[] list;
+  delete[] group_member_count;
+  delete[] group_first_host;
+  delete[] node_first_host;
+  delete[] member_start;
+  delete[] members;
+}
+
+void placeList::allocate(unsigned int places) {
+  // The group and member arrays are sized later, once the households have been read - see linkPeopleToEstablishments.
+  no_places=places;
+  list = new place[places];
+}
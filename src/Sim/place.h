@@ -26,26 +26,20 @@
 
 
 class person;
+class placeList;
 
 class place {
   public:
     double lat;                 // Latitude of establishment
     double lon;                 // Longitude of establishment
     unsigned char country;
-    unsigned char no_nodes;     // How many nodes are repesented
-    unsigned int** no_hosts;    // No. of members in establishment for each node, for each group. (Node index Length either 1, or mpi_rank, as most ests will be on one node)
+    unsigned char no_nodes;     // How many nodes are repesented (0, 1, or mpi_size)
     unsigned int total_hosts;   // Total number of hosts in this establishment
     unsigned int unit;          // Admin unit containing establishment
     unsigned int no_groups;     // No. of workgroups or classes within establishment.
+    unsigned int first_group;   // Index of this place's group 0 in its placeList's group arrays
+    unsigned int first_node_count;  // Index of this place's [group 0][node 0] in placeList::node_count
 
-    unsigned int* group_member_count;       // [group] - number of members in each group. (With Extra index for group -1)
-    unsigned int** group_member_node_count; // [group][node] - number of members in each node.
-
-    person*** local_members;     // [group][person] - pointers to people in each group on *this* node.
-
-
-
-    
     unsigned int acc_cases;     // Accumulate no. of cases
     float pph_start;           // Start of prophylaxis (delay included) (hours)
     float pph_end;             // End of prophylax period (hours)
@@ -56,12 +50,57 @@ class place {
 
 
     void applyProphylaxis(world* w, int thread_no, unsigned char place_type, int est_no);
-    void applyProphylaxisRemote(world* w,int thread_no, float start, float end);
+    void applyProphylaxisRemote(world* w,int thread_no, unsigned char place_type, float start, float end);
     void applyClosure(world* w, int thread_no, int unit, unsigned char place_type, int est_no);
     void applyClosureRemote(world* w, float start, float end);
     place();
     ~place();
     
 };
+
+// All the places of one type in one country, with their groups and members flattened into a few arrays
+// (compressed sparse rows), rather than allocating per place and per group. For place e, group g:
+//
+//   group_member_count[e->first_group+g]  - members on all nodes
+//   group_first_host[e->first_group+g]    - members (on all nodes) of e's groups before g
+//   node_first_host[e->first_node_count+(g*e->no_nodes)+n] - members (on all nodes) of e before group g node n
+//                                         (n=0 if no_nodes==1), ie. the cumulative count used to search for a host
+//   members[member_start[e->first_group+g] ... member_start[e->first_group+g+1]-1] - members on this node
+
+class placeList {
+  public:
+    unsigned int no_places;
+    place* list;                        // [place]
+    unsigned int no_groups;             // Groups of all places
+    unsigned int* group_member_count;   // [group]
+    unsigned int* group_first_host;     // [group]
+    unsigned int* node_first_host;      // [group][node], no_nodes entries per group
+    unsigned int* member_start;         // [group], plus one at the end
+    person** members;                   // Local members of all groups, in group order
+
+    place* at(unsigned int i) { return &list[i]; }
+    person** groupMembers(place* e, unsigned int g) { return &members[member_start[e->first_group+g]]; }
+    unsigned int localMembers(place* e, unsigned int g) { return member_start[e->first_group+g+1]-member_start[e->first_group+g]; }
+    unsigned int findHost(place* e, unsigned int host_no, unsigned int lo, unsigned int hi, int* group, int* node, SIM_I64* probes);
+    void allocate(unsigned int places);
+    placeList();
+    ~placeList();
+};
+
+inline unsigned int placeList::findHost(place* e, unsigned int host_no, unsigned int lo, unsigned int hi, int* group, int* node, SIM_I64* probes) {
+  // Find the group and node of host host_no (numbered over all nodes, group by group, then node by node), searching
+  // entries lo..hi-1 of e's [group][node] row - the whole row, or just one group's nodes if the group is known.
+  // Returns the host's index among that group's members on that node. Binary search; single-node groups need none.
+  unsigned int* first = &node_first_host[e->first_node_count];
+  while (hi-lo>1) {                    // first[lo]<=host_no<first[hi]
+    unsigned int mid=(lo+hi)/2;
+    if (first[mid]<=host_no) lo=mid;
+    else hi=mid;
+    (*probes)++;
+  }
+  *group=lo/e->no_nodes;
+  *node=lo%e->no_nodes;
+  return host_no-first[lo];
+}
     
 #endif
@@ -0,0 +1,286 @@
+/* pngframe.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Fast palette PNG encoder for movie frames, and the run-length frame format
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#include <string.h>
+#include "omp.h"
+#include "pngframe.h"
+
+// Frames used to go through a fresh LodePNG encoder each time - palette rebuilt, a general-purpose LZ77 search with
+// a 2048-byte window, one thread. Movie frames are mostly runs of one colour, and a pixel is usually the same as the
+// one above it, so here the only matches tried are the previous byte (runs) and the same byte in the row above, with
+// deflate's fixed Huffman codes. That is far cheaper and compresses these images about as well.
+//
+// The rows are cut into FRAME_STRIPS strips, deflated in parallel. Each strip is a fixed-code block, and all but the
+// last end with an empty stored block so the next starts on a byte boundary - so the strips' output can simply be
+// joined. A strip's matches may reach back into the strip before (the decoder has it already), so the output is the
+// same whatever the number of threads. Rows use filter type 0, as the PNG spec recommends for palette images.
+
+static unsigned short len_code[259];             // Match length -> (symbol-257)
+static const unsigned short len_base[29] = {3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258};
+static const unsigned char len_extra[29] = {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+static const unsigned short dist_base[30] = {1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,
+                                             4097,6145,8193,12289,16385,24577};
+static const unsigned char dist_extra[30] = {0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+static unsigned short lit_bits[288];             // Fixed Huffman codes, bit-reversed for the LSB-first stream
+static unsigned char lit_len[288];
+static bool tables_made=false;
+
+static unsigned int reverseBits(unsigned int code, int len) {
+  unsigned int r=0;
+  for (int i=0; i<len; i++) r|=((code>>i)&1)<<(len-1-i);
+  return r;
+}
+
+static void makeTables() {
+  for (int s=0; s<288; s++) {
+    if (s<144) { lit_len[s]=8; lit_bits[s]=(unsigned short) reverseBits(0x30+s,8); }
+    else if (s<256) { lit_len[s]=9; lit_bits[s]=(unsigned short) reverseBits(0x190+(s-144),9); }
+    else if (s<280) { lit_len[s]=7; lit_bits[s]=(unsigned short) reverseBits(s-256,7); }
+    else { lit_len[s]=8; lit_bits[s]=(unsigned short) reverseBits(0xC0+(s-280),8); }
+  }
+  for (int c=0; c<29; c++) {
+    int top=(c<28)?len_base[c+1]:259;
+    for (int l=len_base[c]; l<top; l++) len_code[l]=(unsigned short) c;
+  }
+  len_code[258]=28;
+  tables_made=true;
+}
+
+struct bitWriter {                               // Deflate's LSB-first bit stream
+  std::vector<unsigned char>* out;
+  unsigned long long bits;
+  int no_bits;
+  inline void put(unsigned int value, int len) {
+    bits|=((unsigned long long) value)<<no_bits;
+    no_bits+=len;
+    while (no_bits>=8) {
+      out->push_back((unsigned char) bits);
+      bits>>=8;
+      no_bits-=8;
+    }
+  }
+  inline void align() { if (no_bits>0) put(0,8-no_bits); }
+};
+
+frameEncoder::frameEncoder(int _width, int _height, int _threads) {
+  width=_width;
+  height=_height;
+  threads=(_threads<1)?1:_threads;
+  if (!tables_made) makeTables();
+  for (unsigned int n=0; n<256; n++) {
+    unsigned int c=n;
+    for (int k=0; k<8; k++) c=(c&1)?(0xEDB88320u^(c>>1)):(c>>1);
+    crc_table[n]=c;
+  }
+  filtered.resize((size_t) height*(width+1));
+
+  static const unsigned char signature[8] = {137,80,78,71,13,10,26,10};
+  head.insert(head.end(),signature,signature+8);
+  unsigned char ihdr[13] = {(unsigned char) (width>>24),(unsigned char) (width>>16),(unsigned char) (width>>8),(unsigned char) width,
+                            (unsigned char) (height>>24),(unsigned char) (height>>16),(unsigned char) (height>>8),(unsigned char) height,
+                            8,3,0,0,0};  // 8-bit palette, deflate, filter method 0, no interlace
+  chunk(head,"IHDR",ihdr,13);
+  unsigned char plte[768];                       // The movie palette: clear, then red to yellow to green by immune fraction
+  unsigned char* p=plte;
+  *p++=0; *p++=0; *p++=0;
+  for (int i=0; i<127; i++) { *p++=255; *p++=(unsigned char) (i*2); *p++=0; }
+  for (int i=0; i<127; i++) { *p++=(unsigned char) (255-(2*i)); *p++=255; *p++=0; }
+  *p++=0; *p++=255; *p++=0;
+  chunk(head,"PLTE",plte,768);
+  unsigned char trns[1] = {0};                   // Only colour 0 is transparent
+  chunk(head,"tRNS",trns,1);
+}
+
+unsigned int frameEncoder::crc(unsigned int c, const unsigned char* data, size_t bytes) {
+  for (size_t i=0; i<bytes; i++) c=crc_table[(c^data[i])&0xFF]^(c>>8);
+  return c;
+}
+
+void frameEncoder::chunk(std::vector<unsigned char>& png, const char* type, const unsigned char* data, unsigned int bytes) {
+  unsigned char len[4] = {(unsigned char) (bytes>>24),(unsigned char) (bytes>>16),(unsigned char) (bytes>>8),(unsigned char) bytes};
+  png.insert(png.end(),len,len+4);
+  unsigned int c=crc(0xFFFFFFFFu,(const unsigned char*) type,4);
+  png.insert(png.end(),type,type+4);
+  if (bytes>0) {
+    c=crc(c,data,bytes);
+    png.insert(png.end(),data,data+bytes);
+  }
+  c^=0xFFFFFFFFu;
+  unsigned char sum[4] = {(unsigned char) (c>>24),(unsigned char) (c>>16),(unsigned char) (c>>8),(unsigned char) c};
+  png.insert(png.end(),sum,sum+4);
+}
+
+void frameEncoder::deflateStrip(int s) {
+  const int row_bytes=width+1;
+  const int rows=(height+FRAME_STRIPS-1)/FRAME_STRIPS;
+  const long long start=(long long) s*rows*row_bytes;
+  long long end=(long long) (s+1)*rows*row_bytes;
+  if (end>(long long) filtered.size()) end=(long long) filtered.size();
+  const unsigned char* buf=&filtered[0];
+  const bool last=(s==FRAME_STRIPS-1);
+
+  unsigned long long a=1,b=0;                    // Adler-32 of this strip alone - combined in encodePNG
+  for (long long i=start; i<end; i++) {
+    a+=buf[i];
+    b+=a;
+    if (((i-start)&65535)==65535) { a%=65521; b%=65521; }
+  }
+  adler[s]=(unsigned int) (((b%65521)<<16)|(a%65521));
+
+  std::vector<unsigned char>& out=strips[s];
+  out.clear();
+  if (start>=end) {                              // More strips than rows - an empty block keeps the stream whole
+    bitWriter bw = {&out,0,0};
+    bw.put(last?3:2,3);
+    bw.put(lit_bits[256],lit_len[256]);
+    if (!last) { bw.put(0,3); bw.align(); bw.put(0,16); bw.put(0xFFFF,16); }
+    bw.align();
+    return;
+  }
+  out.reserve((size_t) ((end-start)/8)+64);
+  bitWriter bw = {&out,0,0};
+  bw.put(last?3:2,3);                            // BFINAL, BTYPE=01 (fixed codes)
+  long long i=start;
+  while (i<end) {
+    int best=0,best_dist=0;
+    int limit=(int) ((end-i<258)?(end-i):258);
+    if (i>0) {
+      int l=0;
+      while ((l<limit) && (buf[i+l]==buf[i-1])) l++;
+      best=l;
+      best_dist=1;
+    }
+    if ((i>=row_bytes) && (best<limit)) {
+      int l=0;
+      const unsigned char* above=&buf[i-row_bytes];
+      while ((l<limit) && (buf[i+l]==above[l])) l++;
+      if (l>best) { best=l; best_dist=row_bytes; }
+    }
+    if (best>=3) {
+      int lc=len_code[best];
+      bw.put(lit_bits[257+lc],lit_len[257+lc]);
+      if (len_extra[lc]>0) bw.put(best-len_base[lc],len_extra[lc]);
+      int dc=0;
+      while ((dc<29) && (dist_base[dc+1]<=best_dist)) dc++;
+      bw.put(reverseBits(dc,5),5);
+      if (dist_extra[dc]>0) bw.put(best_dist-dist_base[dc],dist_extra[dc]);
+      i+=best;
+    } else {
+      bw.put(lit_bits[buf[i]],lit_len[buf[i]]);
+      i++;
+    }
+  }
+  bw.put(lit_bits[256],lit_len[256]);            // End of block
+  if (!last) {                                   // Empty stored block: byte-aligns the end of the strip
+    bw.put(0,3);
+    bw.align();
+    bw.put(0,16);
+    bw.put(0xFFFF,16);
+  }
+  bw.align();
+}
+
+void frameEncoder::encodePNG(const unsigned char* image, std::vector<unsigned char>& png) {
+  const int row_bytes=width+1;
+  int s;
+  #pragma omp parallel num_threads(threads)
+  {
+  int r;
+  #pragma omp for schedule(static)
+  for (r=0; r<height; r++) {
+    filtered[(size_t) r*row_bytes]=0;            // Filter type 0
+    memcpy(&filtered[((size_t) r*row_bytes)+1],&image[(size_t) r*width],width);
+  }
+  #pragma omp for schedule(dynamic,1)            // After the barrier - a strip's matches look back into the one before
+  for (s=0; s<FRAME_STRIPS; s++) deflateStrip(s);
+  }
+
+  unsigned int sum=adler[0];
+  const int rows=(height+FRAME_STRIPS-1)/FRAME_STRIPS;
+  for (s=1; s<FRAME_STRIPS; s++) {               // zlib's adler32_combine
+    long long first=(long long) s*rows*row_bytes;
+    long long last=(long long) (s+1)*rows*row_bytes;
+    if (last>(long long) filtered.size()) last=(long long) filtered.size();
+    if (first>=last) continue;
+    unsigned int rem=(unsigned int) ((last-first)%65521);
+    unsigned int s1=sum&0xFFFF;
+    unsigned int s2=(unsigned int) (((unsigned long long) rem*s1)%65521);
+    s1+=(adler[s]&0xFFFF)+65521-1;
+    s2+=((sum>>16)&0xFFFF)+((adler[s]>>16)&0xFFFF)+65521-rem;
+    if (s1>=65521) s1-=65521;
+    if (s1>=65521) s1-=65521;
+    if (s2>=(65521u<<1)) s2-=(65521u<<1);
+    if (s2>=65521) s2-=65521;
+    sum=s1|(s2<<16);
+  }
+
+  std::vector<unsigned char> idat;
+  size_t bytes=6;
+  for (s=0; s<FRAME_STRIPS; s++) bytes+=strips[s].size();
+  idat.reserve(bytes);
+  idat.push_back(0x78);                          // zlib header: deflate, 32K window, no dictionary
+  idat.push_back(0x01);
+  for (s=0; s<FRAME_STRIPS; s++) idat.insert(idat.end(),strips[s].begin(),strips[s].end());
+  idat.push_back((unsigned char) (sum>>24));
+  idat.push_back((unsigned char) (sum>>16));
+  idat.push_back((unsigned char) (sum>>8));
+  idat.push_back((unsigned char) sum);
+
+  png.clear();
+  png.reserve(head.size()+idat.size()+24);
+  png.insert(png.end(),head.begin(),head.end());
+  chunk(png,"IDAT",&idat[0],(unsigned int) idat.size());
+  chunk(png,"IEND",NULL,0);
+}
+
+void frameEncoder::encodeRLE(const unsigned char* image, std::vector<unsigned char>& rle) {
+  rle.clear();
+  rle.insert(rle.end(),FRAME_RLE_MAGIC,FRAME_RLE_MAGIC+8);
+  int dims[2] = {width,height};
+  rle.insert(rle.end(),(unsigned char*) dims,((unsigned char*) dims)+sizeof(dims));
+  const size_t n=(size_t) width*height;
+  size_t i=0;
+  while (i<n) {
+    unsigned char v=image[i];
+    size_t j=i+1;
+    while ((j<n) && (image[j]==v) && (j-i<65535)) j++;
+    unsigned short count=(unsigned short) (j-i);
+    rle.push_back(v);
+    rle.insert(rle.end(),(unsigned char*) &count,((unsigned char*) &count)+2);
+    i=j;
+  }
+}
+
+bool frameEncoder::decodeRLE(const std::vector<unsigned char>& rle, int& w, int& h, std::vector<unsigned char>& image) {
+  if ((rle.size()<16) || (memcmp(&rle[0],FRAME_RLE_MAGIC,8)!=0)) return false;
+  memcpy(&w,&rle[8],sizeof(int));
+  memcpy(&h,&rle[12],sizeof(int));
+  if ((w<=0) || (h<=0)) return false;
+  const size_t n=(size_t) w*h;
+  image.resize(n);
+  size_t at=0;
+  for (size_t p=16; p+3<=rle.size(); p+=3) {
+    unsigned short count;
+    memcpy(&count,&rle[p+1],2);
+    if (at+count>n) return false;
+    memset(&image[at],rle[p],count);
+    at+=count;
+  }
+  return (at==n);
+}
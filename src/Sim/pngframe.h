@@ -0,0 +1,56 @@
+/* pngframe.h, part of the Global Epidemic Simulation v1.0 BETA
+/* Fast palette PNG encoder for movie frames, and the run-length frame format
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#ifndef PNGFRAME_H
+#define PNGFRAME_H
+
+#include <stdio.h>
+#include <vector>
+
+#define FRAME_STRIPS 8               // Rows are deflated in this many strips - the output doesn't depend on thread count
+#define FRAME_RLE_MAGIC "GESRLE01"
+
+// Movie frames are 8-bit palette images. frameEncoder makes PNGs of them with the movie palette, and reads and writes
+// the run-length frame format (/moviefmt:rle), which src/MovieConv turns into PNGs after the run.
+//
+// RLE frame: "GESRLE01", int width, int height, then (unsigned char value, unsigned short count) runs, row-major.
+
+class frameEncoder {
+  public:
+    frameEncoder(int width, int height, int threads);
+    void encodePNG(const unsigned char* image, std::vector<unsigned char>& png);
+    void encodeRLE(const unsigned char* image, std::vector<unsigned char>& rle);
+    static bool decodeRLE(const std::vector<unsigned char>& rle, int& width, int& height, std::vector<unsigned char>& image);
+
+  private:
+    void deflateStrip(int strip);
+    void chunk(std::vector<unsigned char>& png, const char* type, const unsigned char* data, unsigned int bytes);
+    unsigned int crc(unsigned int c, const unsigned char* data, size_t bytes);
+
+    int width;
+    int height;
+    int threads;                                 // OpenMP threads used for the strips
+    std::vector<unsigned char> head;             // Signature, IHDR, PLTE and tRNS - the same for every frame
+    unsigned int crc_table[256];
+    std::vector<unsigned char> filtered;         // height x (filter byte, width pixels)
+    std::vector<unsigned char> strips[FRAME_STRIPS];
+    unsigned int adler[FRAME_STRIPS];
+};
+
+#endif
@@ -0,0 +1,456 @@
+/* preflight.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Dry run: predict memory and work for each rank from the patch files, overlay and place files
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+#include "preflight.h"
+#include "world.h"
+#include <algorithm>
+#include <sstream>
+
+// /dryrun[:N] reads params.bin and then, instead of loading, predicts for each of N ranks (by default as many as
+// config_0.lsi has nodes) what loading would allocate, and stops. Nothing is allocated per person and no household
+// file is opened, so it takes seconds. It reads:
+//
+//   config_<rank>.lsi  - each rank's local and remote patches
+//   the overlay        - households and people in every landscan cell, so counts for each rank are exact
+//   the place files    - places and groups of every country that some rank loads
+//
+// People, households, places, groups and patches are exact. The rest are estimates:
+//
+//   q_tables  - sized exactly for up to PREFLIGHT_Q_SAMPLE local patches per rank and scaled up, taking every patch
+//               to use the largest kernel cut-off of any unit, so an upper bound
+//   places    - membership assumes every local person has a place, and node_first_host that no place spans ranks
+//               (one that does needs no_groups*ranks entries rather than no_groups)
+//   messages  - the buffers whose size is known before the run; the per-step buffers grow with the epidemic
+//   loading   - read_buffer, patch_populations, and the larger of the per-country host counts (tpgn) and the copies
+//               made by reordering, which are freed before the main loop
+//
+// peak is what stays plus loading. The process's own overhead - MPI, libraries, heap fragmentation; "other" in the
+// /memreport table - comes on top.
+//
+// work is each rank's people over the mean, since an even epidemic infects in proportion, and imbalance is the
+// largest. remote is the share of the population within kernel range of the sampled patches that lives on other
+// ranks - roughly the share of community contacts that will need a message.
+
+int readInt(FILE* f) {
+  int i=0;
+  fread(&i,4,1,f);
+  return i;
+}
+
+double readDouble(FILE* f) {
+  double d=0;
+  fread(&d,8,1,f);
+  return d;
+}
+
+char* readString(FILE* f) {
+  int len=readInt(f);
+  char* s = new char[len+1];
+  fread(s,1,len,f);
+  s[len]='\0';
+  return s;
+}
+
+double readPeriod(FILE* f, bool has_mean) {
+  // A latent or infectious period: fixed, or an inverse CDF. Returns the cut-off. (See loadBinaryInitFile.)
+  if (readInt(f)==1) return readDouble(f);
+  if (has_mean) fseek(f,8,SEEK_CUR);                  // Infectious period: mean, then resolution
+  int res=readInt(f);
+  if (!has_mean) fseek(f,8,SEEK_CUR);                 // Latent period: resolution, then mean
+  fseek(f,res*8,SEEK_CUR);
+  return readDouble(f);
+}
+
+string configFile(world* w, int rank) {
+  std::stringstream s;
+  s << w->in_path << "config_" << rank << ".lsi";
+  return s.str();
+}
+
+void estimateRank(world* w, int rank, int ranks, int* ov_hh, int* ov_people, preflightCountry* countries,
+                  int no_country_files, double max_k_cut, bool movie, preflightRank* pr) {
+  pr->ok=false;
+  string file=configFile(w,rank);
+  FILE* f = fopen(file.c_str(),"rb");
+  if (f==NULL) return;
+  pr->local_patches=readInt(f);
+  pr->remote_patches=readInt(f);
+  const int total=pr->local_patches+pr->remote_patches;
+  patch* all = new patch[total];
+  int* local = new int[pr->local_patches];
+  int no_local=0;
+  for (int i=0; i<total; i++) {
+    int rec[4];
+    fread(rec,4,4,f);
+    all[i].x=(unsigned short) rec[0];
+    all[i].y=(unsigned short) (rec[1]+720);           // As loadPatches
+    all[i].size=(unsigned short) rec[2];
+    all[i].node=(unsigned short) rec[3];
+    if ((rec[3]==rank) && (no_local<pr->local_patches)) local[no_local++]=i;
+  }
+  fclose(f);
+
+  // Population of each patch, as loadHouseholdFile would count it. A local patch is one overlay cell; a remote
+  // patch may cover several.
+
+  int* pop = new int[total];
+  int max_size=0;
+  pr->people=0;
+  pr->households=0;
+  for (int i=0; i<total; i++) {
+    pop[i]=0;
+    if (all[i].size>max_size) max_size=all[i].size;
+    int step=(all[i].node==rank)?all[i].size:20;
+    for (int x=all[i].x; x<all[i].x+all[i].size; x+=step) {
+      for (int y=all[i].y; y<all[i].y+all[i].size; y+=step) {
+        if ((x/20<2160) && (y/20<1080)) pop[i]+=ov_people[((x/20)*1080)+(y/20)];
+      }
+    }
+  }
+  bool* tiles = new bool[IMAGE_TILES_X*IMAGE_TILES_Y];
+  for (int i=0; i<IMAGE_TILES_X*IMAGE_TILES_Y; i++) tiles[i]=false;
+  int no_tiles=0;
+  int populated_local=0;
+  for (int i=0; i<no_local; i++) {
+    patch* p = &all[local[i]];
+    if ((p->x/20>=2160) || (p->y/20>=1080)) continue;
+    int hh=ov_hh[((p->x/20)*1080)+(p->y/20)];
+    pr->people+=ov_people[((p->x/20)*1080)+(p->y/20)];
+    pr->households+=hh;
+    if (hh>0) {
+      populated_local++;
+      int tile=(((p->y/20)/IMAGE_TILE)*IMAGE_TILES_X)+((p->x/20)/IMAGE_TILE);
+      if (!tiles[tile]) no_tiles++;
+      tiles[tile]=true;
+    }
+  }
+
+  // Q tables: count the populated patches within max_k_cut of a sample of the local patches that have
+  // households (calculateQ skips the rest). Patches are sorted by y so only a band of latitude is searched.
+
+  SIM_I64* keys = new SIM_I64[total];
+  int no_keys=0;
+  for (int i=0; i<total; i++) if (pop[i]>0) keys[no_keys++]=(((SIM_I64) all[i].y)<<32) | (SIM_I64) i;
+  std::sort(keys,keys+no_keys);
+  const double km_per_cell=6371.297*(3.14159265359/180.0)/120.0;   // North-south, as haversine
+  const bool bounded=(max_k_cut>0);
+  const int band=bounded?((int) (max_k_cut/km_per_cell)+2):0;
+  int step=(populated_local+PREFLIGHT_Q_SAMPLE-1)/PREFLIGHT_Q_SAMPLE;
+  if (step<1) step=1;
+  SIM_I64 sampled=0,sample_entries=0;
+  double near_pop=0,remote_pop=0;
+  int seen=0;
+  for (int i=0; i<no_local; i++) {
+    patch* p = &all[local[i]];
+    if ((p->x/20>=2160) || (p->y/20>=1080) || (ov_hh[((p->x/20)*1080)+(p->y/20)]==0)) continue;
+    if ((seen++)%step!=0) continue;
+    sampled++;
+    int first=0;
+    if (bounded) {
+      SIM_I64 lo=((SIM_I64) std::max(0,p->y-band-max_size))<<32;
+      first=(int) (std::lower_bound(keys,keys+no_keys,lo)-keys);
+    }
+    for (int k=first; k<no_keys; k++) {
+      patch* q = &all[keys[k] & 0xFFFFFFFF];
+      if ((bounded) && (q->y>p->y+p->size+band)) break;
+      if ((!bounded) || (patch::distance(p,q)<=max_k_cut)) {
+        sample_entries++;
+        near_pop+=pop[keys[k] & 0xFFFFFFFF];
+        if (q->node!=rank) remote_pop+=pop[keys[k] & 0xFFFFFFFF];
+      }
+    }
+  }
+  pr->q_entries=(sampled>0)?(SIM_I64) ((sample_entries*(double) populated_local)/sampled):0;
+  pr->remote=(near_pop>0)?remote_pop/near_pop:0;
+
+  // Places: every country this rank loads. tpgn holds [type][place][group][rank] while one country loads.
+
+  SIM_I64 place_bytes=0,tpgn_max=0;
+  pr->places=0;
+  pr->groups=0;
+  for (int c=0; c<no_country_files; c++) {
+    bool needed=false;
+    for (int j=0; j<countries[c].no_nodes; j++) if (countries[c].nodes[j]==rank) needed=true;
+    if (!needed) continue;
+    pr->places+=countries[c].places;
+    pr->groups+=countries[c].groups;
+    place_bytes+=(countries[c].places*(SIM_I64) sizeof(place))+(countries[c].groups*4*(SIM_I64) sizeof(unsigned int))+
+                 (w->P->no_place_types*((5*MALLOC_OVERHEAD)+sizeof(unsigned int)));
+    SIM_I64 tpgn=(countries[c].places*(SIM_I64) (sizeof(int**)+MALLOC_OVERHEAD))+
+                 (countries[c].groups*(SIM_I64) (sizeof(int*)+(ranks*sizeof(int))+MALLOC_OVERHEAD));
+    if (tpgn>tpgn_max) tpgn_max=tpgn;
+  }
+  place_bytes+=pr->people*(SIM_I64) sizeof(person*);   // members
+
+  const SIM_I64 threads=w->thread_count;
+  for (int i=0; i<NO_MEM; i++) pr->bytes[i]=0;
+  pr->bytes[MEM_PATCHES]=(pr->local_patches*(SIM_I64) sizeof(localPatch))+(pr->remote_patches*(SIM_I64) sizeof(patch))+
+                         (total*(SIM_I64) MALLOC_OVERHEAD)+sizeof(w->localPatchLookup)+sizeof(w->allPatchLookup)+
+                         ((pr->local_patches+total)*(SIM_I64) sizeof(patch*));
+  pr->bytes[MEM_PEOPLE]=(pr->people*(SIM_I64) sizeof(person))+(pr->local_patches*(SIM_I64) MALLOC_OVERHEAD);
+  pr->bytes[MEM_HOUSEHOLDS]=pr->households*(SIM_I64) sizeof(household);
+  pr->bytes[MEM_PLACES]=place_bytes;
+  pr->bytes[MEM_Q]=(pr->q_entries*(SIM_I64) (sizeof(float)+sizeof(int)))+(populated_local*2*(SIM_I64) MALLOC_OVERHEAD);
+  pr->bytes[MEM_QUEUES]=threads*(((2+(3*w->P->infectionWindow))*(SIM_I64) sizeof(lwv::vector<infectedPerson*>))+
+                                 (w->P->infectionWindow*sizeof(int))+sizeof(lwv::vector<person*>));
+  pr->bytes[MEM_MESSAGES]=(2*sizeof(int)*((3*(SIM_I64) ranks*ranks)+(w->no_units*(6+(2*w->P->no_place_types)))+1+((w->fast_forward)?ranks:0)))+   // starter messages
+                          (threads*ranks*((5*(SIM_I64) sizeof(lwv::vector<unsigned char>))+1+(2*sizeof(int))))+
+                          (ranks*7*sizeof(int));
+  if (movie) {
+    pr->bytes[MEM_IMAGE]=(no_tiles*(SIM_I64) (sizeof(imageTile)+(threads*2*IMAGE_TILE_PIXELS*sizeof(int))+IMAGE_TILE_PIXELS+(3*MALLOC_OVERHEAD)))+
+                         (IMAGE_TILES_X*IMAGE_TILES_Y*(sizeof(imageTile*)+(2*sizeof(int))))+
+                         (((rank==0)?2:1)*PNG_WIDTH*PNG_HEIGHT);
+  }
+
+  SIM_I64 reorder=0;
+  if (w->reorder_population) reorder=pr->people*(SIM_I64) (sizeof(person)+sizeof(int));   // new_people, new_index
+  pr->load_bytes=BUFFER_SIZE+(total*(SIM_I64) sizeof(int))+std::max(tpgn_max,reorder);
+
+  delete[] all;
+  delete[] local;
+  delete[] pop;
+  delete[] tiles;
+  delete[] keys;
+  pr->ok=true;
+}
+
+static void freeInputs(preflightCountry* countries, int no_country_files, int no_place_types, int* ov_hh, int* ov_people,
+                       char* ov_file) {         // Everything preflight() read from the input files - on the way out, or on an error
+  for (int i=0; i<no_country_files; i++) {
+    for (int k=0; k<no_place_types; k++) delete[] countries[i].place_files[k];
+    delete[] countries[i].place_files;
+    delete[] countries[i].nodes;
+  }
+  delete[] countries;
+  delete[] ov_hh;
+  delete[] ov_people;
+  delete[] ov_file;
+}
+
+void preflight(world* w, const char* param_file) {
+  int ranks=w->dry_run;
+  printf("%d: Dry run - estimating memory and work for each rank\n",w->mpi_rank);
+  fflush(stdout);
+
+  string t_file=w->in_path+"travel_matrix.bin";
+  FILE* f = fopen(t_file.c_str(),"rb");
+  if (f==NULL) {
+    printf("%d: Couldn't open %s\n",w->mpi_rank,t_file.c_str());
+    return;
+  }
+  w->no_countries=readInt(f);
+  fclose(f);
+
+  // params.bin, in the order loadBinaryInitFile reads it - skipping what doesn't affect memory.
+
+  f = fopen(param_file,"rb");
+  if (f==NULL) {
+    printf("%d: Couldn't open %s\n",w->mpi_rank,param_file);
+    return;
+  }
+  w->P->no_place_types=readInt(f);
+  double latent_cutoff=readPeriod(f,false);
+  if (readInt(f)==1) fseek(f,8,SEEK_CUR);              // Infectiousness
+  else fseek(f,readInt(f)*8,SEEK_CUR);
+  double infectious_cutoff=readPeriod(f,true);
+  w->P->timesteps_per_day=4;
+  w->P->infectionWindow=(int) (2+latent_cutoff+infectious_cutoff)*w->P->timesteps_per_day;
+
+  const int sub_type_bytes[8] = { 16, 24, 64, 40, 48, 44, 16, 32 };   // Per intervention type, see loadBinaryInitFile
+  w->no_interventions=readInt(f);
+  for (int i=0; i<w->no_interventions; i++) {
+    int type=readInt(f);
+    for (int on_off=0; on_off<2; on_off++) {
+      int trig=readInt(f);
+      if (trig==1) fseek(f,8,SEEK_CUR);
+      else if (trig==0) fseek(f,28,SEEK_CUR);
+    }
+    if ((type>=0) && (type<8)) fseek(f,sub_type_bytes[type],SEEK_CUR);
+  }
+
+  w->no_units=readInt(f);
+  SIM_I64 stats_bytes=w->no_units*(SIM_I64) (sizeof(kernelTable)+MALLOC_OVERHEAD)+(w->no_countries*(SIM_I64) ranks*sizeof(int));
+  double max_k_cut=0;
+  bool unbounded=false;
+  for (int i=0; i<w->no_units; i++) {
+    int level=readInt(f);
+    fseek(f,4,SEEK_CUR);                                 // Country
+    if (level>0) fseek(f,4,SEEK_CUR);                    // Parent
+    fseek(f,24,SEEK_CUR);                                // B_spat, k_a, k_b
+    double k_cut=readDouble(f);
+    if (k_cut>max_k_cut) max_k_cut=k_cut;
+    if (k_cut<=0) unbounded=true;
+    fseek(f,8+(w->P->no_place_types*48)+72,SEEK_CUR);    // B_hh, place parameters, symptoms and seasonality
+    int no_interventions=readInt(f);
+    fseek(f,(no_interventions*4)+4,SEEK_CUR);            // Interventions, log
+    stats_bytes+=unitMemory(w->thread_count,w->P->no_place_types,w->P->timesteps_per_day,no_interventions)+
+                 ((14+(2*w->P->no_place_types))*MALLOC_OVERHEAD);
+  }
+  if (unbounded) max_k_cut=0;                          // Some unit's kernel never reaches 0 - no bound
+
+  fseek(f,8,SEEK_CUR);                                   // Seeds
+  int no_seeds=readInt(f);
+  fseek(f,no_seeds*28,SEEK_CUR);
+  int no_age_bands=readInt(f);
+  fseek(f,no_age_bands*16,SEEK_CUR);
+  if (readInt(f)==1) {                                   // Database, flat file, movie
+    delete[] readString(f);
+    delete[] readString(f);
+  }
+  if (readInt(f)==1) {
+    delete[] readString(f);
+    delete[] readString(f);
+  }
+  bool movie=false;
+  if (readInt(f)==1) {
+    movie=true;
+    delete[] readString(f);
+    delete[] readString(f);
+  }
+
+  int no_country_files=readInt(f);
+  char* ov_file=readString(f);
+  preflightCountry* countries = new preflightCountry[no_country_files];
+  for (int i=0; i<no_country_files; i++) {
+    fseek(f,4,SEEK_CUR);                                 // Grump
+    countries[i].code=readInt(f);
+    countries[i].no_nodes=readInt(f);
+    countries[i].nodes = new int[countries[i].no_nodes];
+    for (int j=0; j<countries[i].no_nodes; j++) countries[i].nodes[j]=readInt(f);
+    delete[] readString(f);                              // Household file - not needed
+    countries[i].place_files = new char*[w->P->no_place_types];
+    for (unsigned int k=0; k<w->P->no_place_types; k++) countries[i].place_files[k]=readString(f);
+  }
+  fclose(f);
+
+  if (ranks<=0) {                                        // As many as the patch files were made for
+    string file=configFile(w,0);
+    f = fopen(file.c_str(),"rb");
+    if (f==NULL) {
+      printf("%d: Couldn't open %s\n",w->mpi_rank,file.c_str());
+      freeInputs(countries,no_country_files,w->P->no_place_types,NULL,NULL,ov_file);
+      return;
+    }
+    int total=readInt(f);
+    total+=readInt(f);
+    for (int i=0; i<total; i++) {
+      int rec[4];
+      fread(rec,4,4,f);
+      if (rec[3]>=ranks) ranks=rec[3]+1;
+    }
+    fclose(f);
+  }
+
+  // Overlay: households and people in every cell, [x][y].
+
+  int* ov_hh = new int[2160*1080];
+  int* ov_people = new int[2160*1080];
+  f = fopen(ov_file,"rb");
+  if (f==NULL) {
+    printf("%d: Couldn't open %s\n",w->mpi_rank,ov_file);
+    freeInputs(countries,no_country_files,w->P->no_place_types,ov_hh,ov_people,ov_file);
+    return;
+  }
+  int* cells = new int[2*1080];
+  for (int i=0; i<2160; i++) {
+    fread(cells,4,2*1080,f);
+    for (int j=0; j<1080; j++) {
+      ov_hh[(i*1080)+j]=cells[2*j];
+      ov_people[(i*1080)+j]=cells[(2*j)+1];
+    }
+  }
+  delete[] cells;
+  fclose(f);
+
+  // Place files: count places and groups, once for each country some rank loads. Each record is lat, lon, hosts,
+  // largest group number and unit - see loadPlaces.
+
+  for (int i=0; i<no_country_files; i++) {
+    countries[i].used=false;
+    countries[i].places=0;
+    countries[i].groups=0;
+    for (int j=0; j<countries[i].no_nodes; j++) if ((countries[i].nodes[j]>=0) && (countries[i].nodes[j]<ranks)) countries[i].used=true;
+  }
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int i=0; i<no_country_files; i++) {
+    if (!countries[i].used) continue;
+    for (unsigned int k=0; k<w->P->no_place_types; k++) {
+      FILE* pf = fopen(countries[i].place_files[k],"rb");
+      if (pf==NULL) {
+        printf("%d: Couldn't open %s\n",w->mpi_rank,countries[i].place_files[k]);
+        continue;
+      }
+      unsigned short id;
+      unsigned int no_places=0;
+      fread(&id,2,1,pf);
+      fread(&no_places,4,1,pf);
+      countries[i].places+=no_places;
+      unsigned char rec[28];
+      for (unsigned int e=0; e<no_places; e++) {
+        if (fread(rec,28,1,pf)!=1) break;
+        countries[i].groups+=(*(unsigned int*) &rec[20])+2;            // +1 for group 0, +1 for the "no group" group
+      }
+      fclose(pf);
+    }
+  }
+
+  preflightRank* pr = new preflightRank[ranks];
+  #pragma omp parallel for schedule(dynamic,1)
+  for (int r=0; r<ranks; r++)
+    estimateRank(w,r,ranks,ov_hh,ov_people,countries,no_country_files,max_k_cut,movie,&pr[r]);
+
+  double mean_people=0;
+  for (int r=0; r<ranks; r++) mean_people+=pr[r].people;
+  mean_people/=ranks;
+  double max_work=0,max_peak=0,sum_peak=0,max_remote=0;
+  int max_peak_rank=0;
+  printf("PREFLIGHT ranks=%d threads=%d q_sample=%d max_k_cut=%.1f movie=%d (MB)\n",ranks,w->thread_count,PREFLIGHT_Q_SAMPLE,
+         max_k_cut,movie?1:0);
+  printf("PREFLIGHT_HEAD rank local_patches remote_patches n_people n_households n_places n_groups n_q remote work");
+  for (int i=0; i<NO_MEM; i++) if (i!=MEM_INFECTED) printf(" %s",mem_names[i]);
+  printf(" loading peak\n");
+  for (int r=0; r<ranks; r++) {
+    if (!pr[r].ok) {
+      printf("PREFLIGHT_RANK %d FAILED - couldn't open %s\n",r,configFile(w,r).c_str());
+      continue;
+    }
+    double work=(mean_people>0)?pr[r].people/mean_people:0;
+    SIM_I64 peak=pr[r].load_bytes;
+    for (int i=0; i<NO_MEM; i++) peak+=pr[r].bytes[i];
+    peak+=stats_bytes;
+    pr[r].bytes[MEM_STATS]=stats_bytes;
+    printf("PREFLIGHT_RANK %d %d %d %lld %lld %lld %lld %lld %.3f %.3f",r,pr[r].local_patches,pr[r].remote_patches,
+           (long long) pr[r].people,(long long) pr[r].households,(long long) pr[r].places,(long long) pr[r].groups,
+           (long long) pr[r].q_entries,pr[r].remote,work);
+    for (int i=0; i<NO_MEM; i++) if (i!=MEM_INFECTED) printf(" %.1f",pr[r].bytes[i]/1048576.0);
+    printf(" %.1f %.1f\n",pr[r].load_bytes/1048576.0,peak/1048576.0);
+    if (work>max_work) max_work=work;
+    if (pr[r].remote>max_remote) max_remote=pr[r].remote;
+    if (peak/1048576.0>max_peak) {
+      max_peak=peak/1048576.0;
+      max_peak_rank=r;
+    }
+    sum_peak+=peak/1048576.0;
+  }
+  printf("PREFLIGHT_SUMMARY max_peak_mb=%.1f rank=%d mean_peak_mb=%.1f imbalance=%.3f max_remote=%.3f\n",max_peak,max_peak_rank,
+         sum_peak/ranks,max_work,max_remote);
+  fflush(stdout);
+
+  delete[] pr;
+  freeInputs(countries,no_country_files,w->P->no_place_types,ov_hh,ov_people,ov_file);
+}
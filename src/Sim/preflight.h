@@ -0,0 +1,57 @@
+/* preflight.h, part of the Global Epidemic Simulation v1.0 BETA
+/* Header for the /dryrun memory and work estimator
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#ifndef PREFLIGHT_H
+#define PREFLIGHT_H
+
+#include "simINT64.h"
+#include "memreport.h"
+
+#define PREFLIGHT_Q_SAMPLE 256     // Local patches per rank whose community contact tables are sized exactly
+#define MALLOC_OVERHEAD 16         // Bytes the heap adds to each allocation, for the many small ones made while loading
+
+class world;
+
+struct preflightCountry {      // One country's entry in params.bin
+  int code;
+  int no_nodes;
+  int* nodes;                  // Ranks that load it
+  char** place_files;          // [place_type]
+  bool used;                   // Loaded by some rank of the run being estimated
+  SIM_I64 places;              // All types
+  SIM_I64 groups;
+};
+
+struct preflightRank {
+  bool ok;
+  int local_patches;
+  int remote_patches;
+  SIM_I64 people;
+  SIM_I64 households;
+  SIM_I64 places;
+  SIM_I64 groups;
+  SIM_I64 q_entries;           // Estimated - see preflight.cpp
+  double remote;               // Share of the population in kernel range that is on other ranks
+  SIM_I64 bytes[NO_MEM];       // What stays after loading, in /memreport's categories
+  SIM_I64 load_bytes;          // ...and what is only needed while loading
+};
+
+void preflight(world* w, const char* param_file);
+
+#endif
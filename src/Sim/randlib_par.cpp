@@ -31,6 +31,7 @@
 
 /* RANDLIB static variables */
 long Xm1,Xm2,Xa1,Xa2,*Xcg1,*Xcg2,Xa1vw,Xa2vw;
+long Xig1,Xig2;     // Initial seeds, kept for reseedStream_mt
 
 
 
@@ -119,6 +120,8 @@ void initSeeds(long iseed1,long iseed2)
     
     *Xcg1 = iseed1;
     *Xcg2 = iseed2;
+    Xig1 = iseed1;
+    Xig2 = iseed2;
 
     for (g=1; g<32; g++) {
         *(Xcg1+(g*CACHE_LINE_SIZE)) = mltmod(Xa1vw,*(Xcg1+((g-1)*CACHE_LINE_SIZE)),Xm1);
@@ -130,6 +133,30 @@ void initSeeds(long iseed1,long iseed2)
     //}
 }
 
+static unsigned long long splitmix64(unsigned long long h)
+{
+  h += 0x9E3779B97F4A7C15ULL;
+  h = (h ^ (h>>30)) * 0xBF58476D1CE4E5B9ULL;
+  h = (h ^ (h>>27)) * 0x94D049BB133111EBULL;
+  return h ^ (h>>31);
+}
+
+void reseedStream_mt(int tn,long key1,long long key2)
+/*
+     Restart generator tn from a state derived from the initial seeds and
+     (key1,key2), so that the numbers drawn next depend only on the key, not
+     on which thread - or in what order - the work is done. Used to give each
+     queued individual its own well-defined stream in each phase of each
+     timestep (see reseedPerson in sim.cpp).
+*/
+{
+  unsigned long long h = splitmix64((unsigned long long) key2 ^ splitmix64((unsigned long long) key1));
+  long s1 = (long) (((unsigned long long) Xig1 + (h & 0xFFFFFFFFULL)) % (unsigned long long) (Xm1-1)) + 1;
+  long s2 = (long) (((unsigned long long) Xig2 + (h>>32)) % (unsigned long long) (Xm2-1)) + 1;
+  Xcg1[CACHE_LINE_SIZE*tn] = mltmod(Xa1vw,s1,Xm1);
+  Xcg2[CACHE_LINE_SIZE*tn] = mltmod(Xa2vw,s2,Xm2);
+}
+
 long mltmod(long a,long s,long m)
 /*
 **********************************************************************
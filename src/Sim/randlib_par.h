@@ -26,6 +26,7 @@ long ignpoi_mt(double,int);
 double ranf(void);
 double ranf_mt(int);
 void initSeeds(long ,long);
+void reseedStream_mt(int ,long ,long long );
 double sexpo_mt(int);
 double sexpo(void);
 long mltmod(long ,long ,long );
@@ -0,0 +1,152 @@
+/* shardout.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Flat file rows written by every rank into one shared file with MPI-IO
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+#include "shardout.h"
+#include "world.h"
+#include <stddef.h>
+
+// After processUnitInfo every rank holds the same, globally reduced unit stats, but the flat file is written by
+// rank 0 alone, so with many units output is a serial step every other rank waits for. /ffmpi:file shares it out:
+// the units are split into one contiguous range per rank, and each timestep every rank writes its range's rows
+// into the same file with one collective MPI_File_write_at_all. The layout is fixed (see flatbin.h) - every unit
+// has a row every timestep - so the offsets need no coordination, and a reader can go straight to any unit.
+//
+// Contact makers are only counted on the rank hosting the infected person, so they are summed over ranks with one
+// MPI_Reduce_scatter, which also delivers each rank just its own range.
+
+shardOutput::shardOutput(world* w, const char* file) {
+  no_units=w->no_units;
+  no_columns=flatbinColumns(w->P->no_place_types);
+  row_bytes=no_columns*sizeof(int);
+  step_bytes=(long long) no_units*row_bytes;
+  unit_start = new int[w->mpi_size+1];
+  recv_counts = new int[w->mpi_size];
+  for (int r=0; r<=w->mpi_size; r++) unit_start[r]=(int) (((long long) r*no_units)/w->mpi_size);
+  for (int r=0; r<w->mpi_size; r++) recv_counts[r]=unit_start[r+1]-unit_start[r];
+  first=unit_start[w->mpi_rank];
+  count=recv_counts[w->mpi_rank];
+  rows = new int[(count+1)*no_columns];
+  makers = new int[no_units+1];
+  my_makers = new int[count+1];
+  steps=0;
+  write_time=0;
+
+  long long meta=sizeof(flatbinShardHeader)+((w->mpi_size+1)*sizeof(int))+no_units;
+  data_at=((meta+FLATBIN_SHARD_ALIGN-1)/FLATBIN_SHARD_ALIGN)*FLATBIN_SHARD_ALIGN;
+  char* head = new char[meta];
+  memset(head,0,meta);
+  flatbinShardHeader* h = (flatbinShardHeader*) head;
+  memcpy(h->magic,FLATBIN_SHARD_MAGIC,8);
+  h->version=FLATBIN_VERSION;
+  h->no_place_types=w->P->no_place_types;
+  h->no_columns=no_columns;
+  h->no_units=no_units;
+  h->no_ranks=w->mpi_size;
+  h->timestep_hours=(int) w->P->timestep_hours;
+  h->no_steps=0;
+  h->row_bytes=row_bytes;
+  h->step_bytes=step_bytes;
+  h->data_at=data_at;
+  memcpy(head+sizeof(flatbinShardHeader),unit_start,(w->mpi_size+1)*sizeof(int));
+  unsigned char* logged = (unsigned char*) (head+sizeof(flatbinShardHeader)+((w->mpi_size+1)*sizeof(int)));
+  for (int i=0; i<no_units; i++) logged[i]=w->a_units[i].log?1:0;
+
+  #ifdef _USEMPI
+    int opened = (MPI_File_open(MPI_COMM_WORLD,(char*) file,MPI_MODE_CREATE|MPI_MODE_WRONLY,MPI_INFO_NULL,&fh)==MPI_SUCCESS)?1:0;
+    int all_opened=0;
+    MPI_Allreduce(&opened,&all_opened,1,MPI_INT,MPI_MIN,MPI_COMM_WORLD);
+    ok=(all_opened==1);
+    if (ok) {
+      MPI_File_set_size(fh,0);                              // Truncate anything left from an earlier run
+      if (w->mpi_rank==0) MPI_File_write_at(fh,0,head,(int) meta,MPI_BYTE,MPI_STATUS_IGNORE);
+    } else if (opened==1) MPI_File_close(&fh);
+  #else
+    fh=fopen(file,"wb");
+    ok=(fh!=NULL);
+    if (ok) fwrite(head,1,meta,fh);
+  #endif
+  delete[] head;
+  if (w->mpi_rank==0) {
+    if (ok) printf("%d: Sharded flat file %s - %d units over %d ranks, %d bytes per timestep\n",w->mpi_rank,file,no_units,w->mpi_size,(int) step_bytes);
+    else printf("%d: Couldn't open sharded flat file %s on every rank - not writing it\n",w->mpi_rank,file);
+    fflush(stdout);
+  }
+}
+
+shardOutput::~shardOutput() {
+  delete[] unit_start;
+  delete[] recv_counts;
+  delete[] rows;
+  delete[] makers;
+  delete[] my_makers;
+}
+
+void shardOutput::write(world* w) {
+  if (!ok) return;
+  double t0=phaseClock();
+  for (int i=0; i<no_units; i++) makers[i]=w->a_units[i].contact_makers[0];
+  #ifdef _USEMPI
+    MPI_Reduce_scatter(makers,my_makers,recv_counts,MPI_INT,MPI_SUM,MPI_COMM_WORLD);
+  #else
+    for (int i=0; i<count; i++) my_makers[i]=makers[first+i];
+  #endif
+  for (int i=0; i<count; i++) {                             // Same fields, in the same order, as logFlatfile
+    unit* u = &w->a_units[first+i];
+    int* row = &rows[i*no_columns];
+    int j=0;
+    row[j++]=first+i;
+    row[j++]=my_makers[i];
+    row[j++]=u->new_comm_cases;
+    row[j++]=u->new_hh_cases;
+    for (unsigned int k=0; k<w->P->no_place_types; k++) row[j++]=u->new_place_cases[k];
+    row[j++]=u->new_comm_infs;
+    row[j++]=u->new_hh_infs;
+    for (unsigned int k=0; k<w->P->no_place_types; k++) row[j++]=u->new_place_infs[k];
+    row[j++]=u->current_symptomatic_inf;
+    row[j++]=u->current_nonsymptomatic_inf;
+  }
+  long long at=data_at+(steps*step_bytes)+((long long) first*row_bytes);
+  #ifdef _USEMPI
+    MPI_File_write_at_all(fh,(MPI_Offset) at,rows,count*no_columns,MPI_INT,MPI_STATUS_IGNORE);
+  #else
+    fseek(fh,at,SEEK_SET);
+    fwrite(rows,sizeof(int),count*no_columns,fh);
+  #endif
+  steps++;
+  write_time+=phaseClock()-t0;
+}
+
+void shardOutput::close(world* w) {
+  if (!ok) return;
+  long long at=offsetof(flatbinShardHeader,no_steps);
+  double max_time=write_time;
+  #ifdef _USEMPI
+    if (w->mpi_rank==0) MPI_File_write_at(fh,(MPI_Offset) at,&steps,1,MPI_INT,MPI_STATUS_IGNORE);
+    MPI_File_close(&fh);
+    MPI_Reduce(&write_time,&max_time,1,MPI_DOUBLE,MPI_MAX,0,MPI_COMM_WORLD);
+  #else
+    fseek(fh,at,SEEK_SET);
+    fwrite(&steps,sizeof(int),1,fh);
+    fclose(fh);
+  #endif
+  ok=false;
+  if (w->mpi_rank==0) {
+    printf("%d: Sharded flat file: %d timesteps, %.1f MB, slowest rank spent %.3f s writing\n",w->mpi_rank,steps,(data_at+(steps*step_bytes))/1048576.0,max_time);
+    fflush(stdout);
+  }
+}
@@ -0,0 +1,62 @@
+/* shardout.h, part of the Global Epidemic Simulation v1.0 BETA
+/* Flat file rows written by every rank into one shared file with MPI-IO
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#ifndef SHARDOUT_H
+#define SHARDOUT_H
+
+#include <stdio.h>
+#include "sim.h"
+#include "mpi.h"
+#define FLATBIN_FORMAT_ONLY
+#include "flatbin.h"
+
+class world;
+
+class shardOutput {
+  public:
+    shardOutput(world* w, const char* file);     // Collective - every rank
+    ~shardOutput();
+    void write(world* w);                        // Collective - this timestep's rows for this rank's units
+    void close(world* w);                        // Collective - complete the header and close the file
+
+    bool ok;
+
+  private:
+    int no_units;
+    int no_columns;
+    int row_bytes;
+    long long step_bytes;
+    long long data_at;
+    int* unit_start;          // [mpi_size+1] - rank r has units unit_start[r]..unit_start[r+1]-1
+    int* recv_counts;         // [mpi_size] - units per rank, for MPI_Reduce_scatter
+    int first;                // This rank's units
+    int count;
+    int* rows;                // [count*no_columns]
+    int* makers;              // [no_units] contact makers on this rank, summed over ranks into my_makers
+    int* my_makers;           // [count]
+    int steps;
+    double write_time;
+    #ifdef _USEMPI
+      MPI_File fh;
+    #else
+      FILE* fh;
+    #endif
+};
+
+#endif
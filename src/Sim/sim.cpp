@@ -36,6 +36,47 @@
 
 int errline;
 
+inline void scheduleEvent(world* w, lwv::vector<infectedPerson*>** queue, int thread_no, int slot, infectedPerson* ip) {
+  queue[thread_no][slot].push_back(ip);           // Every contact/symptom/recovery event goes through here, so that
+  w->queued_events[thread_no][slot]++;            // the per-slot counters always match the queues.
+  w->queued_total[thread_no]++;
+}
+
+inline void clearSlot(world* w, lwv::vector<infectedPerson*>** queue, int thread_no, int slot) {
+  int n = (int) queue[thread_no][slot].size();
+  w->queued_events[thread_no][slot]-=n;
+  w->queued_total[thread_no]-=n;
+  queue[thread_no][slot].clear();
+}
+
+inline SIM_I64 personId(world* w, person* p) {     // See eventlog.h
+  localPatch* lp = w->localPatchList[p->getHouse()->patch];
+  return ((((SIM_I64) (lp->y/20)*2160)+(lp->x/20))<<32)+(SIM_I64) (p-lp->people);
+}
+
+inline void reseedPerson(world* w, int thread_no, int phase, infectedPerson* infected) {
+  // With work-stealing, which thread takes a person - and who shares their chunk - varies from run to run, so each
+  // person gets their own random stream for the phase, keyed on who they are and when. Their draws are then the
+  // same whatever the schedule. (/sched:stride keeps the threads' own streams, as before.)
+  // Draws that aren't one person's (seeding, message handling, vaccination) are keyed the same way on a fixed task
+  // number - see reseedTask. That still doesn't make a run with more than one thread repeatable, in either mode:
+  // infectors on different threads race for the same susceptible, and which one gets them depends on timing.
+  if ((w->sched_mode==SCHED_STEAL) && (infected!=NULL))
+    reseedStream_mt(thread_no,(long) ((w->T*NO_PHASES)+phase),personId(w,infected->personPointer));
+}
+
+inline void reseedTask(world* w, int thread_no, int phase, int task) {
+  // As reseedPerson, for a task the schedule doesn't move but a thread's earlier draws would: negative, so never a personId.
+  if (w->sched_mode==SCHED_STEAL) reseedStream_mt(thread_no,(long) ((w->T*NO_PHASES)+phase),-1-(SIM_I64) task);
+}
+
+inline void logInfection(world* w, int thread_no, person* infector, int infector_node, person* infectee, float t,
+    unsigned char setting, unsigned char place_type) {   // Record who infected whom, if /events: is on. infector NULL = not known here.
+  if (w->events==NULL) return;
+  w->events->add(thread_no,(infector==NULL)?EVENT_NO_INFECTOR:personId(w,infector),(unsigned short) infector_node,
+                 personId(w,infectee),infectee->getHouse()->unit,t,setting,place_type);
+}
+
 extern "C" void handle_aborts(int signal_number) {
   printf("Abort called. Last debug code = %d\n",errline);
   fflush(stdout);
@@ -71,6 +112,9 @@ void handleIncomingMessage(world *w) {              // An incoming message is st
     unsigned int msg_ptr = 0;     // A "global" pointer - into the whole incoming message.
     unsigned short src=0;         // Currently considering messages originating from this node.
 
+    #pragma omp single            // Called from inside runSim's parallel region - one thread links, the rest wait at the implicit barrier.
+    {
+
     while (src<w->mpi_size) {                                                                             // Have we dealt with rep/req messages from all nodes?
       if ((type==REQUEST) && (pointer>=w->req_bytes_from[src])) { type=REPLY; pointer=0; }                // If we've run out of requests for this node, switch to replies.
       else if ((type==REPLY) && (pointer>=w->rep_bytes_from[src])) {                                      // If we've run out of replies, 
@@ -138,12 +182,14 @@ void handleIncomingMessage(world *w) {              // An incoming message is st
 
     store_remote_address.clear();
     store_remote_rp.clear();
+    } // End omp single
 
    // Now the replies are linked together, we can process all the REQ/REP messages in a threadsafe way, treating
    // linked replies (ie, replies to the same requestor) as one linked list handled by one thread.
       
-    #pragma omp parallel for private(thread_no) schedule(static,1)
+    #pragma omp for schedule(static,1)
     for (thread_no=0; thread_no<w->thread_count; thread_no++) {
+      reseedTask(w,thread_no,PHASE_HANDLE,thread_no);   // Which messages a thread takes is fixed; its stream so far isn't
       int i=0;
       int j=0;
       int k=0;
@@ -279,44 +325,30 @@ void handleIncomingMessage(world *w) {              // An incoming message is st
                   if (visitor_person==NULL) { // So we've decided they are a visitor, but not decided who the "origin" person is yet.
                     unsigned int country = (unsigned int) lx;  // In this case, lx will be the country.
                     //if (lx-country>0.5) country++;   // Simple rounding to check we've not got (x-1).99999
-                    int tries=0;  // There may be no susceptibles left.
-                    while ((visitor_person==NULL) && (tries<100)) { // Try at most 100 times to find one.
-                      tries++;    // Increase try no... and pick a random person in the specified country, on this node.
-                      int person_no = (unsigned int) (ranf_mt(thread_no)* w->people_per_country_per_node[country][w->mpi_rank]);
-                      for (int patch=0; patch<w->patches_in_country[country].size(); patch++) { // Loop to find which patch they live in.
-                         if (person_no<w->localPatchList[w->patches_in_country[country].at(patch)]->no_people) {
-                          visitor_person=&w->localPatchList[w->patches_in_country[country].at(patch)]->people[person_no]; // Locate person
-                          if ((visitor_person->status & STATUS_SUSCEPTIBLE)>0) {  // Are they susceptible?
-                            visitor_patch=w->localPatchList[w->patches_in_country[country].at(patch)]; // If so, we have our visitor. Store patch
-                            visitor_person->status-=STATUS_SUSCEPTIBLE;   // So they were infected while visting somewhere.
-                            visitor_person->status+=STATUS_CONTACTED;     // They've now been contacted some how.
-                            lon = visitor_person->house->lon;             // Remember longitude of their house
-                            lat = visitor_person->house->lat;             // Remember latitude of their house
-                            
-                            infectedPerson* ip = new infectedPerson(w,thread_no,visitor_person); // Create infected person object
-                            ip->updateStats(w,thread_no,1,0);
-                            ip->travel_plan=NULL;
-                            unsigned int timeStepsAway = 8;                                            // Schedule fake recovery time.
-                            timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;   // Modulo maths to choose the right list
-                            w->recoveryQueue[thread_no][timeStepsAway].push_back(ip);      // And schedule recovery
-
-
-                          } else if (tries>=100) {  // If you can't find a susceptible... then use the co-ordinates, but don't set the infected status
-                            visitor_patch=w->localPatchList[w->patches_in_country[country].at(patch)];
-                            visitor_person=&visitor_patch->people[person_no];
-                            lon=visitor_person->house->lon;
-                            lat=visitor_person->house->lat;
-
-                            // This tries>=100 clause is a bit non-ideal - the travel matrix has said we should have a visitor, from here
-                            // but there are no susceptible visitors who could have travelled and caught the infection.
-
-                          } else {
-                            visitor_person=NULL;   // Otherwise: reset visitor_person to NULL so that earlier condition will succeed and
-                          }                        // we keep trying for a susceptible.
-                          patch=(int) w->patches_in_country[country].size();   // Done - force patch loop to terminate.
-                          // Or otherwise, skip this patch and all its members - person_no must be in a later patch.
-                        } else person_no-=w->localPatchList[w->patches_in_country[country].at(patch)]->no_people;
-                      }
+                    visitor_person = pickSusceptible(w,(unsigned char) country,thread_no,&visitor_patch);   // Random susceptible in the country, on this node
+                    if (visitor_person!=NULL) {                       // We have our visitor.
+                      visitor_person->status-=STATUS_SUSCEPTIBLE;   // So they were infected while visting somewhere.
+                      queueSusceptibleRemoval(w,thread_no,visitor_person);
+                      logInfection(w,thread_no,NULL,src,visitor_person,(float) w->T,EVENT_TRAVEL,0);
+                      visitor_person->status+=STATUS_CONTACTED;     // They've now been contacted some how.
+                      lon = visitor_person->getHouse()->lon;             // Remember longitude of their house
+                      lat = visitor_person->getHouse()->lat;             // Remember latitude of their house
+                      
+                      infectedPerson* ip = new infectedPerson(w,thread_no,visitor_person); // Create infected person object
+                      ip->updateStats(w,thread_no,1,0);
+                      ip->travel_plan=NULL;
+                      unsigned int timeStepsAway = 8;                                            // Schedule fake recovery time.
+                      timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;   // Modulo maths to choose the right list
+                      scheduleEvent(w,w->recoveryQueue,thread_no,timeStepsAway,ip);      // And schedule recovery
+
+                    } else {  // If there are no susceptibles... then use the co-ordinates of anyone in the country, but don't set the infected status
+                      visitor_patch = infectedPerson::getPatchForPerson(w,(int) (ranf_mt(thread_no)*w->people_per_country_per_node[country][w->mpi_rank]),(unsigned char) country,thread_no);
+                      visitor_person=&visitor_patch->people[(int) (ranf_mt(thread_no)*visitor_patch->no_people)];
+                      lon=visitor_person->getHouse()->lon;
+                      lat=visitor_person->getHouse()->lat;
+
+                      // This clause is a bit non-ideal - the travel matrix has said we should have a visitor, from here
+                      // but there are no susceptible visitors who could have travelled and caught the infection.
                     }
                   }
                 }   // Done MSG_VISITOR || MSG_NULL_VISITOR
@@ -376,9 +408,9 @@ void handleIncomingMessage(world *w) {              // An incoming message is st
               if (susceptible!=NULL) { 
                 if ((susceptible->status & STATUS_SUSCEPTIBLE)>0) { // If susceptible, then use rejection algorithm
                   double D_kk2 = patch::distance(lp,lx,ly,size);              // Shortest distance between local patch and supplied patch co-ordinates
-                  double r_ij = haversine(lon,lat,susceptible->house->lon,susceptible->house->lat);  // Absolute distance
-                  double S_ij = unit::kernel_F(&w->a_units[susceptible->house->unit],r_ij);
-                  S_ij /= unit::kernel_F(&w->a_units[susceptible->house->unit],D_kk2);                // Rejection criteria
+                  double r_ij = haversine(lon,lat,susceptible->getHouse()->lon,susceptible->getHouse()->lat);  // Absolute distance
+                  double S_ij = unitHot::kernel_F(&w->unit_hot[susceptible->getHouse()->unit],r_ij);
+                  S_ij /= unitHot::kernel_F(&w->unit_hot[susceptible->getHouse()->unit],D_kk2);                // Rejection criteria
 
                   if (ranf_mt(thread_no)<S_ij) {                                        // If accepted...
                     remote_contacts_so_far++;                                           //    New remote contact found
@@ -411,15 +443,17 @@ void handleIncomingMessage(world *w) {              // An incoming message is st
                     if (n_nodes==1) {
                       float t_incub = (float) (ip->t_contact+w->P->getLatentPeriodLength(thread_no));           // Sample latent period
                       ip->personPointer->status-=STATUS_SUSCEPTIBLE;                                            // And now they've been contacted.
+                      queueSusceptibleRemoval(w,thread_no,ip->personPointer);
+                      logInfection(w,thread_no,NULL,src,ip->personPointer,ip->t_contact,EVENT_COMMUNITY,0);
                       ip->personPointer->status+=STATUS_CONTACTED;                                              
                       
                       unsigned short timeStepsAway = (unsigned short) ((t_incub-w->T)/w->P->timestep_hours);       // Number of timesteps between now, and contact time
                       timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;                        // Modulo maths to choose the right list
-                      w->contactQueue[thread_no][timeStepsAway].push_back(ip);                                     // And schedule the individual for the contact-finding algorithm in that timestep.
+                      scheduleEvent(w,w->contactQueue,thread_no,timeStepsAway,ip);                                     // And schedule the individual for the contact-finding algorithm in that timestep.
 
                       timeStepsAway = (unsigned short) ((w->P->symptom_delay+t_incub-w->T)/w->P->timestep_hours);  // Calculate time of onset of symptoms
                       timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;
-                      w->symptomQueue[thread_no][timeStepsAway].push_back(ip);                                     // Schedule "detection" event
+                      scheduleEvent(w,w->symptomQueue,thread_no,timeStepsAway,ip);                                     // Schedule "detection" event
 
 
 
@@ -570,15 +604,17 @@ void handleIncomingMessage(world *w) {              // An incoming message is st
                     // It will be done when the contact queue is processed.
 
                     ip->personPointer->status-=STATUS_SUSCEPTIBLE;
+                    queueSusceptibleRemoval(w,thread_no,ip->personPointer);
+                    logInfection(w,thread_no,NULL,home_node,ip->personPointer,ip->t_contact,EVENT_COMMUNITY,0);
                     ip->personPointer->status+=STATUS_CONTACTED;                        // And now they've been contacted.
                                         
                     unsigned short timeStepsAway = (unsigned short) floor((t_incub-w->T)/w->P->timestep_hours);        // Number of timesteps between now, and contact time
                     timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;      // Modulo maths to choose the right list
-                    w->contactQueue[thread_no][timeStepsAway].push_back(ip);                   // And schedule the individual for the contact-finding algorithm in that timestep.
+                    scheduleEvent(w,w->contactQueue,thread_no,timeStepsAway,ip);                   // And schedule the individual for the contact-finding algorithm in that timestep.
 
                     timeStepsAway = (unsigned short) floor((w->P->symptom_delay+t_incub-w->T)/w->P->timestep_hours);
                     timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;
-                    w->symptomQueue[thread_no][timeStepsAway].push_back(ip);
+                    scheduleEvent(w,w->symptomQueue,thread_no,timeStepsAway,ip);
 
                     compare_mine=(unsigned short) orders.size();                               // Terminate the loop
                   } else compare_mine++;                                                       // Otherwise keep looking
@@ -590,8 +626,11 @@ void handleIncomingMessage(world *w) {              // An incoming message is st
       } // End outer src<w->mpi_size
     } // End thread loop OMP
     // Now deal with establishment messages.
-    // Single-thread this - not worth the overhead.
+    // Single-thread this - not worth the overhead. (Master, so that thread 0's random stream is used as before.)
 
+    #pragma omp master
+    {
+    reseedTask(w,0,PHASE_HANDLE,w->thread_count);
     msg_ptr=0;
     for (src=0; src<w->mpi_size; src++) {
       msg_ptr+=w->req_bytes_from[src];
@@ -613,7 +652,7 @@ void handleIncomingMessage(world *w) {              // An incoming message is st
         msg_ptr+=8;
         double t_inf = *(double*) (&(w->message_in)[msg_ptr]);
         msg_ptr+=8;
-        makePlaceContactRemote(w,0,country,place_type,place_no,host_no,t_inf,infectiousness,new_contact_time);
+        makePlaceContactRemote(w,0,country,place_type,place_no,host_no,t_inf,infectiousness,new_contact_time,src);
       }
       
       place_bytes = *(int*) (&(w->message_in)[msg_ptr]);
@@ -645,11 +684,14 @@ void handleIncomingMessage(world *w) {              // An incoming message is st
         msg_ptr+=4;
         float end = *(float*) (&(w->message_in)[msg_ptr]);
         msg_ptr+=4;
-        w->places[country][place_type].at(place_no)->applyProphylaxisRemote(w,0,start,end);
+        w->places[country][place_type].at(place_no)->applyProphylaxisRemote(w,0,place_type,start,end);
       }
     }
+    } // End omp master
+    #pragma omp barrier
   } // If num bytes...
 
+  #pragma omp for schedule(static,1)
   for (thread_no=0; thread_no<w->thread_count; thread_no++) {
     w->reqHostAddresses[thread_no][w->con_toggle].clear();
     for (int i=0; i<w->reqOrders[thread_no][w->con_toggle].size(); i++)
@@ -665,6 +707,23 @@ void handleIncomingMessage(world *w) {              // An incoming message is st
   errline=10650;
 }
 
+inline void acceptCommunityContact(world* w, int thread_no, infectedPerson* infected, person* susceptible,
+    int& n_local, unsigned short& contact_no, float new_contact_time) {
+  if ((susceptible->status&STATUS_SUSCEPTIBLE)>0) {      // If contact is susceptible  ***** THREAD SAFETY *****
+    if (ranf_mt(thread_no)<susceptible->getSusceptibility(w,thread_no)*infected->getInfectiousness(w,new_contact_time,thread_no)) {
+      infectedPerson* ip = new infectedPerson(w,thread_no,susceptible);  //   Create infected person object  ******** PERFORMANCE *******
+      ip->t_contact=new_contact_time;                   //   Time of contact (currently float...)
+      infected->contacts[n_local]=ip;                   //   Store pointer for infecter person - confirm later
+      ip->travel_plan=NULL;                             //   For now, default is the susceptible has no travel plan. We fix this later.
+      // Note - not going to update the stats here - because contact is not confirmed.
+    }
+
+  } else infected->contacts[n_local]=NULL;            // ELSE - contact was found, but was not susceptible.
+  infected->contact_order[n_local]=contact_no;        // Keep track of which contact no. this local contact was.
+  n_local++;                                          // Update local contact counter.
+  contact_no++;                                       // Update "Global" contact counter.
+}
+
 void makeCommunityContact(world *w, int thread_no, localPatch* infector_patch, double lon, double lat, 
     infectedPerson* infected, int& n_local, unsigned short& contact_no, short& n_contacts, float new_contact_time) {
   
@@ -673,12 +732,13 @@ void makeCommunityContact(world *w, int thread_no, localPatch* infector_patch, d
   if (location_susceptible->node==w->mpi_rank) {                                                                          // If susceptible's patch is on local node, then pick individual (below)
     localPatch* localpatch_susceptible = static_cast<localPatch*>(location_susceptible);                                  //   It's definitely a local patch, so cast.
     person* susceptible = &localpatch_susceptible->people[(int)(localpatch_susceptible->no_people*ranf_mt(thread_no))];   //   Choose random susceptible
+    unitHot* i_unit = &w->unit_hot[infected->personPointer->getHouse()->unit];
     bool border_restrict = false;
-    if (w->a_units[infected->personPointer->house->unit].bc_deny_exit>=0) {
-      int country1 = w->a_units[infected->personPointer->house->unit].country;
-      int country2 = w->a_units[susceptible->house->unit].country;
+    if (i_unit->bc_deny_exit>=0) {
+      int country1 = i_unit->country;
+      int country2 = w->unit_hot[susceptible->getHouse()->unit].country;
       if (country1!=country2) {
-        if (ranf_mt(thread_no)<w->a_units[infected->personPointer->house->unit].bc_deny_exit) {
+        if (ranf_mt(thread_no)<i_unit->bc_deny_exit) {
           border_restrict = true;
         }
       }
@@ -686,36 +746,25 @@ void makeCommunityContact(world *w, int thread_no, localPatch* infector_patch, d
 
     if (!border_restrict) {
       double D_kk2 = patch::distance(infector_patch,location_susceptible);                                                  //   Dk,k' is shortest distance between patches
-      double r_ij = haversine(lon,lat,susceptible->house->lon,susceptible->house->lat);                                     //   r_ij is absolute distance between people
-      double S_ij = unit::kernel_F(&w->a_units[infected->personPointer->house->unit],r_ij);
-      S_ij /= unit::kernel_F(&w->a_units[infected->personPointer->house->unit],D_kk2);
+      double r_ij = haversine(lon,lat,susceptible->getHouse()->lon,susceptible->getHouse()->lat);                                     //   r_ij is absolute distance between people
+      double S_ij = unitHot::kernel_F(i_unit,r_ij);
+      S_ij /= unitHot::kernel_F(i_unit,D_kk2);
  
       if (ranf_mt(thread_no)<S_ij) {                        // Contact is accepted
-        if ((susceptible->status&STATUS_SUSCEPTIBLE)>0) {      // If contact is susceptible  ***** THREAD SAFETY *****
-          if (ranf_mt(thread_no)<susceptible->getSusceptibility(w,thread_no)*infected->getInfectiousness(w,new_contact_time,thread_no)) {
-            infectedPerson* ip = new infectedPerson(w,thread_no,susceptible);  //   Create infected person object  ******** PERFORMANCE *******
-            ip->t_contact=new_contact_time;                   //   Time of contact (currently float...)
-            infected->contacts[n_local]=ip;                   //   Store pointer for infecter person - confirm later
-            ip->travel_plan=NULL;                             //   For now, default is the susceptible has no travel plan. We fix this later.
-            // Note - not going to update the stats here - because contact is not confirmed.
-          }
-     
-        } else infected->contacts[n_local]=NULL;            // ELSE - contact was found, but was not susceptible.
-        infected->contact_order[n_local]=contact_no;        // Keep track of which contact no. this local contact was.
-        n_local++;                                          // Update local contact counter.
-        contact_no++;                                       // Update "Global" contact counter.
+        acceptCommunityContact(w,thread_no,infected,susceptible,n_local,contact_no,new_contact_time);
       }
     } 
   } else {                              // ELSE - Susceptible is on a remote node
+    unitHot* i_unit = &w->unit_hot[infected->personPointer->getHouse()->unit];
     bool border_restrict = false;
-    if (w->a_units[infected->personPointer->house->unit].bc_deny_exit>=0) {
-      int country1 = w->a_units[infected->personPointer->house->unit].country;
-      int country2 = w->a_units[location_susceptible->unit].country;
+    if (i_unit->bc_deny_exit>=0) {
+      int country1 = i_unit->country;
+      int country2 = w->unit_hot[location_susceptible->unit].country;
       if (country1!=country2) border_restrict=true;
     }
     if (!border_restrict) {   
       if (contact_no<n_contacts*10) {     //   At most request 10 times as many remotes as locals. (Reduce MPI burden)
-        addRemoteRequest(w,thread_no,location_susceptible,infected->personPointer->house->lon,infected->personPointer->house->lat,infected,new_contact_time,contact_no,location_susceptible->node);
+        addRemoteRequest(w,thread_no,location_susceptible,infected->personPointer->getHouse()->lon,infected->personPointer->getHouse()->lat,infected,new_contact_time,contact_no,location_susceptible->node);
         contact_no++;
       }
     }
@@ -723,6 +772,138 @@ void makeCommunityContact(world *w, int thread_no, localPatch* infector_patch, d
   errline=10708;
 }
 
+// Acceptance test for a block of community contact candidates: accept[k] = rnd[k] < F(r)/F(D), where r is the distance
+// from (lon,lat) to (lon2[k],lat2[k]) and D[k] the distance between the patches. The same sums as haversine() and
+// unitHot::kernel_F, written with no branches in the loops so that they vectorise: beyond k_cut, the table lookup
+// goes to the zero entries after the end of the table, and the exact kernel's pow overflows to give 0.
+
+SIMD_CLONES
+void contactBlockAccept(int n, unitHot* u, double lon, double lat, const double* lon2, const double* lat2,
+    const double* D, const double* rnd, unsigned char* accept) {
+  const double R = 6371.297; // km
+  const double PId180 = 3.14159265359/180.0;
+  const double lat1 = lat*PId180;
+  const double lon1 = lon*PId180;
+  const double cos_lat1 = cos(lat1);
+  const double k_cut = u->k_cut;
+  if (u->kernel_table>=0) {
+    const double* f = unitHot::kernel_tables[u->kernel_table].f;
+    const double scale = unitHot::kernel_tables[u->kernel_table].scale;
+    const int zero = unitHot::kernel_tables[u->kernel_table].n;
+    SIMD_LOOP
+    for (int k=0; k<n; k++) {
+      double dLat = (lat2[k]*PId180)-lat1;
+      double dLon = (lon2[k]*PId180)-lon1;
+      double a = sin(dLat/2) * sin(dLat/2) + cos_lat1 * cos(lat2[k]*PId180) * sin(dLon/2) * sin(dLon/2);
+      double r = R * 2 * atan2(sqrt(a), sqrt(fabs(1-a)));  // fabs, not a clamp, for a>1 by rounding - see haversine
+      double x = std::min(r,k_cut)*scale;
+      double y = std::min(D[k],k_cut)*scale;
+      int i = (r<=k_cut)?(int) x:zero;
+      int j = (D[k]<=k_cut)?(int) y:zero;
+      double F_r = f[i]+((x-(int) x)*(f[i+1]-f[i]));
+      double F_D = f[j]+((y-(int) y)*(f[j+1]-f[j]));
+      accept[k] = (rnd[k]<F_r/F_D)?1:0;
+    }
+  } else {
+    const double k_a = u->k_a;
+    const double k_b = u->k_b;
+    SIMD_LOOP
+    for (int k=0; k<n; k++) {
+      double dLat = (lat2[k]*PId180)-lat1;
+      double dLon = (lon2[k]*PId180)-lon1;
+      double a = sin(dLat/2) * sin(dLat/2) + cos_lat1 * cos(lat2[k]*PId180) * sin(dLon/2) * sin(dLon/2);
+      double r = R * 2 * atan2(sqrt(a), sqrt(fabs(1-a)));  // fabs, not a clamp, for a>1 by rounding - see haversine
+      double q_r = std::max(r/k_a,(r>k_cut)?1e300:0.0);    // Beyond k_cut, pow overflows and F is 0
+      double q_D = std::max(D[k]/k_a,(D[k]>k_cut)?1e300:0.0);
+      double F_r = 1.0/(1.0+pow(q_r,k_b));
+      double F_D = 1.0/(1.0+pow(q_D,k_b));
+      accept[k] = (rnd[k]<F_r/F_D)?1:0;
+    }
+  }
+}
+
+// Community contacts for an infector who is at home for the whole infectious period (no travel plan) - the same
+// process as calling makeCommunityContact until n_contacts are found, but in blocks of candidates:
+//   1. Draw each candidate's time, patch and (if local) person, and apply border control.
+//   2. Test distances and kernel ratios for the whole block at once (contactBlockAccept).
+//   3. Compact to the remote and accepted local candidates, and process them in the order they were drawn, so
+//      contact_no and contact_order count exactly as before. Anything left in the block when n_local reaches
+//      n_contacts is discarded.
+// Random numbers are drawn in a different order from the one-at-a-time path, so runs are statistically, not
+// bitwise, the same; /noblock switches back for comparison.
+
+void makeCommunityContactBlock(world* w, int thread_no, infectedPerson* infected, int& n_local, unsigned short& contact_no, short& n_contacts) {
+  errline=10710;
+  float t[CONTACT_BLOCK];
+  patch* loc[CONTACT_BLOCK];
+  person* sus[CONTACT_BLOCK];
+  unsigned char kind[CONTACT_BLOCK];
+  double lon2[CONTACT_BLOCK],lat2[CONTACT_BLOCK],D[CONTACT_BLOCK],rnd[CONTACT_BLOCK];
+  unsigned char accept[CONTACT_BLOCK];
+  int keep[CONTACT_BLOCK];
+
+  person* infector = infected->personPointer;
+  localPatch* infector_patch = w->localPatchList[infector->getHouse()->patch];
+  double lon = infector->getHouse()->lon;
+  double lat = infector->getHouse()->lat;
+  unitHot* i_unit = &w->unit_hot[infector->getHouse()->unit];
+
+  while (n_local<n_contacts) {
+    int n = 2*(n_contacts-n_local);                 // Don't draw many more candidates than could be needed
+    if (n<4) n=4;
+    if (n>CONTACT_BLOCK) n=CONTACT_BLOCK;
+
+    for (int k=0; k<n; k++) {
+      t[k] = (float) (w->T+w->P->timestep_hours+(ranf_mt(thread_no)*infected->t_inf));
+      loc[k] = patch::getCommunityContactPatch(w,ranf_mt(thread_no),infector_patch);
+      lon2[k]=lon;                                  // Rejected and remote candidates get a harmless distance
+      lat2[k]=lat;
+      D[k]=0;
+      rnd[k]=2;
+      if (loc[k]->node==w->mpi_rank) {
+        localPatch* lp = static_cast<localPatch*>(loc[k]);
+        sus[k] = &lp->people[(int)(lp->no_people*ranf_mt(thread_no))];
+        kind[k]=CAND_LOCAL;
+        if ((i_unit->bc_deny_exit>=0) && (i_unit->country!=w->unit_hot[sus[k]->getHouse()->unit].country)) {
+          if (ranf_mt(thread_no)<i_unit->bc_deny_exit) kind[k]=CAND_REJECTED;
+        }
+        if (kind[k]==CAND_LOCAL) {
+          lon2[k]=sus[k]->getHouse()->lon;
+          lat2[k]=sus[k]->getHouse()->lat;
+          D[k]=patch::distance(infector_patch,loc[k]);
+          rnd[k]=ranf_mt(thread_no);
+        }
+      } else {
+        kind[k]=CAND_REMOTE;
+        if ((i_unit->bc_deny_exit>=0) && (i_unit->country!=w->unit_hot[loc[k]->unit].country)) kind[k]=CAND_REJECTED;
+      }
+    }
+
+    contactBlockAccept(n,i_unit,lon,lat,lon2,lat2,D,rnd,accept);
+
+    int m=0;
+    for (int k=0; k<n; k++) {
+      if ((kind[k]==CAND_REMOTE) || ((kind[k]==CAND_LOCAL) && (accept[k]))) keep[m++]=k;
+    }
+
+    for (int c=0; (c<m) && (n_local<n_contacts); c++) {
+      int k=keep[c];
+      if (kind[k]==CAND_REMOTE) {
+        if (contact_no<n_contacts*10) {     //   At most request 10 times as many remotes as locals. (Reduce MPI burden)
+          addRemoteRequest(w,thread_no,loc[k],lon,lat,infected,t[k],contact_no,loc[k]->node);
+          contact_no++;
+        }
+      } else acceptCommunityContact(w,thread_no,infected,sus[k],n_local,contact_no,t[k]);
+
+      if (contact_no>n_contacts*10) {
+        for (unsigned int j=n_local; j<(unsigned int) n_contacts; j++) infected->contact_order[j]=(unsigned short) (contact_no+j);
+        n_local=n_contacts;
+      }
+    }
+  }
+  errline=10711;
+}
+
 void makeHouseholdContacts(world* w, int thread_no, infectedPerson* infected) {
   errline=10712;
   double new_contact_time,p_contact;
@@ -739,28 +920,29 @@ void makeHouseholdContacts(world* w, int thread_no, infectedPerson* infected) {
 
   float adjust_for_swp_closure=1;
   if ((infected->personPointer->place_type>=0) && (infected->personPointer->place_type<=w->P->no_place_types)) {
-    if (infected->personPointer->place<w->no_places[infected->personPointer->house->country][infected->personPointer->place_type]) {
-      if (w->places[infected->personPointer->house->country][infected->personPointer->place_type].at(infected->personPointer->place)->closure_start>=0) {
-        if ((w->T>=w->places[infected->personPointer->house->country][infected->personPointer->place_type].at(infected->personPointer->place)->closure_start)
-          && (w->T<=w->places[infected->personPointer->house->country][infected->personPointer->place_type].at(infected->personPointer->place)->closure_end)) {
-           adjust_for_swp_closure=(float) w->a_units[infected->personPointer->house->unit].c_hh_mul;
+    if (infected->personPointer->place<w->no_places[infected->personPointer->getHouse()->country][infected->personPointer->place_type]) {
+      if (w->places[infected->personPointer->getHouse()->country][infected->personPointer->place_type].at(infected->personPointer->place)->closure_start>=0) {
+        if ((w->T>=w->places[infected->personPointer->getHouse()->country][infected->personPointer->place_type].at(infected->personPointer->place)->closure_start)
+          && (w->T<=w->places[infected->personPointer->getHouse()->country][infected->personPointer->place_type].at(infected->personPointer->place)->closure_end)) {
+           adjust_for_swp_closure=(float) w->unit_hot[infected->personPointer->getHouse()->unit].c_hh_mul;
         }
       }
     }
   }
 
-  patch = w->localPatchList[infected->personPointer->house->patch];
-  for (i=0; i<infected->personPointer->house->no_people; i++) {
+  patch = w->localPatchList[infected->personPointer->getHouse()->patch];
+  for (i=0; i<infected->personPointer->getHouse()->no_people; i++) {
   
-    susceptible=&patch->people[infected->personPointer->house->first_person+i];
+    susceptible=&patch->people[infected->personPointer->getHouse()->first_person+i];
     if (susceptible!=infected->personPointer) {
-      double seas=w->a_units[susceptible->house->unit].getSeasonality(w,susceptible->house->lat);
-      p_contact=1-(exp((-w->a_units[susceptible->house->unit].B_hh*seas*(t_at_home/24.0))/(susceptible->house->no_people-1)));
+      unitHot* s_unit = &w->unit_hot[susceptible->getHouse()->unit];
+      double seas=s_unit->getSeasonality(w,susceptible->getHouse()->lat);
+      p_contact=1-(exp((-s_unit->B_hh*seas*(t_at_home/24.0))/(susceptible->getHouse()->no_people-1)));
       
       // Multiply p_contact if this household is quarantined
-      if (susceptible->house->q_start>=0) {
-        if ((w->T>=susceptible->house->q_start) && (w->T<=susceptible->house->q_end)) {
-          p_contact*=w->a_units[susceptible->house->unit].q_hh_rate;
+      if (susceptible->getHouse()->getQStart()>=0) {
+        if ((w->T>=susceptible->getHouse()->getQStart()) && (w->T<=susceptible->getHouse()->getQEnd())) {
+          p_contact*=s_unit->q_hh_rate;
         }
       }
         
@@ -773,15 +955,17 @@ void makeHouseholdContacts(world* w, int thread_no, infectedPerson* infected) {
           if (ranf_mt(thread_no)<susceptible->getSusceptibility(w,thread_no)*infected->getInfectiousness(w,new_contact_time,thread_no)) {
 
             susceptible->status-=STATUS_SUSCEPTIBLE;
+            queueSusceptibleRemoval(w,thread_no,susceptible);
+            logInfection(w,thread_no,infected->personPointer,w->mpi_rank,susceptible,(float) new_contact_time,EVENT_HOUSEHOLD,0);
             susceptible->status+=STATUS_CONTACTED;
 
             potential_trigger=true;
             infectedPerson* ip = new infectedPerson(w,thread_no,susceptible);
-            w->a_units[susceptible->house->unit].add_hh_case(w,susceptible->house->unit,thread_no,
+            w->a_units[susceptible->getHouse()->unit].add_hh_case(w,susceptible->getHouse()->unit,thread_no,
                 (ip->flags & (SYMPTOMATIC+DETECTED))==SYMPTOMATIC+DETECTED);
             ip->t_contact=(float)new_contact_time;
             ip->travel_plan=NULL;
-            susceptible->house->susc_people--;
+            susceptible->getHouse()->susc_people--;
             ip->t_inf = w->P->getInfectiousPeriodLength(thread_no);          // Sample infectious period - HOURS
             float latent_period = w->P->getLatentPeriodLength(thread_no);    // Sample latent period - HOURS
             float latent_end = ip->t_contact+latent_period;                  // Calculate end of latent period
@@ -789,10 +973,10 @@ void makeHouseholdContacts(world* w, int thread_no, infectedPerson* infected) {
             int timeStepsAway = (int) ((latent_end-w->T)/w->P->timestep_hours);                    // Number of timesteps between now, and contact time
 
             timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;                    // Modulo maths to choose the right list
-            w->contactQueue[thread_no][timeStepsAway].push_back(ip);  // And schedule the individual for the contact-finding algorithm in that timestep.
+            scheduleEvent(w,w->contactQueue,thread_no,timeStepsAway,ip);  // And schedule the individual for the contact-finding algorithm in that timestep.
             timeStepsAway = (int) ((w->P->symptom_delay+latent_end-w->T)/w->P->timestep_hours);
             timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;
-            w->symptomQueue[thread_no][timeStepsAway].push_back(ip);
+            scheduleEvent(w,w->symptomQueue,thread_no,timeStepsAway,ip);
 
             if ((ip->flags & (SYMPTOMATIC+DETECTED))==SYMPTOMATIC+DETECTED) potential_trigger=true;
 
@@ -803,43 +987,36 @@ void makeHouseholdContacts(world* w, int thread_no, infectedPerson* infected) {
   }
 
   if (potential_trigger) {
-    if (w->a_units[susceptible->house->unit].pph_susc>=0) susceptible->house->applyProphylaxis(w,thread_no);
-    if (w->a_units[susceptible->house->unit].q_compliance>0) susceptible->house->applyQuarantine(w,thread_no);
+    if (w->a_units[susceptible->getHouse()->unit].pph_susc>=0) susceptible->getHouse()->applyProphylaxis(w,thread_no);
+    if (w->a_units[susceptible->getHouse()->unit].q_compliance>0) susceptible->getHouse()->applyQuarantine(w,thread_no);
   }
   errline=10794;
 }
 
 void makePlaceContactRemote(world* w, int thread_no, unsigned char country, unsigned char place_type, unsigned int place_no,
-    unsigned int host_no, double t_inf, double infectiousness,double new_contact_time) {
+    unsigned int host_no, double t_inf, double infectiousness,double new_contact_time, int src_node) {
     
   errline=10800;
   person* susceptible;
-  place* e = w->places[country][place_type].at(place_no);
+  placeList* pl = &w->places[country][place_type];
+  place* e = pl->at(place_no);
   
-  int node_no=0;
-  int group_no=0;
-  unsigned int accumulator=0;
-
-  while (accumulator+e->group_member_node_count[group_no][node_no]<=host_no) {
-    accumulator+=e->group_member_node_count[group_no][node_no];
-    node_no++;
-    if (node_no>=w->mpi_size) {
-      node_no=0;
-      group_no++;
-    }
-  }
-
-  host_no-=accumulator;  // On remote node, host_no will have had an offset. Remove it here.
-  susceptible = e->local_members[group_no][host_no];
+  int node_no,group_no;
+  host_no=pl->findHost(e,host_no,0,e->no_groups*e->no_nodes,&group_no,&node_no,
+                       &w->place_search[thread_no].probes);   // Removes the offset of earlier groups and nodes
+  w->place_search[thread_no].selections++;
+  susceptible = pl->groupMembers(e,group_no)[host_no];
   if ((susceptible->status & STATUS_SUSCEPTIBLE)>0) {
     new_contact_time = (w->T+w->P->timestep_hours+(ranf_mt(thread_no)*t_inf)); // Pick random (uniform) time (hours) for a contact to be scheduled
     if (ranf_mt(thread_no)<susceptible->getSusceptibility(w,thread_no)*infectiousness) {
       infectedPerson* ip = new infectedPerson(w,thread_no,susceptible);
-      w->a_units[susceptible->house->unit].add_place_case(w,susceptible->house->unit,place_type,thread_no,
+      w->a_units[susceptible->getHouse()->unit].add_place_case(w,susceptible->getHouse()->unit,place_type,thread_no,
           (ip->flags & (SYMPTOMATIC+DETECTED))==SYMPTOMATIC+DETECTED);
       ip->t_contact=(float)new_contact_time;
       ip->travel_plan=NULL;
       susceptible->status-=STATUS_SUSCEPTIBLE;
+      queueSusceptibleRemoval(w,thread_no,susceptible);
+      logInfection(w,thread_no,NULL,src_node,susceptible,(float) new_contact_time,EVENT_PLACE,place_type);
       susceptible->status+=STATUS_CONTACTED;
       ip->t_inf = w->P->getInfectiousPeriodLength(thread_no);              // Infectious period (hours)
       float latent_period = w->P->getLatentPeriodLength(thread_no);        // Latent period (hours)
@@ -847,10 +1024,10 @@ void makePlaceContactRemote(world* w, int thread_no, unsigned char country, unsi
       ip->createTravelPlan(w, ip, thread_no, latent_end);
       int timeStepsAway = (int) ((latent_end-w->T)/w->P->timestep_hours);                    // Number of timesteps between now, and contact time
       timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;                    // Modulo maths to choose the right list
-      w->contactQueue[thread_no][timeStepsAway].push_back(ip);  // And schedule the individual for the contact-finding algorithm in that timestep.
+      scheduleEvent(w,w->contactQueue,thread_no,timeStepsAway,ip);  // And schedule the individual for the contact-finding algorithm in that timestep.
       timeStepsAway = (int) ((w->P->symptom_delay+latent_end-w->T)/w->P->timestep_hours);
       timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;
-      w->symptomQueue[thread_no][timeStepsAway].push_back(ip);
+      scheduleEvent(w,w->symptomQueue,thread_no,timeStepsAway,ip);
 
     }
   }
@@ -865,71 +1042,66 @@ void makePlaceContacts(world* w, int thread_no, infectedPerson* infected) {
   person* susceptible;
   bool apply_proph_or_closure=false;
   unsigned char place_type = infected->personPointer->place_type;
-  unsigned char country = infected->personPointer->house->country;
+  unsigned char country = infected->personPointer->getHouse()->country;
   double t_at_home=0.0;
-  place* e = w->places[country][place_type].at(infected->personPointer->place);
+  placeList* pl = &w->places[country][place_type];
+  place* e = pl->at(infected->personPointer->place);
+  unsigned int own_group = e->first_group+infected->personPointer->group;   // Index of infected's group in pl's arrays
   
   if ((e->closure_start<0) || (w->T<e->closure_start) || (w->T>e->closure_end)) {  // If the place is not closed...
   
     if (infected->travel_plan==NULL) t_at_home=infected->t_inf;
     else t_at_home=infected->t_inf-infected->travel_plan->duration;
 
-    double p_contact = 1-exp((-w->a_units[infected->personPointer->house->unit].B_place[place_type]*
-                       w->a_units[infected->personPointer->house->unit].getSeasonality(w,infected->personPointer->house->lat)*
+    double p_contact = 1-exp((-w->a_units[infected->personPointer->getHouse()->unit].B_place[place_type]*
+                       w->unit_hot[infected->personPointer->getHouse()->unit].getSeasonality(w,infected->personPointer->getHouse()->lat)*
                        (t_at_home/24.0))/(e->total_hosts-1));
 
-    if (infected->personPointer->house->q_start>=0) {
-      if ((w->T>=infected->personPointer->house->q_start) && (w->T<=infected->personPointer->house->q_end)) {
-        p_contact*=w->a_units[infected->personPointer->house->unit].q_s_wp_rate;
+    if (infected->personPointer->getHouse()->getQStart()>=0) {
+      if ((w->T>=infected->personPointer->getHouse()->getQStart()) && (w->T<=infected->personPointer->getHouse()->getQEnd())) {
+        p_contact*=w->unit_hot[infected->personPointer->getHouse()->unit].q_s_wp_rate;
       }
     }
 
     unsigned int n_contacts = (unsigned int) ignbin_mt(e->total_hosts-1,p_contact,thread_no);
-    unsigned int accumulator=0;
-    unsigned int within_group_contacts=(int) (0.5+(n_contacts*w->a_units[infected->personPointer->house->unit].P_group[infected->personPointer->place_type]));
+    unsigned int within_group_contacts=(int) (0.5+(n_contacts*w->a_units[infected->personPointer->getHouse()->unit].P_group[infected->personPointer->place_type]));
     i=0;
     while (i<n_contacts) {
       unsigned int host_no;
+      unsigned int search_lo,search_hi;           // Range of e's [group][node] entries the host can be in
       if (i<within_group_contacts) {              // Choose the within-group contacts
-        host_no=(int) (ranf_mt(thread_no)*e->group_member_count[infected->personPointer->group]);
-        for (int j=0; j<infected->personPointer->group; j++)
-          host_no+=e->group_member_count[j]; // Add people in previous groups to host_no.
+        host_no=(int) (ranf_mt(thread_no)*pl->group_member_count[own_group]);
+        host_no+=pl->group_first_host[own_group];  // Add people in previous groups to host_no.
+        search_lo=infected->personPointer->group*e->no_nodes;
+        search_hi=search_lo+e->no_nodes;
       
       } else {                                    // Choose the outside-group contacts
-        host_no=(int) (ranf_mt(thread_no)*(e->total_hosts-e->group_member_count[infected->personPointer->group]));
-      
-        unsigned int host_counter=0;
-        for (int j=0; j<infected->personPointer->group; j++) host_counter+=e->group_member_count[j];
-        if (host_no>host_counter) host_no+=e->group_member_count[infected->personPointer->group];
+        host_no=(int) (ranf_mt(thread_no)*(e->total_hosts-pl->group_member_count[own_group]));
+        if (host_no>pl->group_first_host[own_group]) host_no+=pl->group_member_count[own_group];
+        search_lo=0;
+        search_hi=e->no_groups*e->no_nodes;
       }
 
-      int node_no=0;
-      int group_no=0;
-      accumulator=0;
-      
-      while (accumulator+e->group_member_node_count[group_no][node_no]<=host_no) {
-        accumulator+=e->group_member_node_count[group_no][node_no];
-        node_no++;
-        if (node_no>=e->no_nodes) {
-          node_no=0;
-          group_no++;
-        }
-      }
+      int node_no,group_no;
+      unsigned int member_no=pl->findHost(e,host_no,search_lo,search_hi,&group_no,&node_no,&w->place_search[thread_no].probes);
+      w->place_search[thread_no].selections++;
 
       if ((e->no_nodes==1) || (node_no==w->mpi_rank)) {
-        host_no-=accumulator;   // Remove offset - hosts will start from 0 in the array for local host.
-        susceptible = e->local_members[group_no][host_no];
+        host_no=member_no;   // Remove offset - hosts will start from 0 in the array for local host.
+        susceptible = pl->groupMembers(e,group_no)[host_no];
 
         if ((susceptible->status & STATUS_SUSCEPTIBLE)>0) {
           new_contact_time=infected->getNextContactWhileAtHomeOrWorking(w,thread_no);
 
           if (ranf_mt(thread_no)<susceptible->getSusceptibility(w,thread_no)*infected->getInfectiousness(w,new_contact_time,thread_no)) {
             infectedPerson* ip = new infectedPerson(w,thread_no,susceptible);
-            w->a_units[susceptible->house->unit].add_place_case(w,susceptible->house->unit,place_type,thread_no,
+            w->a_units[susceptible->getHouse()->unit].add_place_case(w,susceptible->getHouse()->unit,place_type,thread_no,
                 (ip->flags & (SYMPTOMATIC+DETECTED))==SYMPTOMATIC+DETECTED);
             ip->t_contact=(float)new_contact_time;
             ip->travel_plan=NULL;
             susceptible->status-=STATUS_SUSCEPTIBLE;
+            queueSusceptibleRemoval(w,thread_no,susceptible);
+            logInfection(w,thread_no,infected->personPointer,w->mpi_rank,susceptible,(float) new_contact_time,EVENT_PLACE,place_type);
             susceptible->status+=STATUS_CONTACTED;
             ip->t_inf = w->P->getInfectiousPeriodLength(thread_no);
             float latent_period = w->P->getLatentPeriodLength(thread_no);
@@ -937,11 +1109,11 @@ void makePlaceContacts(world* w, int thread_no, infectedPerson* infected) {
             ip->createTravelPlan(w, ip, thread_no, latent_end);
             int timeStepsAway = (int) ((latent_end-w->T)/w->P->timestep_hours);                    // Number of timesteps between now, and contact time
             timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;                    // Modulo maths to choose the right list
-            w->contactQueue[thread_no][timeStepsAway].push_back(ip);  // And schedule the individual for the contact-finding algorithm in that timestep.
+            scheduleEvent(w,w->contactQueue,thread_no,timeStepsAway,ip);  // And schedule the individual for the contact-finding algorithm in that timestep.
   
             timeStepsAway = (int) ((w->P->symptom_delay+latent_end-w->T)/w->P->timestep_hours);
             timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;
-            w->symptomQueue[thread_no][timeStepsAway].push_back(ip);
+            scheduleEvent(w,w->symptomQueue,thread_no,timeStepsAway,ip);
 
             if ((ip->flags & (SYMPTOMATIC+DETECTED))==SYMPTOMATIC+DETECTED) apply_proph_or_closure=true;
           }
@@ -951,7 +1123,7 @@ void makePlaceContacts(world* w, int thread_no, infectedPerson* infected) {
 
         new_contact_time = (w->T+w->P->timestep_hours+(ranf_mt(thread_no)*infected->t_inf)); // Pick random (uniform) time (hours) for a contact to be scheduled
         double infectiousness = infected->getInfectiousness(w,new_contact_time,thread_no);
-        addPlaceInfectionMsg(w,thread_no,node_no,infected->personPointer->house->country,infected->personPointer->place_type,
+        addPlaceInfectionMsg(w,thread_no,node_no,infected->personPointer->getHouse()->country,infected->personPointer->place_type,
             infected->personPointer->place,host_no,new_contact_time,infectiousness,infected->t_inf);
 
       }
@@ -959,12 +1131,12 @@ void makePlaceContacts(world* w, int thread_no, infectedPerson* infected) {
       i++;
     }
     if (apply_proph_or_closure) {
-      if (w->a_units[susceptible->house->unit].pph_susc>=0) {
-        if (ranf_mt(thread_no)<w->a_units[susceptible->house->unit].pph_coverage)
-        w->places[susceptible->house->country][susceptible->place_type].at(susceptible->place)->applyProphylaxis(w,thread_no,susceptible->place_type,susceptible->place);
+      if (w->a_units[susceptible->getHouse()->unit].pph_susc>=0) {
+        if (ranf_mt(thread_no)<w->a_units[susceptible->getHouse()->unit].pph_coverage)
+        w->places[susceptible->getHouse()->country][susceptible->place_type].at(susceptible->place)->applyProphylaxis(w,thread_no,susceptible->place_type,susceptible->place);
       }
-      if (w->a_units[susceptible->house->unit].c_threshold>=0)
-        w->places[susceptible->house->country][susceptible->place_type].at(susceptible->place)->applyClosure(w,thread_no,susceptible->house->unit,susceptible->place_type,susceptible->place);
+      if (w->a_units[susceptible->getHouse()->unit].c_threshold>=0)
+        w->places[susceptible->getHouse()->country][susceptible->place_type].at(susceptible->place)->applyClosure(w,thread_no,susceptible->getHouse()->unit,susceptible->place_type,susceptible->place);
     }    
   } else if (w->T>e->closure_end) {
     e->closure_start=-1;
@@ -984,78 +1156,79 @@ void processConfirmationQueue(world *w) {
 
   // So, for each newly infected host, for each contact it has made, we schedule the moment when that contact will become infected, and choose its victims.
   // We also schedule the time when the infected host will recover - storing it in a separate array for each thread.
+  #pragma omp single
+  {
   w->con_toggle=1-w->con_toggle;   // Deal with the confirmations from the previous timestep (buffered)
+  w->work->fill(w->confirmQueue,w->con_toggle);
+  }
 
-  #pragma omp parallel for private(thread_no) schedule(static,1)
+  #pragma omp for schedule(static,1)
   for (thread_no=0; thread_no<w->thread_count; thread_no++) {
-    int queue_no=0;
-    int person_no=thread_no;
     infectedPerson* infected;
     int j;
 
     int timeStepsAway;
-    while ((queue_no<w->thread_count) && (person_no>=w->confirmQueue[queue_no][w->con_toggle].size())) {
-      person_no-=(int) w->confirmQueue[queue_no][w->con_toggle].size();
-      queue_no++;
-    }
-    while (queue_no<w->thread_count) {
-      infected = w->confirmQueue[queue_no][w->con_toggle].at(person_no);
-      if (infected==NULL) {
-        printf("%d,%d,%d, CQ Infected=NULL\n",w->mpi_rank,thread_no,w->T);
-        fflush(stdout);
-      } else {
-        if ((infected->personPointer->house->susc_people>0) &&
-           (infected->personPointer->house->no_people>0)) makeHouseholdContacts(w,thread_no,infected);
-        if ((infected->personPointer->place_type<w->P->no_place_types)
-           && (infected->personPointer->place<w->no_places[infected->personPointer->house->country][infected->personPointer->place_type]))
-           makePlaceContacts(w,thread_no,infected);
-
-        for (j=0; j<infected->n_contacts; j++) {         // For each new contact that individual i has chosen
-          if (infected->contacts[j]!=NULL) {
-            if ((infected->contacts[j]->personPointer->status & STATUS_SUSCEPTIBLE)>0) {      // They are susceptible...
-              infected->contacts[j]->personPointer->status-=STATUS_SUSCEPTIBLE;               // No longer susceptible
-              infected->contacts[j]->personPointer->status+=STATUS_CONTACTED;                 // Now contacted.
-              infected->contacts[j]->t_inf = w->P->getInfectiousPeriodLength(thread_no);      // Set infectious period
-              float latent_period = w->P->getLatentPeriodLength(thread_no);                   // Set latent period
-              float latent_end = infected->contacts[j]->t_contact+latent_period;              // Calculate end of latent period
-              infected->contacts[j]->createTravelPlan(w, infected->contacts[j], thread_no, latent_end);  // Decide travel plan
-              w->a_units[infected->contacts[j]->personPointer->house->unit].add_comm_case(w,
-                  infected->contacts[j]->personPointer->house->unit,thread_no,
-                  (infected->contacts[j]->flags & (SYMPTOMATIC+DETECTED))==SYMPTOMATIC+DETECTED);
-
-              // Schedule end of latent period
-
-              timeStepsAway = (int) ((latent_end-w->T)/w->P->timestep_hours);                    // Number of timesteps between now, and contact time
-              timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;                    // Modulo maths to choose the right list
-              w->contactQueue[thread_no][timeStepsAway].push_back(infected->contacts[j]);  // And schedule the individual for the contact-finding algorithm in that timestep.
-
-              // Schedule onset of symptoms
-
-              timeStepsAway = (int) ((latent_end+w->P->symptom_delay-w->T)/w->P->timestep_hours);
-              timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;
-              w->symptomQueue[thread_no][timeStepsAway].push_back(infected->contacts[j]);
+    int queue_no,person_no,last,chunk_id;
+    double t_busy=omp_get_wtime();
+    while (w->work->next(thread_no,&queue_no,&person_no,&last,&chunk_id)) {       // Claim a chunk - see workqueue.cpp
+      for (; person_no<last; person_no++) {
+        infected = w->confirmQueue[queue_no][w->con_toggle].at(person_no);
+        reseedPerson(w,thread_no,PHASE_CONFIRM,infected);
+        if (infected==NULL) {
+          printf("%d,%d,%d, CQ Infected=NULL\n",w->mpi_rank,thread_no,w->T);
+          fflush(stdout);
+        } else {
+          if ((infected->personPointer->getHouse()->susc_people>0) &&
+             (infected->personPointer->getHouse()->no_people>0)) makeHouseholdContacts(w,thread_no,infected);
+          if ((infected->personPointer->place_type<w->P->no_place_types)
+             && (infected->personPointer->place<w->no_places[infected->personPointer->getHouse()->country][infected->personPointer->place_type]))
+             makePlaceContacts(w,thread_no,infected);
+
+          for (j=0; j<infected->n_contacts; j++) {         // For each new contact that individual i has chosen
+            if (infected->contacts[j]!=NULL) {
+              if ((infected->contacts[j]->personPointer->status & STATUS_SUSCEPTIBLE)>0) {      // They are susceptible...
+                infected->contacts[j]->personPointer->status-=STATUS_SUSCEPTIBLE;               // No longer susceptible
+                queueSusceptibleRemoval(w,thread_no,infected->contacts[j]->personPointer);
+                logInfection(w,thread_no,infected->personPointer,w->mpi_rank,infected->contacts[j]->personPointer,infected->contacts[j]->t_contact,EVENT_COMMUNITY,0);
+                infected->contacts[j]->personPointer->status+=STATUS_CONTACTED;                 // Now contacted.
+                infected->contacts[j]->t_inf = w->P->getInfectiousPeriodLength(thread_no);      // Set infectious period
+                float latent_period = w->P->getLatentPeriodLength(thread_no);                   // Set latent period
+                float latent_end = infected->contacts[j]->t_contact+latent_period;              // Calculate end of latent period
+                infected->contacts[j]->createTravelPlan(w, infected->contacts[j], thread_no, latent_end);  // Decide travel plan
+                w->a_units[infected->contacts[j]->personPointer->getHouse()->unit].add_comm_case(w,
+                    infected->contacts[j]->personPointer->getHouse()->unit,thread_no,
+                    (infected->contacts[j]->flags & (SYMPTOMATIC+DETECTED))==SYMPTOMATIC+DETECTED);
+
+                // Schedule end of latent period
+
+                timeStepsAway = (int) ((latent_end-w->T)/w->P->timestep_hours);                    // Number of timesteps between now, and contact time
+                timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;                    // Modulo maths to choose the right list
+                scheduleEvent(w,w->contactQueue,thread_no,timeStepsAway,infected->contacts[j]);  // And schedule the individual for the contact-finding algorithm in that timestep.
+
+                // Schedule onset of symptoms
+
+                timeStepsAway = (int) ((latent_end+w->P->symptom_delay-w->T)/w->P->timestep_hours);
+                timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;
+                scheduleEvent(w,w->symptomQueue,thread_no,timeStepsAway,infected->contacts[j]);
+              }
             }
           }
-        }
 
-        delete [] infected->contacts;     // All done with the contacts.
-        infected->contacts=NULL;
-        infected->n_contacts=0;
-        timeStepsAway = (int) ((w->P->timestep_hours+infected->t_inf)/w->P->timestep_hours);   // Now schedule individual i's recovery - T_inf from now.
-        timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;                             // Modulo maths again,
+          delete [] infected->contacts;     // All done with the contacts.
+          live_memory[thread_no].contacts-=infected->contacts_alloc*sizeof(infectedPerson*);
+          infected->contacts=NULL;
+          infected->n_contacts=0;
+          timeStepsAway = (int) ((w->P->timestep_hours+infected->t_inf)/w->P->timestep_hours);   // Now schedule individual i's recovery - T_inf from now.
+          timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;                             // Modulo maths again,
         
-        w->recoveryQueue[thread_no][timeStepsAway].push_back(infected);                       // And schedule.
-      }
-
-       // Next individual
-      person_no+=w->thread_count;
-      while ((queue_no<w->thread_count) && (person_no>=w->confirmQueue[queue_no][w->con_toggle].size())) { // Dealt with all individuals in this thread queue.
-        person_no-=(int)w->confirmQueue[queue_no][w->con_toggle].size();
-        queue_no++;
+          scheduleEvent(w,w->recoveryQueue,thread_no,timeStepsAway,infected);                       // And schedule.
+        }
       }
     } // End of while loop - continue tricking through the arrays of confirmations.
+    w->busy_time[thread_no]+=omp_get_wtime()-t_busy;
   } // Have to break here since previous section adds to symptom queue
 
+  #pragma omp for schedule(static,1)
   for (thread_no=0; thread_no<w->thread_count; thread_no++) {
     w->confirmQueue[thread_no][w->con_toggle].clear();
   }
@@ -1068,33 +1241,31 @@ void processSymptomaticQueue(world *w) {
   // except by mitigation. It's for firing detection events at the right time.
 
   int thread_no;
-  #pragma omp parallel for private(thread_no) schedule(static,1)
+  #pragma omp single
+  w->work->fill(w->symptomQueue,w->infectionMod);
+  #pragma omp for schedule(static,1)
   for (thread_no=0; thread_no<w->thread_count; thread_no++) {
-    int queue_no=0;
-    int person_no=thread_no;
     infectedPerson* infected;
-    while ((queue_no<w->thread_count) && (person_no>=w->symptomQueue[queue_no][w->infectionMod].size())) {
-      person_no-=(int) w->symptomQueue[queue_no][w->infectionMod].size();
-      queue_no++;
-    }
-
-    while (queue_no<w->thread_count) {
-      infected = w->symptomQueue[queue_no][w->infectionMod].at(person_no);
-      if (infected==NULL) {
-        printf("%d,%d,%d, SQ Infected=NULL\n",w->mpi_rank,thread_no,w->T);
-        fflush(stdout);
-      } else {
-        infected->updateStats(w,thread_no,1,0);
-      }
-      person_no+=w->thread_count;
-      while ((queue_no<w->thread_count) && (person_no>=w->symptomQueue[queue_no][w->infectionMod].size())) { // Dealt with all individuals in this thread queue.
-        person_no-=(int)w->symptomQueue[queue_no][w->infectionMod].size();
-        queue_no++;
+    int queue_no,person_no,last,chunk_id;
+    double t_busy=omp_get_wtime();
+
+    while (w->work->next(thread_no,&queue_no,&person_no,&last,&chunk_id)) {       // Claim a chunk - see workqueue.cpp
+      for (; person_no<last; person_no++) {
+        infected = w->symptomQueue[queue_no][w->infectionMod].at(person_no);
+        reseedPerson(w,thread_no,PHASE_SYMPTOM,infected);
+        if (infected==NULL) {
+          printf("%d,%d,%d, SQ Infected=NULL\n",w->mpi_rank,thread_no,w->T);
+          fflush(stdout);
+        } else {
+          infected->updateStats(w,thread_no,1,0);
+        }
       }
     }
+    w->busy_time[thread_no]+=omp_get_wtime()-t_busy;
   } // End of OpenMP thread loop
+  #pragma omp for schedule(static,1)
   for (thread_no=0; thread_no<w->thread_count; thread_no++) {
-    w->symptomQueue[thread_no][w->infectionMod].clear();
+    clearSlot(w,w->symptomQueue,thread_no,w->infectionMod);
   }
   errline=101083;
 }
@@ -1103,41 +1274,37 @@ void processRecoveryQueue(world* w) {
   int thread_no;
   errline=101088;
 
-  #pragma omp parallel for private(thread_no) schedule(static,1)
+  #pragma omp single
+  w->work->fill(w->recoveryQueue,w->infectionMod);
+  #pragma omp for schedule(static,1)
   for (thread_no=0; thread_no<w->thread_count; thread_no++) {
-    int queue_no=0;
-    int person_no=thread_no;
     infectedPerson* infected;
-    while ((queue_no<w->thread_count) && (person_no>=w->recoveryQueue[queue_no][w->infectionMod].size())) {
-      person_no-=(int) w->recoveryQueue[queue_no][w->infectionMod].size();
-      queue_no++;
-    }
-
-    while (queue_no<w->thread_count) {
-      infected = w->recoveryQueue[queue_no][w->infectionMod].at(person_no);
+    int queue_no,person_no,last,chunk_id;
+    double t_busy=omp_get_wtime();
 
-      if (infected!=NULL) {
-        infected->personPointer->status-=STATUS_CONTACTED;
-        infected->personPointer->status+=STATUS_IMMUNE;
-        infected->updateStats(w,thread_no,-1,1);
-        delete infected;
+    while (w->work->next(thread_no,&queue_no,&person_no,&last,&chunk_id)) {       // Claim a chunk - see workqueue.cpp
+      for (; person_no<last; person_no++) {
+        infected = w->recoveryQueue[queue_no][w->infectionMod].at(person_no);
+        reseedPerson(w,thread_no,PHASE_RECOVERY,infected);
 
-      } else {
-        printf("%d,%d,%d, RQ Infected=NULL\n",w->mpi_rank,thread_no,w->T);
-        fflush(stdout);
-      }
+        if (infected!=NULL) {
+          infected->personPointer->status-=STATUS_CONTACTED;
+          infected->personPointer->status+=STATUS_IMMUNE;
+          infected->updateStats(w,thread_no,-1,1);
+          delete infected;
 
-      // Next individual
-      person_no+=w->thread_count;
-      while ((queue_no<w->thread_count) && (person_no>=w->recoveryQueue[queue_no][w->infectionMod].size()))  { // Dealt with all individuals in this thread queue.
-        person_no-=(int)w->recoveryQueue[queue_no][w->infectionMod].size();
-        queue_no++;
+        } else {
+          printf("%d,%d,%d, RQ Infected=NULL\n",w->mpi_rank,thread_no,w->T);
+          fflush(stdout);
+        }
       }
     }
+    w->busy_time[thread_no]+=omp_get_wtime()-t_busy;
   }
 
+  #pragma omp for schedule(static,1)
   for (thread_no=0; thread_no<w->thread_count; thread_no++) {
-    w->recoveryQueue[thread_no][w->infectionMod].clear();
+    clearSlot(w,w->recoveryQueue,thread_no,w->infectionMod);
   }
   errline=101126;
 }
@@ -1155,11 +1322,13 @@ void processContactQueue(world *w) {
   // Each contact that was chosen is added to the contact list for that individual.
   // The individual is then added to the confirm queue - and when replies of any MPI messages are received in the following timestep, the "tentative" contacts are then completed.
 
+  // Which thread takes which individuals is decided by w->work - chunks with work-stealing by default. See workqueue.cpp.
 
-
-  #pragma omp parallel for private(thread_no) schedule(static,1)
+  #pragma omp single
+  w->work->fill(w->contactQueue,w->infectionMod);
+  #pragma omp for schedule(static,1)
   for (thread_no=0; thread_no<w->thread_count; thread_no++) {
-    unit* i_unit;
+    unitHot* i_unit;
     int done_contact=0;
     int n_local;
     unsigned short contact_no=0; 
@@ -1171,269 +1340,394 @@ void processContactQueue(world *w) {
     person *visitor_person;
     double visitor_relocate_lon,visitor_relocate_lat;           // To store "temporary" lat/lon for a visitor.
     unsigned char visitor_unset;         // A flag that is '1' when a visitor has not been "identified" at his source location. (Has to be done!)
-    int queue_no=0;
-    int person_no=thread_no;
-    while ((queue_no<w->thread_count) && (person_no>=w->contactQueue[queue_no][w->infectionMod].size())) {
-      person_no-=(int) w->contactQueue[queue_no][w->infectionMod].size();
-      queue_no++;
-    }
-    while (queue_no<w->thread_count) {
-      contact_no=0;
-      visitor_unset=1;
-      visitor_person=NULL;
-      visitor_patch=NULL;
-      visitor_relocate_lat=-999;  // If I am a visitor, may need to set a temporary lat and lon. (exactly once).
-
-      infected = w->contactQueue[queue_no][w->infectionMod].at(person_no);
-      w->a_units[infected->personPointer->house->unit].contact_makers[thread_no]++;
-      int parent=w->a_units[infected->personPointer->house->unit].parent_id;
-      while (parent!=-1) {
-        w->a_units[parent].contact_makers[thread_no]++;
-        parent=w->a_units[parent].parent_id;
-      }
+    int queue_no,person_no,last,chunk_id;
+    double t_busy=omp_get_wtime();
+    while (w->work->next(thread_no,&queue_no,&person_no,&last,&chunk_id)) {       // Claim a chunk - see workqueue.cpp
+      for (; person_no<last; person_no++) {
+        contact_no=0;
+        visitor_unset=1;
+        visitor_person=NULL;
+        visitor_patch=NULL;
+        visitor_relocate_lat=-999;  // If I am a visitor, may need to set a temporary lat and lon. (exactly once).
+
+        infected = w->contactQueue[queue_no][w->infectionMod].at(person_no);
+        reseedPerson(w,thread_no,PHASE_CONTACT,infected);
+        w->a_units[infected->personPointer->getHouse()->unit].contact_makers[thread_no]++;
+        int parent=w->a_units[infected->personPointer->getHouse()->unit].parent_id;
+        while (parent!=-1) {
+          w->a_units[parent].contact_makers[thread_no]++;
+          parent=w->a_units[parent].parent_id;
+        }
 
-      w->confirmQueue[thread_no][w->con_toggle].push_back(infected);
-      i_unit = &w->a_units[infected->personPointer->house->unit];
-      double p_contact = (infected->t_inf/24.0)*i_unit->B_spat*i_unit->getSeasonality(w,infected->personPointer->house->lat);
-      if ((infected->personPointer->place_type>=0) && (infected->personPointer->place_type<=w->P->no_place_types)) {
-        if (infected->personPointer->place<w->no_places[infected->personPointer->house->country][infected->personPointer->place_type]) {
-          if (w->places[infected->personPointer->house->country][infected->personPointer->place_type].at(infected->personPointer->place)->closure_start>=0) {
-            if ((w->T>=w->places[infected->personPointer->house->country][infected->personPointer->place_type].at(infected->personPointer->place)->closure_start) &&
-              (w->T<=w->places[infected->personPointer->house->country][infected->personPointer->place_type].at(infected->personPointer->place)->closure_end)) {
-                p_contact*=w->a_units[infected->personPointer->house->unit].c_comm_mul;
+        w->confirmQueue[thread_no][w->con_toggle].push_back(infected);
+        i_unit = &w->unit_hot[infected->personPointer->getHouse()->unit];
+        double p_contact = (infected->t_inf/24.0)*i_unit->B_spat*i_unit->getSeasonality(w,infected->personPointer->getHouse()->lat);
+        if ((infected->personPointer->place_type>=0) && (infected->personPointer->place_type<=w->P->no_place_types)) {
+          if (infected->personPointer->place<w->no_places[infected->personPointer->getHouse()->country][infected->personPointer->place_type]) {
+            if (w->places[infected->personPointer->getHouse()->country][infected->personPointer->place_type].at(infected->personPointer->place)->closure_start>=0) {
+              if ((w->T>=w->places[infected->personPointer->getHouse()->country][infected->personPointer->place_type].at(infected->personPointer->place)->closure_start) &&
+                (w->T<=w->places[infected->personPointer->getHouse()->country][infected->personPointer->place_type].at(infected->personPointer->place)->closure_end)) {
+                  p_contact*=i_unit->c_comm_mul;
+              }
             }
           }
         }
-      }
       
-      // Modify probability if household quarantine is on
+        // Modify probability if household quarantine is on
 
-      if (infected->personPointer->house->q_start>=0) {
-        if ((w->T>=infected->personPointer->house->q_start) && (w->T<=infected->personPointer->house->q_end)) {
-          p_contact*=w->a_units[infected->personPointer->house->unit].q_community;
+        if (infected->personPointer->getHouse()->getQStart()>=0) {
+          if ((w->T>=infected->personPointer->getHouse()->getQStart()) && (w->T<=infected->personPointer->getHouse()->getQEnd())) {
+            p_contact*=i_unit->q_community;
+          }
         }
-      }
 
-      // Modify probability for place absenteeism
+        // Modify probability for place absenteeism
 
-      if ((infected->flags & SEVERE)>0) {
-        if (ranf_mt(thread_no)<i_unit->abs_place_sev[infected->personPointer->place_type]) {
-          p_contact*=i_unit->abs_place_sev_cc_mul[infected->personPointer->place_type];
-        }
-      } else if ((infected->flags & SYMPTOMATIC)>0) {
-        if (ranf_mt(thread_no)<i_unit->abs_place_sympt[infected->personPointer->place_type]) {
-          p_contact*=i_unit->abs_place_sympt_cc_mul[infected->personPointer->place_type];
+        if ((infected->flags & SEVERE)>0) {
+          if (ranf_mt(thread_no)<w->a_units[infected->personPointer->getHouse()->unit].abs_place_sev[infected->personPointer->place_type]) {
+            p_contact*=w->a_units[infected->personPointer->getHouse()->unit].abs_place_sev_cc_mul[infected->personPointer->place_type];
+          }
+        } else if ((infected->flags & SYMPTOMATIC)>0) {
+          if (ranf_mt(thread_no)<w->a_units[infected->personPointer->getHouse()->unit].abs_place_sympt[infected->personPointer->place_type]) {
+            p_contact*=w->a_units[infected->personPointer->getHouse()->unit].abs_place_sympt_cc_mul[infected->personPointer->place_type];
+          }
         }
-      }
       
       
-      n_contacts = (short) ignpoi_mt(p_contact,thread_no);    // Calculate number of community contacts.
-      infected->n_contacts=n_contacts;
-      infected->contacts = new infectedPerson *[n_contacts];
-      for (int i=0; i<n_contacts; i++) {
-        infected->contacts[i]=NULL;
-      }
-      infected->contact_order = new unsigned short[n_contacts];
-      n_local=0;                  // Count local contacts. (Remove unnecessary ones later if remote contacts are found)
-      first_travel=0;             // A flag to indicate the first MPI travel message (for efficiency when receiving)
-      while (n_local<n_contacts) {
-        done_contact=0;
-        new_contact_time = (float) (w->T+w->P->timestep_hours+(ranf_mt(thread_no)*infected->t_inf));                     // Pick random (uniform) time (hours) for a contact to be scheduled
+        n_contacts = (short) ignpoi_mt(p_contact,thread_no);    // Calculate number of community contacts.
+        infected->n_contacts=n_contacts;
+        infected->contacts_alloc=n_contacts;
+        live_memory[thread_no].contacts+=n_contacts*(sizeof(infectedPerson*)+sizeof(unsigned short));
+        infected->contacts = new infectedPerson *[n_contacts];
+        for (int i=0; i<n_contacts; i++) {
+          infected->contacts[i]=NULL;
+        }
+        infected->contact_order = new unsigned short[n_contacts];
+        n_local=0;                  // Count local contacts. (Remove unnecessary ones later if remote contacts are found)
+        first_travel=0;             // A flag to indicate the first MPI travel message (for efficiency when receiving)
+        if ((infected->travel_plan==NULL) && (w->block_contacts)) makeCommunityContactBlock(w,thread_no,infected,n_local,contact_no,n_contacts);
+        else while (n_local<n_contacts) {
+          done_contact=0;
+          new_contact_time = (float) (w->T+w->P->timestep_hours+(ranf_mt(thread_no)*infected->t_inf));                     // Pick random (uniform) time (hours) for a contact to be scheduled
         
-        // Establish Long-Range Contacts
-        if (infected->travel_plan!=NULL) {                                                                                          // Either traveller or visitor  
-          if (infected->travel_plan->traveller==TRAVELLER) {                                                                        // Actually, Traveller
-            if ((new_contact_time>=infected->travel_plan->t_start) && (new_contact_time<=infected->travel_plan->t_start+infected->travel_plan->duration)) { // They are away at this time
-              if (infected->travel_plan->travel_node==w->mpi_rank) {
-                if (infected->travel_plan->x<-500) infectedPerson::locateTravel(w,infected,thread_no);                              // 1st time - get (x,y) for traveller
-                makeCommunityContact(w,thread_no,infected->travel_plan->patch,infected->travel_plan->x,infected->travel_plan->y,infected,n_local,contact_no,n_contacts,new_contact_time);
-                done_contact=1;
-
-              } else {      // The traveller was on another node at that time...
-                if (contact_no<n_contacts*10) {     // At most request 10 times as many remotes as locals. ( Just to reduce MPI burden. ** Check whether this ever causes undersample. Unlikely. )
-                  addTravelRequest(w,thread_no,infected,new_contact_time,contact_no,first_travel,MSG_TRAVELLER);
-                  first_travel=1; // All travel is to same node, on same thread, so one flag is enough.
-                  contact_no++;
+          // Establish Long-Range Contacts
+          if (infected->travel_plan!=NULL) {                                                                                          // Either traveller or visitor  
+            if (infected->travel_plan->traveller==TRAVELLER) {                                                                        // Actually, Traveller
+              if ((new_contact_time>=infected->travel_plan->t_start) && (new_contact_time<=infected->travel_plan->t_start+infected->travel_plan->duration)) { // They are away at this time
+                if (infected->travel_plan->travel_node==w->mpi_rank) {
+                  if (infected->travel_plan->x<-500) infectedPerson::locateTravel(w,infected,thread_no);                              // 1st time - get (x,y) for traveller
+                  makeCommunityContact(w,thread_no,infected->travel_plan->patch,infected->travel_plan->x,infected->travel_plan->y,infected,n_local,contact_no,n_contacts,new_contact_time);
+                  done_contact=1;
+
+                } else {      // The traveller was on another node at that time...
+                  if (contact_no<n_contacts*10) {     // At most request 10 times as many remotes as locals. ( Just to reduce MPI burden. ** Check whether this ever causes undersample. Unlikely. )
+                    addTravelRequest(w,thread_no,infected,new_contact_time,contact_no,first_travel,MSG_TRAVELLER);
+                    first_travel=1; // All travel is to same node, on same thread, so one flag is enough.
+                    contact_no++;
+                  }
                 }
-              }
-            }  // Traveller is at home at this time - don't do anything - continue with usual contact-making algorithm.
+              }  // Traveller is at home at this time - don't do anything - continue with usual contact-making algorithm.
             
-          } else /* if (infected->travel_plan->traveller==VISITOR) */ {
-            if ((new_contact_time>=infected->travel_plan->t_start) && (new_contact_time<=infected->travel_plan->t_start+infected->travel_plan->duration)) { // Is "on holiday here" at this time
-              if (visitor_relocate_lat<-500) {                                        // if a temporary latitude has not yet been set...
-                visitor_relocate_lat = lsIndexToLat(w->localPatchList[infected->personPointer->house->patch]->x+(ranf_mt(thread_no)*w->localPatchList[infected->personPointer->house->patch]->size));
-                visitor_relocate_lon = lsIndexToLon(w->localPatchList[infected->personPointer->house->patch]->y+(ranf_mt(thread_no)*w->localPatchList[infected->personPointer->house->patch]->size));
-              }
-              makeCommunityContact(w,thread_no,w->localPatchList[infected->personPointer->house->patch],visitor_relocate_lon,visitor_relocate_lat,infected,n_local,contact_no,n_contacts,new_contact_time);
-              done_contact=1;
-            } else {    // Not in the visitor window - so they're at "home" wherever that is.
-              if (infected->travel_plan->travel_node==w->mpi_rank) { // Country is on this node
-                if (infected->travel_plan->x<-500) infectedPerson::locateTravel(w,infected,thread_no);
+            } else /* if (infected->travel_plan->traveller==VISITOR) */ {
+              if ((new_contact_time>=infected->travel_plan->t_start) && (new_contact_time<=infected->travel_plan->t_start+infected->travel_plan->duration)) { // Is "on holiday here" at this time
+                if (visitor_relocate_lat<-500) {                                        // if a temporary latitude has not yet been set...
+                  visitor_relocate_lat = lsIndexToLat(w->localPatchList[infected->personPointer->getHouse()->patch]->x+(ranf_mt(thread_no)*w->localPatchList[infected->personPointer->getHouse()->patch]->size));
+                  visitor_relocate_lon = lsIndexToLon(w->localPatchList[infected->personPointer->getHouse()->patch]->y+(ranf_mt(thread_no)*w->localPatchList[infected->personPointer->getHouse()->patch]->size));
+                }
+                makeCommunityContact(w,thread_no,w->localPatchList[infected->personPointer->getHouse()->patch],visitor_relocate_lon,visitor_relocate_lat,infected,n_local,contact_no,n_contacts,new_contact_time);
+                done_contact=1;
+              } else {    // Not in the visitor window - so they're at "home" wherever that is.
+                if (infected->travel_plan->travel_node==w->mpi_rank) { // Country is on this node
+                  if (infected->travel_plan->x<-500) infectedPerson::locateTravel(w,infected,thread_no);
  
-              // Find local patch where the visitor comes from.
-                int tries=0;
-                while ((visitor_unset==1) && (tries<100)) {   // The tries<100 is for the rare case where no susceptibles are left in the country, which case we bite the bullet.
-                  tries++;
-                  visitor_patch = infectedPerson::getPatchForPerson(w,(int) (ranf_mt(thread_no)*w->people_per_country_per_node[infected->travel_plan->country][w->mpi_rank]),infected->travel_plan->country,thread_no);
-                  
-                  visitor_person = &visitor_patch->people[(int) (ranf_mt(thread_no)*visitor_patch->no_people)];
-                  if ((visitor_person->status & STATUS_SUSCEPTIBLE)>0) {
-                    visitor_person->status-=STATUS_SUSCEPTIBLE;
-                    visitor_person->status+=STATUS_CONTACTED;
-                    infectedPerson* ip = new infectedPerson(w,thread_no,visitor_person);
-                    ip->travel_plan=NULL;
-                    ip->updateStats(w,thread_no,1,0);
-                    unsigned int timeStepsAway = 8; // Number of timesteps between now, and contact time
-                    timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow; // Modulo maths to choose the right list
-                    w->recoveryQueue[thread_no][timeStepsAway].push_back(ip);             // And schedule recovery
+                // Find local patch where the visitor comes from - a random susceptible in their country (see susceptibles.cpp)
+                  if (visitor_unset==1) {
+                    person* source = pickSusceptible(w,infected->travel_plan->country,thread_no,&visitor_patch);
+                    if (source!=NULL) {
+                      visitor_person = source;
+                      visitor_person->status-=STATUS_SUSCEPTIBLE;
+                      queueSusceptibleRemoval(w,thread_no,visitor_person);
+                      logInfection(w,thread_no,infected->personPointer,w->mpi_rank,visitor_person,(float) w->T,EVENT_TRAVEL,0);
+                      visitor_person->status+=STATUS_CONTACTED;
+                      infectedPerson* ip = new infectedPerson(w,thread_no,visitor_person);
+                      ip->travel_plan=NULL;
+                      ip->updateStats(w,thread_no,1,0);
+                      unsigned int timeStepsAway = 8; // Number of timesteps between now, and contact time
+                      timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow; // Modulo maths to choose the right list
+                      scheduleEvent(w,w->recoveryQueue,thread_no,timeStepsAway,ip);             // And schedule recovery
                     
-                    visitor_unset=0;
+                      visitor_unset=0;
+                    } else {      // The rare case where no susceptibles are left in the country, in which case we bite the bullet - anyone will do for the location.
+                      visitor_patch = infectedPerson::getPatchForPerson(w,(int) (ranf_mt(thread_no)*w->people_per_country_per_node[infected->travel_plan->country][w->mpi_rank]),infected->travel_plan->country,thread_no);
+                      visitor_person = &visitor_patch->people[(int) (ranf_mt(thread_no)*visitor_patch->no_people)];
+                    }
                   }
-                }
             
 
-                  // Now establish a contact.
-                if (visitor_person!=NULL) { 
-                  makeCommunityContact(w,thread_no,visitor_patch,visitor_person->house->lon,visitor_person->house->lat,infected,n_local,contact_no,n_contacts,new_contact_time);
-                }
-                done_contact=1;
+                    // Now establish a contact.
+                  if (visitor_person!=NULL) { 
+                    makeCommunityContact(w,thread_no,visitor_patch,visitor_person->getHouse()->lon,visitor_person->getHouse()->lat,infected,n_local,contact_no,n_contacts,new_contact_time);
+                  }
+                  done_contact=1;
 
-              } else {              // Country is on other node
-                if (contact_no<n_contacts*10) {
-                  addTravelRequest(w, thread_no,infected,new_contact_time,contact_no,first_travel,MSG_VISITOR);   // Send special visitor message.
-                  first_travel=1;
+                } else {              // Country is on other node
+                  if (contact_no<n_contacts*10) {
+                    addTravelRequest(w, thread_no,infected,new_contact_time,contact_no,first_travel,MSG_VISITOR);   // Send special visitor message.
+                    first_travel=1;
+                  }
+                  visitor_unset=0;
+                  contact_no++;
+                  done_contact=1;
                 }
-                visitor_unset=0;
-                contact_no++;
-                done_contact=1;
               }
             }
-          }
-        } // Actually, no travel plan.
-        if ((done_contact==0) && ((infected->travel_plan==NULL) || (infected->travel_plan->traveller==TRAVELLER))) {    // If we haven't found a contact through other means, and we live here, then basic community contact.
-          makeCommunityContact(w,thread_no,w->localPatchList[infected->personPointer->house->patch],infected->personPointer->house->lon,infected->personPointer->house->lat,infected,n_local,contact_no,n_contacts,new_contact_time);
-        } 
+          } // Actually, no travel plan.
+          if ((done_contact==0) && ((infected->travel_plan==NULL) || (infected->travel_plan->traveller==TRAVELLER))) {    // If we haven't found a contact through other means, and we live here, then basic community contact.
+            makeCommunityContact(w,thread_no,w->localPatchList[infected->personPointer->getHouse()->patch],infected->personPointer->getHouse()->lon,infected->personPointer->getHouse()->lat,infected,n_local,contact_no,n_contacts,new_contact_time);
+          } 
         
-        if (contact_no>n_contacts*10) {    // If for the visitor case especially, it seems like we're not going to get any local contacts...
-          for (unsigned int j=n_local; j<(unsigned int) n_contacts; j++) infected->contact_order[j]=(unsigned short) (contact_no+j);
-          n_local=n_contacts;
-        }
-      } // End of find contacts loop
-      // If the person was a visitor, check that the "source" is now immune.
-      if (infected->travel_plan!=NULL) {
-        if (infected->travel_plan->traveller==VISITOR) {
-
-          if (visitor_unset==1) {
-            if (infected->travel_plan->travel_node==w->mpi_rank) {  // Home node
-              int tries=0;
-              while ((visitor_unset==1) && (tries<100)) {   // The tries<100 is for the rare case where no susceptibles are left in the country, which case we bite the bullet.
-                tries++;
-                visitor_patch = infectedPerson::getPatchForPerson(w,(int) (ranf_mt(thread_no)*w->people_per_country_per_node[infected->travel_plan->country][w->mpi_rank]),infected->travel_plan->country,thread_no);
-                  
-                visitor_person = &visitor_patch->people[(int) (ranf_mt(thread_no)*visitor_patch->no_people)];
-                if ((visitor_person->status & STATUS_SUSCEPTIBLE)>0) {
+          if (contact_no>n_contacts*10) {    // If for the visitor case especially, it seems like we're not going to get any local contacts...
+            for (unsigned int j=n_local; j<(unsigned int) n_contacts; j++) infected->contact_order[j]=(unsigned short) (contact_no+j);
+            n_local=n_contacts;
+          }
+        } // End of find contacts loop
+        // If the person was a visitor, check that the "source" is now immune.
+        if (infected->travel_plan!=NULL) {
+          if (infected->travel_plan->traveller==VISITOR) {
+
+            if (visitor_unset==1) {
+              if (infected->travel_plan->travel_node==w->mpi_rank) {  // Home node
+                person* source = pickSusceptible(w,infected->travel_plan->country,thread_no,&visitor_patch);   // NULL in the rare case where no susceptibles are left
+                if (source!=NULL) {
+                  visitor_person = source;
                   visitor_person->status-=STATUS_SUSCEPTIBLE;
+                  queueSusceptibleRemoval(w,thread_no,visitor_person);
+                  logInfection(w,thread_no,infected->personPointer,w->mpi_rank,visitor_person,(float) w->T,EVENT_TRAVEL,0);
                   visitor_person->status+=STATUS_CONTACTED;
                   infectedPerson* ip = new infectedPerson(w,thread_no,visitor_person);
                   ip->updateStats(w,thread_no,1,0);
                   ip->t_inf=24; // Dummy to make sure recovery happens reasonably.
                   unsigned int timeStepsAway = (unsigned int) ((ip->t_inf+w->P->timestep_hours)/w->P->timestep_hours);       // Number of timesteps between now, and contact time
                   timeStepsAway = (w->infectionMod+timeStepsAway) % w->P->infectionWindow;             // Modulo maths to choose the right list
-                  w->recoveryQueue[thread_no][timeStepsAway].push_back(ip);             // And schedule recovery
+                  scheduleEvent(w,w->recoveryQueue,thread_no,timeStepsAway,ip);             // And schedule recovery
                   visitor_unset=0; 
                 }
-              }
-              // Send the message
-            } else { // Visitor on remote node
+                // Send the message
+              } else { // Visitor on remote node
                   
-              addTravelRequest(w, thread_no,infected,0,0,first_travel,MSG_NULL_VISITOR);
-              contact_no=n_local+1;                         // Ensure that finaliseRemoteRequest is called.
+                addTravelRequest(w, thread_no,infected,0,0,first_travel,MSG_NULL_VISITOR);
+                contact_no=n_local+1;                         // Ensure that finaliseRemoteRequest is called.
 
+              }
             }
-          }
 
+          }
         }
-      }
-      if (contact_no>n_local) {
+        if (contact_no>n_local) {
          
-        finaliseRemoteRequest(w,thread_no,infected);
-      }
-      // Next individual
-      person_no+=w->thread_count;
-      while ((queue_no<w->thread_count) && (person_no>=w->contactQueue[queue_no][w->infectionMod].size())) { // Dealt with all individuals in this thread queue.
-        person_no-=(int) w->contactQueue[queue_no][w->infectionMod].size();
-        queue_no++;
+          finaliseRemoteRequest(w,thread_no,infected);
+        }
       }
     } // end of while loop - continue through lists of individuals until there are no more thread-queues left.
+    w->busy_time[thread_no]+=omp_get_wtime()-t_busy;
   } // next thread number (just for OpenMP)
   
+  #pragma omp for schedule(static,1)
   for (thread_no=0; thread_no<w->thread_count; thread_no++)
-    w->contactQueue[thread_no][w->infectionMod].clear();
+    clearSlot(w,w->contactQueue,thread_no,w->infectionMod);
   errline=101357;
 }
 
 
+void endTimestep(world* w, double* t_phase) {                      // t_phase - if not NULL, charge each part to its phase timer
+  // Called by the whole team inside runSim's parallel region. Each part ends in a barrier.
+  statsTimestep(w);                                               // Perform statistical aggregation for this timestep 
+  #pragma omp master
+  {
+  if (t_phase!=NULL) markPhase(w,PHASE_STATS,t_phase);
+  applySusceptibleRemovals(w);                                    // Bring the susceptible lists up to date for the next timestep
+  if ((w->log_flat) && (w->mpi_rank==0)) logFlatfile(w);          // Write flat file output if requested. (Just rank 0)
+  if ((w->log_db) && (w->mpi_rank==w->mpi_size-1)) logDB(w);      // Write to database if requested (Just the last node - hence, FF and DB will be simultaneous)
+  if (w->shard!=NULL) w->shard->write(w);                         // Sharded flat file - every node writes its share of the units
+  if (w->events!=NULL) w->events->collect(w,false);               // Gather the threads' transmission events
+  if (t_phase!=NULL) markPhase(w,PHASE_OUTPUT,t_phase);
+  errline=101398;
+  }
+  #pragma omp barrier
+  #pragma omp for schedule(static)
+  for (int i=0; i<w->no_units; i++) {                          // Interventions only switch their own unit's settings, so
+    for (int j=0; j<w->a_units[i].no_interventions; j++) {   // units can be checked in parallel. Check whether any have been
+      w->a_units[i].interventions[j].checkStatus(w);         // triggered on or off.
+    }
+    unit* u = &w->a_units[i];                                // Refresh the multiplier cache for the next timestep if needed
+    double t_next = w->T+(int)w->P->timestep_hours;
+    if ((u->mul_stale) || ((u->mul_refresh_at>=0) && (t_next>=u->mul_refresh_at))) u->updateMultipliers(t_next);
+  }
+  resetUnitStats(w);                                              // Reset counters for next timestep
+  #pragma omp master
+  if (t_phase!=NULL) markPhase(w,PHASE_INTERV,t_phase);
+}
+
+void fastForward(world* w, int steps) {
+  // Every node agreed that the next 'steps' timesteps have no events. Do only what those steps would have done with
+  // no events: rotate the windows, and carry stats, interventions and output forward. No messages.
+  // Called by the whole team inside runSim's parallel region.
+
+  #pragma omp master
+  if (w->log_movie) w->grid->gather(w);       // Rank 0 needs the combined image for the frames it would have saved.
+  #pragma omp barrier
+  for (int s=0; s<steps; s++) {
+    #pragma omp single
+    {
+    w->T_day=(float) (1.0*w->T/24.0);
+    if ((w->log_movie) && (w->mpi_rank==0)) saveImage(w);
+    w->con_toggle=1-w->con_toggle;
+    w->infectionMod=(w->infectionMod + 1) % w->P->infectionWindow;
+    }
+    endTimestep(w,NULL);
+    #pragma omp single
+    {
+    w->T+=(int)w->P->timestep_hours;
+    w->steps_done++;
+    w->steps_skipped++;
+    }
+  }
+}
+
 void runSim(world *w) {
   w->T=0;                                  // w->T is time in hours. 
   w->continue_status=1;                    // continue_status>=1 means there is work to do (on any node).
-  while (w->continue_status>=1) {          // See messages.cpp for synchronisation of continue_status.
+  double t_loop=phaseClock();
+  double t_phase=t_loop;                   // Start of the current phase - see timing.cpp
+  int running=1;                           // Loop control for the team - only written by the master, between barriers.
+  int skip=0;                              // Timesteps every node agreed to fast-forward.
+  if (w->event_file!=NULL) w->events = new eventLog(w,w->event_file);
+  if (((w->mpi_rank==0) && ((w->log_flat) || (w->log_movie))) || ((w->log_db) && (w->mpi_rank==w->mpi_size-1)) || (w->events!=NULL))
+    w->writer = new outputWriter(w,w->async_output);
+  if (w->shard_file!=NULL) w->shard = new shardOutput(w,w->shard_file);
+  if ((w->metrics_spec!=NULL) && (w->mpi_rank==0)) w->metrics = new metricsServer(w,w->metrics_spec);
+
+  // One parallel region for the whole run, rather than a fork/join per phase. Each process function shares its
+  // work out with an orphaned "omp for" (so ends in a barrier); serial and MPI parts run on the master thread
+  // (MPI_THREAD_FUNNELED - see world.cpp), followed by an explicit barrier.
+
+  #pragma omp parallel num_threads(w->thread_count) default(shared)
+  {
+  while (running) {                        // See messages.cpp for synchronisation of continue_status.
+    #pragma omp master
+    {
+    if ((w->mem_every>0) && (w->steps_done>=w->mem_next)) {   // steps_done is the same on every node - see reportMemory
+      reportMemory(w,"step");
+      w->mem_next=w->steps_done+w->mem_every;
+    }
     w->continue_status=0;                  // Suppose that there's nothing left to do... then set to 1 if we find there is still work.
     if (w->P->next_seed<w->P->no_seeds) w->continue_status=1;  // If we haven't performed all seed events yet, definitely continue
     else {                                                     // Otherwise...
       for (int i=0; i<w->thread_count; i++) {
-        if ((w->confirmQueue[i][0].size()>0) || (w->confirmQueue[i][1].size()>0)) {   // If there's a contact waiting to be confirmed, 
+        if ((w->confirmQueue[i][0].size()>0) || (w->confirmQueue[i][1].size()>0) ||  // If there's a contact waiting to be confirmed, 
+            (w->queued_total[i]>0)) {                                                 // or anything anywhere in the queues...
           w->continue_status=1;                                                       // then continue
           i=w->thread_count;                                                          // And abort this loop
-        } else {
-          for (int j=0; j<w->P->infectionWindow; j++) {                               // Otherwise, if there's anything anywhere in the queues...
-            if ((w->contactQueue[i][j].size()>0) || (w->symptomQueue[i][j].size()>0) || (w->recoveryQueue[i][j].size()>0)) {
-              w->continue_status=1;                                                   // Continue
-              j=w->P->infectionWindow;                                                // And abort the loops.
-              i=w->thread_count;
-            }
-          } 
         }
       }
     }
+    skip=0;
+    if (w->fast_forward) {                                     // Jump over timesteps that are empty on every node. Agreed in
+      skip = w->skip_next;                                     // the last step's starter message - see addSkipInfo
+      w->skip_next=0;                                          // (Used up: after a jump, the next step has work somewhere.)
+      if (skip==NO_EVENTS) skip=0;                             // (NO_EVENTS everywhere - run the step as normal, and stop.)
+      if ((w->max_steps>0) && (skip>(int)(w->max_steps-w->steps_done))) skip=w->max_steps-w->steps_done;
+    }
+    }
+    #pragma omp barrier
+    if (skip>0) {
+      fastForward(w,skip);
+      #pragma omp master
+      {
+      if ((w->max_steps>0) && (w->steps_done>=w->max_steps)) running=0;
+      w->continue_status=1;                                    // Some node has work to come
+      }
+      #pragma omp barrier
+      continue;
+    }
+
+    #pragma omp master
+    {
     w->T_day=(float) (1.0*w->T/24.0);        // Calculate day number for convenience
-    
+    unitHot::updateSeasonality(w);
+    markPhase(w,PHASE_CHECK,&t_phase);
     seedScheduledInfections(w);              // Check for any seed events
+    markPhase(w,PHASE_SEED,&t_phase);
+    }
+    #pragma omp barrier
     processContactQueue(w);                  // Deal with people who become infected and schedule their contacts this timestep 
+    #pragma omp master
+    {
+    markPhase(w,PHASE_CONTACT,&t_phase);
     doMessage(w);                            // Send MPI messages for next timestep, and receive replies from last timestep
+    markPhase(w,PHASE_MESSAGE,&t_phase);
+    }
+    #pragma omp barrier
     handleIncomingMessage(w);                // Process the incoming MPI message
+    #pragma omp master
+    markPhase(w,PHASE_HANDLE,&t_phase);
     processConfirmationQueue(w);             // Process list of "confirmed" contact attempts. (IE, unnecessary remote contacts are now gone)
+    #pragma omp master
+    markPhase(w,PHASE_CONFIRM,&t_phase);
     processSymptomaticQueue(w);              // Process queue of people who become symptomatic this timestep
+    #pragma omp master
+    markPhase(w,PHASE_SYMPTOM,&t_phase);
     processRecoveryQueue(w);                 // Process queue of people who recover in this timestep
-
+    #pragma omp master
+    {
+    markPhase(w,PHASE_RECOVERY,&t_phase);
     w->infectionMod=(w->infectionMod + 1) % w->P->infectionWindow;  // Rotate timing windows.
     errline=101394;
-    statsTimestep(w);                                               // Perform statistical aggregation for this timestep 
-    if ((w->log_flat) && (w->mpi_rank==0)) logFlatfile(w);          // Write flat file output if requested. (Just rank 0)
-    if ((w->log_db) && (w->mpi_rank==w->mpi_size-1)) logDB(w);      // Write to database if requested (Just the last node - hence, FF and DB will be simultaneous)
-    errline=101398;
-    for (int i=0; i<w->no_units; i++) {
-      for (int j=0; j<w->a_units[i].no_interventions; j++) {   // For each unit, check whether any interventions have been 
-        w->a_units[i].interventions[j].checkStatus(w);         // triggered on or off.
-      }
     }
-      
-    resetUnitStats(w);                       // Reset counters for next timestep
+    #pragma omp barrier
+    endTimestep(w,&t_phase);                                        // Stats, output and intervention triggers
     errline=101406;
     if (w->log_movie) updateImage(w);        // Update the image if requested.
+    #pragma omp master
+    {
+    markPhase(w,PHASE_MOVIE,&t_phase);
     w->T+=(int)w->P->timestep_hours;         // Update timestep
+    w->steps_done++;
+    if (w->continue_status<1) running=0;
+    if ((w->max_steps>0) && (w->steps_done>=w->max_steps)) running=0;   // Fixed-length run requested. Every node stops at the same step.
     errline=101409;
+    }
+    #pragma omp barrier
   }
-  if ((w->log_flat) && (w->mpi_rank==0)) fclose(w->ff); // Remember to flush/close flatfile output if it was opened.
+  } // End of parallel region
+  w->loop_time=phaseClock()-t_loop;
+  if ((w->fast_forward) && (w->mpi_rank==0)) {
+    printf("%d: Fast-forwarded %d of %d timesteps\n",w->mpi_rank,w->steps_skipped,w->steps_done);
+    fflush(stdout);
+  }
+  if (w->events!=NULL) w->events->collect(w,true);
+  if (w->writer!=NULL) {
+    w->writer->finish();                   // Let the writer thread catch up
+    w->writer->report(w);
+  }
+  if (w->grid!=NULL) w->grid->report(w);
+  if (w->ff!=NULL) fclose(w->ff);          // Remember to flush/close flatfile output if it was opened.
+  if (w->fb!=NULL) fclose(w->fb);
+  if (w->shard!=NULL) w->shard->close(w);
+  delete w->metrics;                       // Stop serving - the run is over
+  w->metrics=NULL;
 }
 
 void infectPerson(world* w, person* p) {
   if ((p->status & STATUS_SUSCEPTIBLE)>0) {
     p->status-=STATUS_SUSCEPTIBLE;
+    queueSusceptibleRemoval(w,0,p);
+    logInfection(w,0,NULL,w->mpi_rank,p,(float) w->T,EVENT_SEED,0);
     p->status+=STATUS_CONTACTED;
     infectedPerson* ip = new infectedPerson(w,0,p);
     ip->t_contact=(float) w->T;      
     ip->t_inf = (float) (w->P->getInfectiousPeriodLength(0));
-    w->contactQueue[0][0].push_back(ip);  // Add to the queue zero for first timestep.
+    scheduleEvent(w,w->contactQueue,0,0,ip);  // Add to the queue zero for first timestep.
   } 
 }
 
@@ -1458,6 +1752,7 @@ void seedInfection(unsigned int count, world *w, int ls_x, int ls_y) {
 
 void seedScheduledInfections(world* w) {
   if (w->P->next_seed<w->P->no_seeds) {
+    reseedTask(w,0,PHASE_SEED,0);
     while (w->P->seed_ts[w->P->next_seed]==(int)w->T) {
       seedInfection(w->P->seed_no[w->P->next_seed],w,lonToLsIndex(w->P->seed_long[w->P->next_seed]),latToLsIndex(w->P->seed_lat[w->P->next_seed]));
       w->P->next_seed++;
@@ -1495,6 +1790,12 @@ int main(int argc, char* argv[])  {
   printf("Starting GSIM 1.0\n"); fflush(stdout);
   signal(SIGABRT, &handle_aborts);
   world *w = new world(argc,argv);
+  if (w->dry_run>=0) {
+    #ifdef _USEMPI
+      MPI_Finalize();
+    #endif
+    return 0;
+  }
   initialiseMessages(w);
 
   #ifdef _USEMPI
@@ -1503,10 +1804,18 @@ int main(int argc, char* argv[])  {
   #endif
   
   resetAllUnitStats(w);
+  if (w->mem_every>0) {
+    reportMemory(w,"startup");
+    w->mem_next=w->mem_every;
+  }
 
   printf("Running at time %f\n",MPI_Wtime()); fflush(stdout);
   runSim(w);              // Go
   printf("Done at time %f\n",MPI_Wtime()); fflush(stdout);
+  if (w->log_timing) reportTiming(w);
+  if (w->mem_every>0) reportMemory(w,"end");
+  reportPopulationMemory(w,"end of run");
+  finaliseMessages(w);
   #ifdef MEMORY_CHECK
     PrintMemoryInfo( w, GetCurrentProcessId() );
   #endif
@@ -21,6 +21,7 @@
 #define _USEMPI
 #define MOVIE
 #define ENABLE_LD_TRAVEL
+#define COMPACT_PEOPLE      // 12-byte people and 28-byte households - see person.h. Comment out for the original layout.
 #define CTRL_UNSET 0
 #define CTRL_SINGLE_ADDR 1
 #define CTRL_FIRST_LINK 2
@@ -31,10 +32,32 @@
 #define MSG_VISITOR 65534
 #define MSG_NULL_VISITOR 65533
 
+#define NO_EVENTS 2147483647   // addSkipInfo() - nothing queued and no seeds left
+
 #define TRAVELLER 1
 #define VISITOR 0
   
 #define _USE_OPENMP
+
+#define CONTACT_BLOCK 16       // Most community contact candidates drawn at once for one infector - see makeCommunityContactBlock
+#define CAND_REJECTED 0
+#define CAND_REMOTE 1
+#define CAND_LOCAL 2
+
+// Loops that should vectorise. With GCC on x86-64 Linux, SIMD_CLONES also builds AVX-512 and AVX2 versions of the
+// function alongside the baseline one, and the loader picks the best the CPU supports. Elsewhere both are no-ops.
+
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__) && defined(_OPENMP)
+  #define SIMD_ENABLED
+  #define SIMD_CLONES __attribute__((target_clones("avx512f","avx2","default")))
+#else
+  #define SIMD_CLONES
+#endif
+#if defined(__GNUC__) && defined(_OPENMP)
+  #define SIMD_LOOP _Pragma("omp simd")
+#else
+  #define SIMD_LOOP
+#endif
   
   #include "simINT64.h"
   #include "params.h"
@@ -58,11 +81,26 @@
 
   class world;
   extern int errline;
+
+  // glibc's vector maths library (libmvec, linked through libm) has SIMD versions of these, but math.h only says so
+  // under -ffast-math. Declaring them here lets SIMD_LOOP loops call them (sqrt also needs -fno-math-errno).
+  // atan2 arrived in glibc 2.35; before that, contactBlockAccept stays scalar.
+
+#if defined(SIMD_ENABLED) && defined(__GLIBC__) && (__GLIBC__*100+__GLIBC_MINOR__>=235)
+  #pragma omp declare simd notinbranch
+  extern "C" double sin(double) __THROW;
+  #pragma omp declare simd notinbranch
+  extern "C" double cos(double) __THROW;
+  #pragma omp declare simd notinbranch
+  extern "C" double pow(double,double) __THROW;
+  #pragma omp declare simd notinbranch
+  extern "C" double atan2(double,double) __THROW;
+#endif
   
   void seedInfection(unsigned int count, world *w, int ls_x, int ls_y);
   void seedScheduledInfections(world* w);
   void makePlaceContactRemote(world* w, int thread_no, unsigned char country, unsigned char place_type, unsigned int place_no,
-      unsigned int host_no, double t_inf, double infectiousness, double contact_time);
+      unsigned int host_no, double t_inf, double infectiousness, double contact_time, int src_node);
 #ifdef MEMORY_CHECK
   void PrintMemoryInfo( world* w, DWORD processID );
 #endif
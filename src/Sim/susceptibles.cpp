@@ -0,0 +1,186 @@
+/* susceptibles.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Per-patch lists of susceptibles, and weighted choice of a susceptible in a country
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+#include "susceptibles.h"
+#include "world.h"
+
+// Each local patch keeps no_susceptible, a count of its people who are still susceptible. It is only read during the
+// timestep. Anyone who stops being susceptible is queued on their thread's susc_removed list, and the master applies
+// the queues in endTimestep. Until then the counts may include a few people infected earlier in the same timestep,
+// so whoever draws a person still checks the status.
+//
+// For each country, visitor_weight holds a weight for each patch in patches_in_country: the country's population in
+// that patch times the patch's susceptible fraction. That is the chance the old approach - choose a person in the
+// country, retry until susceptible - succeeds in each patch. So choosing a patch by weight, in O(log P), and then
+// drawing people in it as before until one is susceptible gives the same distribution, with the patch walk gone and
+// no draws wasted on patches with no susceptibles left.
+
+fenwickTree::fenwickTree() {
+  n=0;
+  top=0;
+  tree=NULL;
+  leaf=NULL;
+}
+
+fenwickTree::~fenwickTree() {
+  delete[] tree;
+  delete[] leaf;
+}
+
+void fenwickTree::allocate(int _n) {
+  n=_n;
+  top=1;
+  while (top*2<=n) top*=2;
+  tree = new double[n+1];
+  leaf = new double[n];
+  for (int i=0; i<=n; i++) tree[i]=0;
+  for (int i=0; i<n; i++) leaf[i]=0;
+}
+
+void fenwickTree::set(int i, double value) {
+  double delta = value-leaf[i];
+  leaf[i]=value;
+  for (int k=i+1; k<=n; k+=(k & -k)) tree[k]+=delta;
+}
+
+double fenwickTree::total() {
+  double sum=0;
+  for (int k=n; k>0; k-=(k & -k)) sum+=tree[k];
+  return sum;
+}
+
+int fenwickTree::find(double x) {
+  int pos=0;
+  for (int step=top; step>0; step/=2) {
+    if ((pos+step<=n) && (tree[pos+step]<=x)) {
+      pos+=step;
+      x-=tree[pos];
+    }
+  }
+  if (pos>=n) pos=n-1;                     // Rounding in the sums can carry x past the end
+  return pos;
+}
+
+void setPatchWeights(world* w, int patch_no) {
+  localPatch* lp = w->localPatchList[patch_no];
+  double fraction = (lp->no_people>0)?(double) lp->no_susceptible/(double) lp->no_people:0;
+  for (int k=w->patch_country_start[patch_no]; k<w->patch_country_start[patch_no+1]; k++) {
+    int country = w->patch_country[k];
+    int slot = w->patch_country_slot[k];
+    w->visitor_weight[country].set(slot,w->country_patch_pop[country].at(slot)*fraction);
+  }
+}
+
+void buildSusceptibleIndex(world* w) {
+  // Called once the population is loaded (and reordered). Also builds country_patch_cum, the running totals of
+  // country_patch_pop, so that getPatchForPerson can binary-search.
+
+  for (int i=0; i<(int) w->noLocalPatches; i++) {
+    localPatch* lp = w->localPatchList[i];
+    lp->no_susceptible=0;
+    for (int j=0; j<lp->no_people; j++)
+      if ((lp->people[j].status & STATUS_SUSCEPTIBLE)>0) lp->no_susceptible++;
+  }
+
+  w->patch_country_start = new int[(int) w->noLocalPatches+1];
+  for (int i=0; i<=(int) w->noLocalPatches; i++) w->patch_country_start[i]=0;
+  int pairs=0;
+  for (int c=0; c<w->no_countries; c++) {
+    for (int j=0; j<(int) w->patches_in_country[c].size(); j++) w->patch_country_start[w->patches_in_country[c].at(j)+1]++;
+    pairs+=(int) w->patches_in_country[c].size();
+  }
+  for (int i=0; i<(int) w->noLocalPatches; i++) w->patch_country_start[i+1]+=w->patch_country_start[i];
+  w->patch_country = new unsigned char[pairs];
+  w->patch_country_slot = new int[pairs];
+  int* fill = new int[(int) w->noLocalPatches];
+  for (int i=0; i<(int) w->noLocalPatches; i++) fill[i]=w->patch_country_start[i];
+
+  w->visitor_weight = new fenwickTree[w->no_countries];
+  w->country_patch_cum = new int*[w->no_countries];
+  for (int c=0; c<w->no_countries; c++) {
+    int n = (int) w->patches_in_country[c].size();
+    w->visitor_weight[c].allocate(n);
+    w->country_patch_cum[c] = new int[n];
+    int sum=0;
+    for (int j=0; j<n; j++) {
+      int p = w->patches_in_country[c].at(j);
+      w->patch_country[fill[p]]=(unsigned char) c;
+      w->patch_country_slot[fill[p]]=j;
+      fill[p]++;
+      sum+=w->country_patch_pop[c].at(j);
+      w->country_patch_cum[c][j]=sum;
+    }
+  }
+  delete[] fill;
+  for (int i=0; i<(int) w->noLocalPatches; i++) setPatchWeights(w,i);
+  printf("%d:  Susceptible index: %d patch/country pairs, %.1f MB\n",w->mpi_rank,pairs,
+    (pairs*(SIM_I64)(sizeof(unsigned char)+sizeof(int)+(2*sizeof(double))))/1048576.0);
+  fflush(stdout);
+}
+
+void queueSusceptibleRemoval(world* w, int thread_no, person* p) {
+  w->susc_removed[thread_no].push_back(p);
+}
+
+void applySusceptibleRemovals(world* w) {
+  // Master only, while the rest of the team waits. Someone could be queued twice if two threads raced to infect them,
+  // so the lists are gathered into the first and sorted, and each person is counted once.
+  lwv::vector<person*>* all = &w->susc_removed[0];
+  for (int t=1; t<w->thread_count; t++) {
+    for (int i=0; i<(int) w->susc_removed[t].size(); i++) all->push_back(w->susc_removed[t].at(i));
+    w->susc_removed[t].clear();
+  }
+  if (all->size()==0) return;
+  std::sort(all->begin(),all->end());
+  for (int i=0; i<(int) all->size(); i++) {
+    if ((i>0) && (all->at(i)==all->at(i-1))) continue;
+    int patch_no = all->at(i)->getHouse()->patch;
+    localPatch* lp = w->localPatchList[patch_no];
+    if (lp->no_susceptible>0) lp->no_susceptible--;
+    setPatchWeights(w,patch_no);
+  }
+  all->clear();
+}
+
+person* pickSusceptible(world* w, unsigned char country, int thread_no, localPatch** patch) {
+  // A random susceptible from 'country' on this node, or NULL if there are none. The patch is chosen by weight, then
+  // people in it are drawn as before - at most 100 times - until one is susceptible.
+  fenwickTree* weights = &w->visitor_weight[country];
+  double total = weights->total();
+  if (total<=0) return NULL;
+  localPatch* lp = w->localPatchList[w->patches_in_country[country].at(weights->find(ranf_mt(thread_no)*total))];
+  if (lp->no_people==0) return NULL;                        // (Only if rounding left a little weight on an empty patch)
+  for (int tries=0; tries<100; tries++) {
+    person* p = &lp->people[(int) (ranf_mt(thread_no)*lp->no_people)];
+    if ((p->status & STATUS_SUSCEPTIBLE)>0) {
+      *patch=lp;
+      return p;
+    }
+  }
+  // All 100 missed - the patch has very few susceptibles left, or none if they were all infected earlier this
+  // timestep. Rather than giving up on a patch that still had weight, walk it from a random start for the next one.
+  int start = (int) (ranf_mt(thread_no)*lp->no_people);
+  for (int j=0; j<lp->no_people; j++) {
+    person* p = &lp->people[(start+j)%lp->no_people];
+    if ((p->status & STATUS_SUSCEPTIBLE)>0) {
+      *patch=lp;
+      return p;
+    }
+  }
+  return NULL;                                              // The weights are a timestep behind - the caller falls back
+}
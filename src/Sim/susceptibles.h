@@ -0,0 +1,51 @@
+/* susceptibles.h, part of the Global Epidemic Simulation v1.0 BETA
+/* Per-patch lists of susceptibles, and weighted choice of a susceptible in a country
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#ifndef SUSCEPTIBLES_H
+#define SUSCEPTIBLES_H
+
+class world;
+class person;
+class localPatch;
+
+// Fenwick (binary indexed) tree over non-negative weights: O(log n) to change a weight, or to find which entry a
+// point in [0,total) falls in.
+
+class fenwickTree {
+  public:
+    fenwickTree();
+    ~fenwickTree();
+    void allocate(int _n);
+    void set(int i, double value);
+    double total();
+    int find(double x);           // Entry i such that (sum of entries before i) <= x < (sum up to and including i)
+
+  private:
+    int n;
+    int top;                      // Highest power of 2 <= n
+    double* tree;
+    double* leaf;                 // Current weight of each entry
+};
+
+void buildSusceptibleIndex(world* w);
+void queueSusceptibleRemoval(world* w, int thread_no, person* p);
+void applySusceptibleRemovals(world* w);
+person* pickSusceptible(world* w, unsigned char country, int thread_no, localPatch** patch);
+
+#endif
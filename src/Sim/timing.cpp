@@ -0,0 +1,155 @@
+/* timing.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Per-phase timers for the main loop, and the end-of-run timing report
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+#include "timing.h"
+
+const char* phase_names[NO_PHASES] = { "check", "seed", "contact", "message", "handle", "confirm",
+                                       "symptom", "recovery", "stats", "output", "interv", "movie" };
+
+double phaseClock() {
+  #ifdef _USEMPI
+    return MPI_Wtime();
+  #else
+    return omp_get_wtime();
+  #endif
+}
+
+void markPhase(world* w, int phase, double* t) {  // Charge time since *t to a phase, and restart the clock.
+  double now=phaseClock();
+  w->phase_time[phase]+=(now-*t);
+  *t=now;
+}
+
+int peakMemoryKB() {                               // Peak resident set size of this process, in KB.
+  return (int) procStatusKB("VmHWM:");
+}
+
+void reportTiming(world* w) {
+  // Each rank contributes: phase times, total loop time, steps, peak memory. Rank 0 prints one line per rank,
+  // in a fixed format that bin-linux/Sim/scaling.sh parses.
+
+  const int rec_size=NO_PHASES+3;
+  double* rec = new double[rec_size];
+  for (int i=0; i<NO_PHASES; i++) rec[i]=w->phase_time[i];
+  rec[NO_PHASES]=w->loop_time;
+  rec[NO_PHASES+1]=(double) w->steps_done;
+  rec[NO_PHASES+2]=(double) peakMemoryKB();
+  double* all_recs = NULL;
+  if (w->mpi_rank==0) all_recs = new double[rec_size*w->mpi_size];
+  #ifdef _USEMPI
+    MPI_Gather(rec,rec_size,MPI_DOUBLE,all_recs,rec_size,MPI_DOUBLE,0,MPI_COMM_WORLD);
+  #else
+    for (int i=0; i<rec_size; i++) all_recs[i]=rec[i];
+  #endif
+  if (w->mpi_rank==0) {
+    printf("TIMING ranks=%d threads=%d steps=%d\n",w->mpi_size,w->thread_count,w->steps_done);
+    printf("TIMING_HEAD rank");
+    for (int i=0; i<NO_PHASES; i++) printf(" %s",phase_names[i]);
+    printf(" total mem_kb\n");
+    for (int r=0; r<w->mpi_size; r++) {
+      double* rr = &all_recs[r*rec_size];
+      printf("TIMING_RANK %d",r);
+      for (int i=0; i<NO_PHASES; i++) printf(" %.6f",rr[i]);
+      printf(" %.6f %d\n",rr[NO_PHASES],(int) rr[NO_PHASES+2]);
+    }
+    fflush(stdout);
+    delete[] all_recs;
+  }
+  delete[] rec;
+  reportThreadBusy(w);
+  reportPlaceSearch(w);
+  reportFrames(w);
+}
+
+void reportThreadBusy(world* w) {
+  // Per-thread time spent processing the contact/confirm/symptom/recovery queues, excluding waits at the barriers.
+  // Imbalance is max/mean over the rank's threads - 1.0 means perfectly even. One line per rank:
+  //   TIMING_BUSY rank threads steals imbalance busy_0 busy_1 ...
+
+  const int rec_size=MAX_REPORT_THREADS+3;
+  double* rec = new double[rec_size];
+  int n=(w->thread_count<MAX_REPORT_THREADS)?w->thread_count:MAX_REPORT_THREADS;
+  double max_busy=0,sum_busy=0;
+  for (int i=0; i<rec_size; i++) rec[i]=0;
+  for (int i=0; i<n; i++) {
+    rec[3+i]=w->busy_time[i];
+    sum_busy+=w->busy_time[i];
+    if (w->busy_time[i]>max_busy) max_busy=w->busy_time[i];
+  }
+  rec[0]=(double) n;
+  rec[1]=(double) w->work->total_steals();
+  rec[2]=(sum_busy>0)?max_busy/(sum_busy/n):1.0;
+  double* all_recs = NULL;
+  if (w->mpi_rank==0) all_recs = new double[rec_size*w->mpi_size];
+  #ifdef _USEMPI
+    MPI_Gather(rec,rec_size,MPI_DOUBLE,all_recs,rec_size,MPI_DOUBLE,0,MPI_COMM_WORLD);
+  #else
+    for (int i=0; i<rec_size; i++) all_recs[i]=rec[i];
+  #endif
+  if (w->mpi_rank==0) {
+    printf("TIMING_SCHED %s chunk=%d\n",(w->sched_mode==SCHED_STEAL)?"steal":"stride",w->sched_chunk);
+    for (int r=0; r<w->mpi_size; r++) {
+      double* rr = &all_recs[r*rec_size];
+      printf("TIMING_BUSY %d %d %d %.3f",r,(int) rr[0],(int) rr[1],rr[2]);
+      for (int i=0; i<(int) rr[0]; i++) printf(" %.6f",rr[3+i]);
+      printf("\n");
+    }
+    fflush(stdout);
+    delete[] all_recs;
+  }
+  delete[] rec;
+}
+
+void reportPlaceSearch(world* w) {
+  // Average cost of mapping a host number to (group, node, member) for place contacts: binary-search steps per
+  // selection. Within-group contacts in single-node places take none. One line per rank:
+  //   TIMING_PLACE rank selections probes probes_per_selection
+
+  double rec[2]={0,0};
+  for (int i=0; i<w->thread_count; i++) {
+    rec[0]+=(double) w->place_search[i].selections;
+    rec[1]+=(double) w->place_search[i].probes;
+  }
+  double* all_recs = NULL;
+  if (w->mpi_rank==0) all_recs = new double[2*w->mpi_size];
+  #ifdef _USEMPI
+    MPI_Gather(rec,2,MPI_DOUBLE,all_recs,2,MPI_DOUBLE,0,MPI_COMM_WORLD);
+  #else
+    for (int i=0; i<2; i++) all_recs[i]=rec[i];
+  #endif
+  if (w->mpi_rank==0) {
+    for (int r=0; r<w->mpi_size; r++) {
+      double* rr = &all_recs[r*2];
+      printf("TIMING_PLACE %d %.0f %.0f %.3f\n",r,rr[0],rr[1],(rr[0]>0)?rr[1]/rr[0]:0.0);
+    }
+    fflush(stdout);
+    delete[] all_recs;
+  }
+}
+
+void reportFrames(world* w) {
+  // Movie frame encoding, on rank 0's writer thread - see pngframe.cpp. One line:
+  //   TIMING_FRAME format frames mean_ms max_ms mean_kb threads
+
+  if ((w->mpi_rank!=0) || (w->writer==NULL) || (!w->log_movie)) return;
+  outputWriter* wr = w->writer;
+  int frames=wr->noJobs(JOB_IMAGE);
+  printf("TIMING_FRAME %s %d %.3f %.3f %.1f %d\n",wr->movie_rle?"rle":"png",frames,(frames>0)?1000.0*wr->frame_time/frames:0.0,
+         1000.0*wr->frame_time_max,(frames>0)?wr->frame_bytes/(1024.0*frames):0.0,wr->movie_rle?1:wr->png_threads);
+  fflush(stdout);
+}
@@ -0,0 +1,58 @@
+/* timing.h, part of the Global Epidemic Simulation v1.0 BETA
+/* Header for per-phase timers and the timing report
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#include "world.h"
+
+#define PHASE_CHECK 0       // Scanning queues for remaining work (continue_status)
+#define PHASE_SEED 1        // Scheduled seed infections
+#define PHASE_CONTACT 2     // processContactQueue
+#define PHASE_MESSAGE 3     // doMessage - all MPI exchange, including waiting for other nodes
+#define PHASE_HANDLE 4      // handleIncomingMessage
+#define PHASE_CONFIRM 5     // processConfirmationQueue
+#define PHASE_SYMPTOM 6     // processSymptomaticQueue
+#define PHASE_RECOVERY 7    // processRecoveryQueue
+#define PHASE_STATS 8       // statsTimestep
+#define PHASE_OUTPUT 9      // Flat file and database logging
+#define PHASE_INTERV 10     // Intervention trigger checks
+#define PHASE_MOVIE 11      // updateImage
+#define NO_PHASES 12
+
+#define MAX_REPORT_THREADS 32   // randlib_par has streams for 32 threads
+
+class world;
+
+struct placeSearchCount {   // Host selections in makePlaceContacts(Remote) per thread, and binary-search steps they took
+  SIM_I64 selections;
+  SIM_I64 probes;
+  char pad[112];            // Keep each thread's counters on their own cache line
+};
+
+extern const char* phase_names[NO_PHASES];
+
+double phaseClock();
+void markPhase(world* w, int phase, double* t);
+void reportTiming(world* w);
+void reportThreadBusy(world* w);
+void reportPlaceSearch(world* w);
+void reportFrames(world* w);
+
+#endif
@@ -18,9 +18,92 @@
 
 #include "unit.h"
 
-double unit::kernel_F(unit* u, double d) {
+#define OMEGA 0.0172142063210399629504802377166
+#define PIby180 0.01745329251994329576923690768489
+
+kernelTable* unitHot::kernel_tables=NULL;
+int unitHot::no_kernel_tables=0;
+double* unitHot::cos2lat=NULL;
+bool unitHot::exact=false;
+
+double exactKernel(double k_a, double k_b, double k_cut, double d) {
+  if (d>k_cut) return 0;
+  else return 1.0/(1.0+pow((d/k_a),k_b));
+}
+
+double unitHot::kernel_F(unitHot* u, double d) {
   if (d>u->k_cut) return 0;
-  else return 1.0/(1.0+pow((d/u->k_a),u->k_b));
+  if (u->kernel_table<0) return 1.0/(1.0+pow((d/u->k_a),u->k_b));
+  kernelTable* t = &kernel_tables[u->kernel_table];
+  double x = d*t->scale;
+  int i = (int) x;
+  return t->f[i]+((x-i)*(t->f[i+1]-t->f[i]));
+}
+
+void unitHot::buildKernelTables(world* w) {
+  // One table per distinct (k_a,k_b,k_cut) - units in a country usually share them. Each table is tested at the
+  // midpoints between entries (where linear interpolation is worst) and at points either side of them; any that
+  // miss KERNEL_MAX_ERROR are dropped and their units use the exact kernel.
+
+  kernel_tables = new kernelTable[w->no_units];
+  no_kernel_tables=0;
+  int exact_units=0;
+  double worst=0;
+  for (int i=0; i<w->no_units; i++) {
+    unitHot* u = &w->unit_hot[i];
+    u->kernel_table=-1;
+    if ((exact) || (u->k_a<=0) || (u->k_b<=0) || (u->k_cut<=0)) {
+      exact_units++;
+      continue;
+    }
+    int j=0;
+    while ((j<no_kernel_tables) && ((kernel_tables[j].k_a!=u->k_a) || (kernel_tables[j].k_b!=u->k_b) || (kernel_tables[j].k_cut!=u->k_cut))) j++;
+    if (j==no_kernel_tables) {
+      kernelTable* t = &kernel_tables[j];
+      t->k_a=u->k_a;
+      t->k_b=u->k_b;
+      t->k_cut=u->k_cut;
+      t->scale=KERNEL_STEPS_PER_KA/u->k_a;
+      if (u->k_cut*t->scale>KERNEL_MAX_ENTRIES-2) t->scale=(KERNEL_MAX_ENTRIES-2)/u->k_cut;
+      t->n=(int) (u->k_cut*t->scale)+2;
+      t->f=new double[t->n+2];
+      for (int k=0; k<t->n; k++) t->f[k]=1.0/(1.0+pow((k/t->scale)/t->k_a,t->k_b));    // Beyond k_cut is never read
+      t->f[t->n]=0;                                                                     // ...except these two zeros, which
+      t->f[t->n+1]=0;                                                                   //   contactBlockAccept uses for d>k_cut
+      t->max_error=0;
+      for (int k=0; k<t->n-1; k++) {
+        for (int q=1; q<4; q++) {
+          double d=(k+(q*0.25))/t->scale;
+          if (d>t->k_cut) break;
+          double x=d*t->scale;
+          int m=(int) x;
+          double err=fabs((t->f[m]+((x-m)*(t->f[m+1]-t->f[m])))-exactKernel(t->k_a,t->k_b,t->k_cut,d));
+          if (err>t->max_error) t->max_error=err;
+        }
+      }
+      no_kernel_tables++;
+    }
+    if (kernel_tables[j].max_error<=KERNEL_MAX_ERROR) {
+      u->kernel_table=j;
+      if (kernel_tables[j].max_error>worst) worst=kernel_tables[j].max_error;
+    } else exact_units++;
+  }
+
+  cos2lat = new double[(int) (180.0/SEASONAL_LAT_STEP)+2];
+  for (int i=0; i<(int) (180.0/SEASONAL_LAT_STEP)+2; i++) cos2lat[i]=cos(2.0*(((i*SEASONAL_LAT_STEP)-90.0)*PIby180));
+
+  if (w->mpi_rank==0) {
+    printf("0:  Kernel tables: %d built, largest error %.2e, %d units exact%s\n",no_kernel_tables,worst,exact_units,exact?" (/kernel:exact)":"");
+    fflush(stdout);
+  }
+}
+
+void unitHot::updateSeasonality(world* w) {
+  // The time part of the seasonality is the same for the whole unit for the whole timestep.
+  for (int i=0; i<w->no_units; i++) {
+    unitHot* u = &w->unit_hot[i];
+    u->seasonal_now=cos(u->seasonal_temporal_offset+((double)OMEGA*(double)w->T_day));
+  }
 }
 
 unit::unit() {
@@ -33,7 +116,56 @@ unit::unit() {
   bc_deny_exit=-1;
   trt_mul_inf_clinical=-1;
   pph_susc=-1;
+  pph_inf=1;
+  pph_household=0;
   q_compliance=-1;
+  v_m_susc=1;
+  v_m_inf=1;
+  v_m_clin=1;
+  v_start=0;
+  mul_refresh_at=-1;
+  mul_stale=true;
+}
+
+void unit::syncHot(unitHot* h) {
+  h->k_a=k_a;
+  h->k_b=k_b;
+  h->k_cut=k_cut;
+  h->B_spat=B_spat;
+  h->bc_deny_exit=bc_deny_exit;
+  h->c_comm_mul=c_comm_mul;
+  h->q_community=q_community;
+  h->country=country;
+  h->B_hh=B_hh;
+  h->q_hh_rate=q_hh_rate;
+  h->q_s_wp_rate=q_s_wp_rate;
+  h->c_hh_mul=c_hh_mul;
+  h->seasonal_max=seasonal_max;
+  h->seasonal_min=seasonal_min;
+  h->seasonal_temporal_offset=seasonal_temporal_offset;
+}
+
+void unit::updateMultipliers(double t) {
+  // Cache the product of the multipliers that apply to each person state, so that getSusceptibility and
+  // getInfectiousness need one lookup. Recomputed when an intervention turns on or off, and when vaccination
+  // takes effect. A prophylaxed case is less infectious for a proportion pph_household of contacts; the cache
+  // holds the expected multiplier rather than drawing for every contact.
+
+  double pph_inf_expected=1.0-(pph_household*(1.0-pph_inf));
+  bool vacc_on=(t>=v_start);
+  susc_mul[0]=1.0;
+  susc_mul[MUL_PPH]=pph_susc;
+  susc_mul[MUL_VACC]=v_m_susc;
+  susc_mul[MUL_PPH+MUL_VACC]=pph_susc*v_m_susc;
+  for (int sev=0; sev<3; sev++) {
+    double m = (sev==2)?mul_severe_inf:((sev==1)?mul_sympt_inf:1.0);
+    inf_mul[(sev*MUL_SEVERITY)]=m;
+    inf_mul[(sev*MUL_SEVERITY)+MUL_PPH]=m*pph_inf_expected;
+    inf_mul[(sev*MUL_SEVERITY)+MUL_VACC]=vacc_on?m*v_m_inf:m;
+    inf_mul[(sev*MUL_SEVERITY)+MUL_PPH+MUL_VACC]=vacc_on?m*pph_inf_expected*v_m_inf:m*pph_inf_expected;
+  }
+  mul_refresh_at=vacc_on?-1:v_start;
+  mul_stale=false;
 }
 
 unit::~unit() {
@@ -110,12 +242,15 @@ void unit::delta_sympt_case(world* w, unsigned int unit_no, int thread_no,int de
 
 void unit::vaccinate(world* w,unsigned int unit_no) {
   // Not totally trivial to find app people in a unit...
+  int thread_no=omp_get_thread_num();          // Intervention checks are shared out over the team - use this thread's stream,
+  if (w->sched_mode==SCHED_STEAL)              // keyed on the unit under work-stealing (see reseedPerson in sim.cpp).
+    reseedStream_mt(thread_no,(long) ((w->T*NO_PHASES)+PHASE_INTERV),-1-(SIM_I64) unit_no);
   if (country!=UNIVERSE) {
     for (int i=0; i<w->patches_in_country[country].size(); i++) {
       localPatch* lp = w->localPatchList[w->patches_in_country[country][i]];
       for (int j=0; j<lp->no_people; j++) {
-        if (lp->people[j].house->unit==(int)unit_no) {
-          if (ranf_mt(0)<v_coverage) {
+        if (lp->people[j].getHouse()->unit==(int)unit_no) {
+          if (ranf_mt(thread_no)<v_coverage) {
             lp->people[j].status = lp->people[j].status | VACCINATED;
           } 
         }
@@ -125,8 +260,8 @@ void unit::vaccinate(world* w,unsigned int unit_no) {
     for (unsigned int i=0; i<w->noLocalPatches; i++) {
       localPatch* lp = w->localPatchList[i];
       for (int j=0; j<lp->no_people; j++) {
-        if (lp->people[j].house->unit==(int)unit_no) {
-          if (ranf_mt(0)<v_coverage) {
+        if (lp->people[j].getHouse()->unit==(int)unit_no) {
+          if (ranf_mt(thread_no)<v_coverage) {
             lp->people[j].status = lp->people[j].status | VACCINATED;
           } 
         }
@@ -135,15 +270,17 @@ void unit::vaccinate(world* w,unsigned int unit_no) {
   }
 }
 
-#define OMEGA 0.0172142063210399629504802377166
-#define PIby180 0.01745329251994329576923690768489
-
-double unit::getSeasonality(world* w, double latitude) {
-  
+double unitHot::getSeasonality(world* w, double latitude) {
+  double c2lat;
+  if (exact) c2lat=cos(2.0*(latitude*PIby180));
+  else {
+    double x=(latitude+90.0)/SEASONAL_LAT_STEP;
+    int i=(int) x;
+    c2lat=cos2lat[i]+((x-i)*(cos2lat[i+1]-cos2lat[i]));
+  }
   double temp = (seasonal_max+seasonal_min)/2.0;
-  temp-=((seasonal_max-seasonal_min)/2.0)*cos(2.0*(latitude*PIby180));
-  return 1.0+(temp*(cos(seasonal_temporal_offset+((double)OMEGA*(double)w->T_day))));
-  
+  temp-=((seasonal_max-seasonal_min)/2.0)*c2lat;
+  return 1.0+(temp*seasonal_now);
 }
 
 
@@ -22,8 +22,67 @@
 #include "intervention.h"
 
 #define UNIVERSE  255
+
+#define MUL_PPH 1           // Index offsets into unit::susc_mul / inf_mul: prophylaxis window open,
+#define MUL_VACC 2          //   vaccinated,
+#define MUL_SEVERITY 4      //   x 0 (asymptomatic), 1 (symptomatic) or 2 (severe) - inf_mul only.
+#define MUL_STATES 12
 class LiveIntervention;
 
+// Tabulated movement kernel, shared by all units with the same (k_a,k_b,k_cut). Linear interpolation in distance,
+// with the step chosen from k_a, and checked against the exact kernel when built - see buildKernelTables.
+
+#define KERNEL_STEPS_PER_KA 128     // Table entries per k_a of distance
+#define KERNEL_MAX_ENTRIES 1048576  // Larger tables are built coarser, and only used if they still pass the check
+#define KERNEL_MAX_ERROR 1e-4       // Largest absolute error allowed for a table; otherwise the unit stays exact
+#define SEASONAL_LAT_STEP 0.1       // Degrees per entry in the cos(2*latitude) table
+
+class kernelTable {
+  public:
+    double k_a,k_b,k_cut;
+    double scale;                   // Entries per km
+    int n;
+    double* f;                      // [n+2] - kernel at i/scale km, then two zeros
+    double max_error;               // Worst error found at the test points
+};
+
+// The unit parameters that the contact kernels read, copied out of unit into one packed, cache-aligned array
+// (w->unit_hot) so that a contact touches one line per unit rather than the whole unit object. The first line has
+// what every community contact attempt reads; the second, what household/place contacts and each contact-maker read.
+// unit::syncHot keeps it up to date - it is called at load, and whenever an intervention turns on or off.
+
+class unitHot {
+  public:
+    double k_a,k_b,k_cut;          // Local movement kernel
+    double B_spat;                 // Transmission coefficient for spatial contacts
+    double bc_deny_exit;           // Border control (-1 = off)
+    double c_comm_mul;             // Place closure: multiply community contact rate
+    double q_community;            // Quarantine: multiply community contact rate
+    unsigned char country;
+    char pad1[3];
+    int kernel_table;              // Index into kernel_tables, or -1 to evaluate exactly
+
+    double B_hh;                   // Transmission coefficient for households
+    double q_hh_rate,q_s_wp_rate;  // Quarantine: multiply household, school/workplace contact rates
+    double c_hh_mul;               // Place closure: multiply household contact rate
+    double seasonal_max;
+    double seasonal_min;
+    double seasonal_temporal_offset;
+    double seasonal_now;           // cos(seasonal_temporal_offset+OMEGA*T_day), set each timestep by updateSeasonality
+
+    static kernelTable* kernel_tables;
+    static int no_kernel_tables;
+    static double* cos2lat;        // cos(2*latitude) every SEASONAL_LAT_STEP degrees from -90
+    static bool exact;             // /kernel:exact - evaluate kernel and seasonality directly, for validation
+
+    static double kernel_F(unitHot* u, double d);
+    double getSeasonality(world* w, double latitude);
+    static void buildKernelTables(world* w);
+    static void updateSeasonality(world* w);
+};
+
+#define UNIT_HOT_ALIGN 64
+
 class unit {
   public:
     unsigned char level;   // Level of this admin unit
@@ -65,6 +124,11 @@ class unit {
     double c_hh_mul,c_comm_mul;          //                  multiply household and community contact rates
     int c_unit;                          //                  unit (0=cases, 1=% ?)
 
+    double susc_mul[4];                  // Products of the multipliers above for each person state - see updateMultipliers
+    double inf_mul[MUL_STATES];
+    double mul_refresh_at;               // Time (hours) at which the cache must be recomputed (vaccine takes effect), or -1
+    bool mul_stale;                      // An intervention turned on or off since the cache was computed
+
     double p_symptomatic, p_severe;        // probabilities of an infection being symptomatic/severe
     double p_detect_sympt,p_detect_severe;  // probability of a case being detected!
     double* abs_place_sympt;                // for each place type, probability of place absenteeism given a clinical infection
@@ -108,7 +172,6 @@ class unit {
     
     ~unit();
     
-    static double kernel_F(unit* u, double d);
     void add_comm_case(world* w, unsigned int unit_no, int thread_no, bool clinical);
     void add_place_case(world* w, unsigned int unit_no, unsigned char place_type, int thread_no, bool clinical);
     void add_hh_case(world* w, unsigned int unit_no, int thread_no, bool clinical);
@@ -116,7 +179,8 @@ class unit {
     void delta_sympt_case(world* w, unsigned int unit_no, int thread_no,int delta);
 
     void vaccinate(world* w,unsigned int unit_no);
-    double getSeasonality(world* w, double latitude);
+    void updateMultipliers(double t);
+    void syncHot(unitHot* h);
   };
 
 
@@ -0,0 +1,129 @@
+/* workqueue.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Chunked, work-stealing distribution of the event queues over threads
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+#include "workqueue.h"
+
+// The event queues are per-thread only for write safety: any thread may process any queued person. Rather than
+// interleaving the concatenated queues over threads, fill() cuts each queue into contiguous chunks, and deals a
+// contiguous run of chunks to each thread - so a thread mostly processes what it queued itself. When a thread's
+// deque is empty it steals single chunks from the back of the others, so expensive individuals (travellers,
+// large places) don't leave the rest of the team waiting at the barrier.
+
+workQueue::workQueue(int _threads, int _mode, int _chunk_size) {
+  threads=_threads;
+  mode=_mode;
+  chunk_size=(_chunk_size>0)?_chunk_size:DEFAULT_CHUNK;
+  no_chunks=0;
+  max_chunks=1024;
+  chunk_queue = new int[max_chunks];
+  chunk_first = new int[max_chunks];
+  chunk_last = new int[max_chunks];
+  queue_size = new int[threads];
+  deques = new threadDeque[threads];
+  for (int i=0; i<threads; i++) {
+    omp_init_lock(&deques[i].lock);
+    deques[i].front=0;
+    deques[i].back=0;
+    deques[i].steals=0;
+    queue_size[i]=0;
+  }
+}
+
+workQueue::~workQueue() {
+  for (int i=0; i<threads; i++) omp_destroy_lock(&deques[i].lock);
+  delete[] deques;
+  delete[] queue_size;
+  delete[] chunk_queue;
+  delete[] chunk_first;
+  delete[] chunk_last;
+}
+
+void workQueue::fill(lwv::vector<infectedPerson*>** queue, int slot) {
+  if (mode==SCHED_STRIDE) {
+    for (int i=0; i<threads; i++) {
+      queue_size[i]=(int) queue[i][slot].size();
+      deques[i].front=i;                                     // Global index into the concatenated queues
+    }
+    return;
+  }
+
+  int needed=0;
+  for (int i=0; i<threads; i++) needed+=((int) queue[i][slot].size()+chunk_size-1)/chunk_size;
+  if (needed>max_chunks) {
+    while (max_chunks<needed) max_chunks*=2;
+    delete[] chunk_queue; delete[] chunk_first; delete[] chunk_last;
+    chunk_queue = new int[max_chunks];
+    chunk_first = new int[max_chunks];
+    chunk_last = new int[max_chunks];
+  }
+  no_chunks=0;
+  for (int i=0; i<threads; i++) {
+    int size=(int) queue[i][slot].size();
+    for (int j=0; j<size; j+=chunk_size) {
+      chunk_queue[no_chunks]=i;
+      chunk_first[no_chunks]=j;
+      chunk_last[no_chunks]=(j+chunk_size<size)?j+chunk_size:size;
+      no_chunks++;
+    }
+  }
+  for (int i=0; i<threads; i++) {                            // Contiguous, equal-sized runs of chunks
+    deques[i].front=(int) (((long long) no_chunks*i)/threads);
+    deques[i].back=(int) (((long long) no_chunks*(i+1))/threads);
+  }
+}
+
+bool workQueue::next(int thread_no, int* queue_no, int* first, int* last, int* chunk_id) {
+  if (mode==SCHED_STRIDE) {                                  // One item at a time; no locking needed.
+    int g=deques[thread_no].front;
+    int q=0;
+    while ((q<threads) && (g>=queue_size[q])) { g-=queue_size[q]; q++; }
+    if (q>=threads) return false;
+    *queue_no=q;
+    *first=g;
+    *last=g+1;
+    *chunk_id=deques[thread_no].front;
+    deques[thread_no].front+=threads;
+    return true;
+  }
+
+  int c=-1;
+  threadDeque* d = &deques[thread_no];
+  omp_set_lock(&d->lock);
+  if (d->front<d->back) c=d->front++;
+  omp_unset_lock(&d->lock);
+
+  for (int i=1; (c==-1) && (i<threads); i++) {               // Own deque empty - try the others in turn
+    threadDeque* v = &deques[(thread_no+i)%threads];
+    omp_set_lock(&v->lock);
+    if (v->front<v->back) c=--v->back;
+    omp_unset_lock(&v->lock);
+    if (c!=-1) d->steals++;
+  }
+  if (c==-1) return false;                                   // Nothing left anywhere - no new work appears during a phase.
+  *queue_no=chunk_queue[c];
+  *first=chunk_first[c];
+  *last=chunk_last[c];
+  *chunk_id=c;
+  return true;
+}
+
+int workQueue::total_steals() {
+  int total=0;
+  for (int i=0; i<threads; i++) total+=deques[i].steals;
+  return total;
+}
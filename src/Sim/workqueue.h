@@ -0,0 +1,61 @@
+/* workqueue.h, part of the Global Epidemic Simulation v1.0 BETA
+/* Chunked, work-stealing distribution of the event queues over threads
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include "omp.h"
+#include "vector_replacement.h"
+
+#define SCHED_STRIDE 0      // Original scheme: thread t takes items t, t+threads, t+2*threads... of the concatenated queues
+#define SCHED_STEAL 1       // Contiguous chunks dealt to per-thread deques; idle threads steal from the back of others
+#define DEFAULT_CHUNK 32    // Items per chunk (/chunk:N)
+
+class infectedPerson;
+
+struct threadDeque {        // One per thread, padded so that threads don't share cache lines.
+  omp_lock_t lock;
+  int front;                // Next chunk the owner will take
+  int back;                 // One past the last chunk - thieves take from here
+  int steals;               // Chunks this thread has stolen from others (whole run)
+  char pad[64];
+};
+
+class workQueue {
+  public:
+    workQueue(int _threads, int _mode, int _chunk_size);
+    ~workQueue();
+    void fill(lwv::vector<infectedPerson*>** queue, int slot);    // Split queue[0..threads-1][slot] into chunks. Call from one thread.
+    bool next(int thread_no, int* queue_no, int* first, int* last, int* chunk_id);   // Claim work: items first..last-1 of queue[queue_no][slot]
+    int mode;
+    int chunk_size;
+    int total_steals();
+
+  private:
+    int threads;
+    int no_chunks;
+    int max_chunks;
+    int* chunk_queue;       // For each chunk, which thread's queue...
+    int* chunk_first;       // ...and the range of items in it.
+    int* chunk_last;
+    int* queue_size;        // SCHED_STRIDE: size of each queue at fill()
+    threadDeque* deques;
+};
+
+#endif
@@ -25,12 +25,93 @@ world::world(int argc, char *argv[]) {
   in_path="";
   infectionMod=0;
   con_toggle=0;
+  log_timing=false;
+  mem_every=0;
+  mem_next=0;
+  dry_run=-1;
+  max_steps=0;
+  traffic_file=NULL;
+  metrics_spec=NULL;
+  metrics=NULL;
+  ff_override=NULL;
+  fb_file=NULL;
+  ff=NULL;
+  fb=NULL;
+  shard_file=NULL;
+  shard=NULL;
+  grid=NULL;                                 // Made once the population is loaded, if there's a movie
+  event_file=NULL;
+  events=NULL;
+  fast_forward=true;
+  reorder_population=true;
+  exact_kernels=false;
+  block_contacts=true;
+  async_output=true;
+  movie_rle=false;
+  png_threads=1;
+  writer=NULL;
+  db_flush_rows=DB_FLUSH_ROWS;
+  seed_override=false;
+  sched_mode=SCHED_STEAL;
+  sched_chunk=DEFAULT_CHUNK;
   for (int i=1; i<argc; i++) {
     if (strnicmp("/in:",argv[i],4)==0) {               // Specify where params.bin is found.
       in_path=argv[i];
       in_path=in_path.substr(4)+"/";
     } else if (strnicmp("/ompmax:",argv[i],8)==0) {    // Force number of OMP threads
       sscanf(argv[i]+8,"%d", &thread_max);
+    } else if (strnicmp("/steps:",argv[i],7)==0) {     // Stop after a fixed number of timesteps
+      sscanf(argv[i]+7,"%u", &max_steps);
+    } else if (strnicmp("/timing",argv[i],7)==0) {     // Report per-phase timings at the end
+      log_timing=true;
+    } else if (strnicmp("/dryrun",argv[i],7)==0) {     // Estimate memory and work for each rank from the input files, and stop
+      dry_run=0;
+      if (argv[i][7]==':') sscanf(argv[i]+8,"%d",&dry_run);
+    } else if (strnicmp("/memreport:",argv[i],11)==0) {   // Memory used by each part of the simulation, every N timesteps
+      sscanf(argv[i]+11,"%u",&mem_every);
+    } else if (strnicmp("/traffic:",argv[i],9)==0) {  // Record MPI traffic matrices for the replay benchmark
+      traffic_file=new char[strlen(argv[i])-8];
+      strcpy(traffic_file,argv[i]+9);
+    } else if (strnicmp("/metrics:",argv[i],9)==0) {  // Serve live metrics on rank 0 - a localhost port, or a Unix socket path
+      metrics_spec=new char[strlen(argv[i])-8];
+      strcpy(metrics_spec,argv[i]+9);
+    } else if (strnicmp("/ffout:",argv[i],7)==0) {     // Write flat file output here instead
+      ff_override=new char[strlen(argv[i])-6];
+      strcpy(ff_override,argv[i]+7);
+    } else if (strnicmp("/ffbin:",argv[i],7)==0) {     // Also write the flat file rows in binary here
+      fb_file=new char[strlen(argv[i])-6];
+      strcpy(fb_file,argv[i]+7);
+    } else if (strnicmp("/ffmpi:",argv[i],7)==0) {     // Also write the flat file rows here, from every rank with MPI-IO
+      shard_file=new char[strlen(argv[i])-6];
+      strcpy(shard_file,argv[i]+7);
+    } else if (strnicmp("/events:",argv[i],8)==0) {    // Log every infection (who infected whom) to file.<rank>
+      event_file=new char[strlen(argv[i])-7];
+      strcpy(event_file,argv[i]+8);
+    } else if (strnicmp("/seed:",argv[i],6)==0) {      // Override random seeds. /seed:s1,s2 or /seed:s1 (s2 derived from s1)
+      if (sscanf(argv[i]+6,"%d,%d",&seed1,&seed2)<2) seed2=seed1+7919;
+      seed_override=true;
+    } else if (strnicmp("/noskip",argv[i],7)==0) {     // Run every timestep in full, even when nothing happens
+      fast_forward=false;
+    } else if (strnicmp("/kernel:exact",argv[i],13)==0) {   // Exact kernel and seasonality, to validate the tables against
+      exact_kernels=true;
+    } else if (strnicmp("/syncout",argv[i],8)==0) {    // Write flat file, movie and database output in the main loop
+      async_output=false;
+    } else if (strnicmp("/moviefmt:rle",argv[i],13)==0) {   // Movie frames as run-length files, not PNGs
+      movie_rle=true;
+    } else if (strnicmp("/pngthreads:",argv[i],12)==0) {    // Threads for each PNG frame (default 1) - see world.h
+      sscanf(argv[i]+12,"%d",&png_threads);
+      if (png_threads<1) png_threads=1;
+    } else if (strnicmp("/dbbatch:",argv[i],9)==0) {   // Database rows to batch up before each insert and commit
+      sscanf(argv[i]+9,"%d",&db_flush_rows);
+      if (db_flush_rows<1) db_flush_rows=1;
+    } else if (strnicmp("/noblock",argv[i],8)==0) {    // Make community contacts one candidate at a time
+      block_contacts=false;
+    } else if (strnicmp("/noreorder",argv[i],10)==0) {  // Keep patches and households in file order
+      reorder_population=false;
+    } else if (strnicmp("/sched:stride",argv[i],13)==0) {   // Interleave queues over threads as before, instead of chunks + stealing
+      sched_mode=SCHED_STRIDE;
+    } else if (strnicmp("/chunk:",argv[i],7)==0) {     // Items per chunk for work-stealing
+      sscanf(argv[i]+7,"%d",&sched_chunk);
     }
   }
 
@@ -38,9 +119,14 @@ world::world(int argc, char *argv[]) {
   
 // Initialise MPI
    #ifdef _USEMPI
-    MPI_Init(&argc,&argv);
+    int mpi_thread_level;
+    MPI_Init_thread(&argc,&argv,MPI_THREAD_FUNNELED,&mpi_thread_level);   // MPI calls are made by the master thread of runSim's parallel region
     MPI_Comm_size(MPI_COMM_WORLD,&mpi_size);
     MPI_Comm_rank(MPI_COMM_WORLD,&mpi_rank);
+    if ((mpi_thread_level<MPI_THREAD_FUNNELED) && (mpi_rank==0)) {
+      printf("%d: Warning - MPI library does not guarantee MPI_THREAD_FUNNELED\n",mpi_rank);
+      fflush(stdout);
+    }
     char name[MPI_MAX_PROCESSOR_NAME];
     int len;
     MPI_Get_processor_name(name, &len);
@@ -88,6 +174,10 @@ world::world(int argc, char *argv[]) {
       allPatchLookup[i][j]=-1;
     }
   }
+  if (dry_run>=0) {                          // Instead of loading - see preflight.cpp
+    if (mpi_rank==0) preflight(this,param_file);
+    return;
+  }
   loadBinaryInitFile(this,param_file);
   buffer = new unsigned char*[thread_count];
   req_bytes_from = new unsigned int[mpi_size];
@@ -105,6 +195,13 @@ world::world(int argc, char *argv[]) {
   for (int j=0; j<thread_count; j++) contactQueue[j] = new lwv::vector<infectedPerson*>[P->infectionWindow];
   symptomQueue = new lwv::vector<infectedPerson*>*[thread_count];
   for (int j=0; j<thread_count; j++) symptomQueue[j] = new lwv::vector<infectedPerson*>[P->infectionWindow];
+  queued_events = new int*[thread_count];
+  queued_total = new int[thread_count];
+  for (int j=0; j<thread_count; j++) {
+    queued_events[j] = new int[P->infectionWindow];
+    for (int k=0; k<P->infectionWindow; k++) queued_events[j][k]=0;
+    queued_total[j]=0;
+  }
   
   for (int i=0; i<thread_count; i++) {
     buffer[i]=new unsigned char[8];
@@ -155,21 +252,6 @@ world::world(int argc, char *argv[]) {
 
   printf("After vector initialisation\n"); fflush(stdout);
 
-  infected_grid = new int**[PNG_WIDTH];
-  immune_grid = new int**[PNG_WIDTH];
-  for (int i=0; i<PNG_WIDTH; i++) {
-    infected_grid[i]=new int*[PNG_HEIGHT];
-    immune_grid[i]=new int*[PNG_HEIGHT];
-    for (int j=0; j<PNG_HEIGHT; j++) {
-      infected_grid[i][j] = new int[thread_count];
-      immune_grid[i][j] = new int[thread_count];
-      for (int k=0; k<thread_count; k++) {
-        infected_grid[i][j][k]=0;
-        immune_grid[i][j][k]=0;
-      }
-    }
-  }
-
   // Initialise remote request counters
   
   placeInfMsg = new lwv::vector<unsigned char>*[thread_count];
@@ -195,6 +277,23 @@ world::world(int argc, char *argv[]) {
   }
 
   
+  phase_time = new double[NO_PHASES];
+  for (int i=0; i<NO_PHASES; i++) phase_time[i]=0;
+  loop_time=0;
+  steps_done=0;
+  steps_skipped=0;
+  skip_next=0;
+  busy_time = new double[thread_count];
+  for (int i=0; i<thread_count; i++) busy_time[i]=0;
+  place_search = new placeSearchCount[thread_count];
+  for (int i=0; i<thread_count; i++) {
+    place_search[i].selections=0;
+    place_search[i].probes=0;
+  }
+  initLiveMemory(thread_count);
+  work = new workQueue(thread_count,sched_mode,sched_chunk);
+  susc_removed = new lwv::vector<person*>[thread_count];
+
   // Initialise parameters
 
   T=0;
@@ -223,6 +322,7 @@ world::~world() {
     delete [] confirmQueue[i];
     delete [] recoveryQueue[i];
     delete [] symptomQueue[i];
+    delete [] queued_events[i];
     delete [] node_mpi_use[i];
     delete [] req_base[i];
     delete [] reply_base[i];
@@ -232,17 +332,8 @@ world::~world() {
   delete [] confirmQueue;
   delete [] recoveryQueue;
   delete [] symptomQueue;
-
-  for (int i=0; i<PNG_WIDTH; i++) {
-    for (int j=0; j<PNG_HEIGHT; j++) {
-      delete [] infected_grid[i][j];
-      delete [] immune_grid[i][j];
-    }
-    delete [] infected_grid[i];
-    delete [] immune_grid[i];
-  }
-  delete [] infected_grid;
-  delete [] immune_grid;
+  delete [] queued_events;
+  delete [] queued_total;
 
   for (int i=0; i<thread_count; i++) {
     for (int j=0; j<mpi_size; j++) {
@@ -312,19 +403,38 @@ world::~world() {
     patches_in_country[i].clear();
     country_patch_pop[i].clear();
     delete[] people_per_country_per_node[i];
+    delete[] country_patch_cum[i];
   }
+  delete[] country_patch_cum;
+  delete[] visitor_weight;
+  delete[] patch_country_start;
+  delete[] patch_country;
+  delete[] patch_country_slot;
   delete[] patches_in_country;
   delete[] country_patch_pop;
   delete[] people_per_country_per_node;
   
   delete[] interventions;
-  for (int i=0; i<no_countries; i++) {
-    for (unsigned int j=0; j<P->no_place_types; j++) {
-      places[i][j].clear();
-    }
-    delete[] places[i];
-  }
+  for (int i=0; i<no_countries; i++) delete[] places[i];
 
  delete[] places;
+ delete[] phase_time;
+ delete[] busy_time;
+ delete[] place_search;
+ delete[] unit_hot_block;
+ delete work;
+ delete writer;
+ delete shard;
+ delete grid;
+ delete events;
+ delete metrics;
+ delete[] traffic_file;             // Command-line option strings
+ delete[] ff_override;
+ delete[] fb_file;
+ delete[] shard_file;
+ delete[] event_file;
+ delete[] metrics_spec;
+ for (int i=0; i<thread_count; i++) susc_removed[i].clear();
+ delete[] susc_removed;
 
 }
@@ -34,6 +34,16 @@
 #include "intervention.h"
 #include "place.h"
 #include "output.h"
+#include "timing.h"
+#include "workqueue.h"
+#include "susceptibles.h"
+#include "writer.h"
+#include "shardout.h"
+#include "eventlog.h"
+#include "imagegrid.h"
+#include "memreport.h"
+#include "preflight.h"
+#include "metrics.h"
 
 
 class patch;
@@ -43,8 +53,15 @@ class infectedPerson;
 class world;
 class params;
 class unit;
+class unitHot;
 class intervention;
 class place;
+class placeList;
+struct placeSearchCount;
+class shardOutput;
+class eventLog;
+class imageGrid;
+class metricsServer;
 
 class world { // The world as this node sees it.
   public:
@@ -54,8 +71,7 @@ class world { // The world as this node sees it.
     int allPatchLookup[2160][1080];      // Lookup table, so you can quickly get to a patch index in allPatches - which will equal indexes for patch_populations.
 
     DBOps *db;
-    int*** immune_grid;              // [x][y][thread] - number of immune people (for PNG output) on this node
-    int*** infected_grid;            // [x][y][thread] - number of infected people (for PNG output) on this node
+    imageGrid* grid;                 // Movie only: infected/immune counts and this node's image - see imagegrid.cpp
     unsigned int noLocalPatches;
     unsigned int noRemotePatches;
     unsigned int totalPatches;
@@ -78,9 +94,27 @@ class world { // The world as this node sees it.
     bool log_flat;
     char* ff_path;
     char* ff_file;
+    char* ff_override;           // Flat file from the command line (/ffout:file), replacing the one in params.bin. NULL = not given.
+    char* fb_file;               // Binary flat file (/ffbin:file) - see flatbin.h. NULL = not given.
+    FILE* fb;
+    char* shard_file;            // Sharded flat file (/ffmpi:file), written by every rank with MPI-IO. NULL = not given.
+    shardOutput* shard;          // Every rank, while shard_file is being written - see shardout.cpp
+    char* event_file;            // Transmission event log (/events:file), one file.<rank> per rank. NULL = off.
+    eventLog* events;            // ...and the per-thread buffers for it - see eventlog.cpp
+    bool seed_override;          // Random seeds from the command line (/seed:s1,s2), replacing those in params.bin
+    int seed1;
+    int seed2;
     bool log_movie;
     char* mv_path;
     char* mv_file;
+    bool movie_rle;              // Save frames as run-length files (/moviefmt:rle) for src/MovieConv to make into PNGs later
+    int png_threads;             // Threads the writer uses to encode each PNG frame (/pngthreads:N) - see pngframe.cpp. Default 1.
+                                 // The writer thread runs beside the main loop's team, which already has a thread per core,
+                                 // so more only helps if cores are spare. Under /syncout frames are encoded inside runSim's
+                                 // parallel region, where the nested team gets one thread - so it has no effect there.
+    bool async_output;           // Flat file, movie frames and database rows written by a background thread (default; /syncout turns it off)
+    outputWriter* writer;        // Rank 0 while the flat file or movie is on, and the last rank while logging to the database - see writer.cpp
+    int db_flush_rows;           // Database rows batched up before each insert and commit (/dbbatch:N)
     int log_10day_slot;
     unsigned char con_toggle;    // Toggles between 1 and 0 for contact confirmations single queue
     int infectionMod;            // Current modulo of infection sliding window
@@ -112,6 +146,28 @@ class world { // The world as this node sees it.
     patch** allPatchList;        // All the patches, local and remote
     int* patch_populations;      // Population of each patch. Only need it at initialisation, so delete afterwards.
     int continue_status;         // A flag: >=1 = at least one node wants to continue work. 0 = everyone is totally finished.
+
+    // Timing
+
+    bool log_timing;             // Print per-phase timers at the end of the run (/timing)
+    unsigned int max_steps;      // Stop after this many timesteps (/steps:N). 0 = run until the epidemic ends.
+    unsigned int steps_done;     // Timesteps completed so far
+    bool fast_forward;           // Skip timesteps that are empty on all nodes (default on; /noskip turns it off)
+    bool exact_kernels;          // Evaluate the movement kernel and seasonality directly instead of from tables (/kernel:exact)
+    bool block_contacts;         // Draw and test community contacts in blocks (default on; /noblock uses one at a time)
+    bool reorder_population;     // Sort patches, households and people along a Hilbert curve at load (/noreorder turns it off)
+    unsigned int steps_skipped;  // Timesteps skipped by fast-forwarding
+    int skip_next;               // Timesteps after this one that every node agreed to fast-forward - see addSkipInfo
+    double* phase_time;          // Seconds spent in each phase of the main loop [phase] - see timing.h
+    double loop_time;            // Seconds spent in the main loop
+    double* busy_time;           // Seconds each thread spent processing queued individuals [thread] - excludes waiting at barriers
+    placeSearchCount* place_search;  // Cost of choosing hosts in places [thread] - see timing.h
+    char* traffic_file;          // Record the per-timestep MPI byte matrices here (/traffic:file) for bin-linux/CommReplay. NULL = off.
+    unsigned int mem_every;      // Print the memory report every this many timesteps (/memreport:N), and at startup and the end. 0 = off.
+    unsigned int mem_next;       // ...next at this step - see memreport.cpp
+    char* metrics_spec;          // Serve Prometheus metrics on rank 0 (/metrics:port, or /metrics:path for a Unix socket). NULL = off.
+    metricsServer* metrics;      // ...rank 0's server, during runSim - see metrics.cpp
+    int dry_run;                 // /dryrun[:N] - estimate memory and work for N ranks (0 = as config_0.lsi says) and stop. -1 = off.
     
     // Travel matrix
     
@@ -127,9 +183,20 @@ class world { // The world as this node sees it.
 
     lwv::vector<int>* patches_in_country;  //   Each patch that has people belonging to each country
     lwv::vector<int>* country_patch_pop;   //   Population in associated patch in associated country!
+    int** country_patch_cum;               //   Running totals of country_patch_pop [country][patch], for getPatchForPerson
+
+    // Susceptible index - see susceptibles.cpp
+
+    lwv::vector<person*>* susc_removed;    // People who stopped being susceptible this timestep [thread] - applied in endTimestep
+    fenwickTree* visitor_weight;           // [country] - weight of each of patches_in_country, for pickSusceptible
+    int* patch_country_start;              // For each local patch, its entries in patches_in_country are
+    unsigned char* patch_country;          //   patch_country[patch_country_start[p]..patch_country_start[p+1]-1], at
+    int* patch_country_slot;               //   patch_country_slot (the index into patches_in_country[country])
 
     int no_units;                     //   Number of administrative units
     unit* a_units;                    //   List of administrative units
+    unitHot* unit_hot;                //   Their contact-kernel parameters, packed [unit] - see unit.h
+    char* unit_hot_block;             //   (Allocation that unit_hot is aligned within)
     unsigned int** people_per_country_per_node; // For each country, gives number of people on each node. (Even if zero)
 
     intervention* interventions;
@@ -143,21 +210,17 @@ class world { // The world as this node sees it.
     // Establishments
 
     unsigned int** no_places;             // No. of establishments [country][place_type] on this node.
-    lwv::vector<place*>** places;         // Array of [country][type] vectors - so we can assign NULL
+    placeList** places;                   // [country][type] - see place.h
                                           // to establishments absent from this node, while preserving the indexes.
 
     // End
 
-#define PNG_WIDTH 2160
-#define PNG_HEIGHT 1080
-
     char* read_buffer;
     SIM_I64 buffer_content;
     SIM_I64 buffer_pointer;
 #define BUFFER_SIZE 100000000L
     
     
-    unsigned char image[PNG_WIDTH*PNG_HEIGHT]; // The image for output - put here just so the message class can see it more easily.
     lwv::vector<SIM_I64>** reqHostAddresses;         // A list (per thread, per step) of addresses of infected people (on other nodes), who have requested contacts from this node
     lwv::vector<lwv::vector<unsigned short> >** reqOrders;  // For each address above, a list of "contact numbers" for successful contacts.
     lwv::vector<lwv::vector<SIM_I64> >** reqContactAddresses;  // For each address above, a list of "contact numbers" for successful contacts.
@@ -166,6 +229,11 @@ class world { // The world as this node sees it.
     lwv::vector<infectedPerson*>** recoveryQueue;      // List of individuals per thread who will recover in a timestep in the future.   [thread][2] - only need a one-timestep buffer.
     lwv::vector<infectedPerson*>** contactQueue;       // List of individuals who will establish contacts. [thread][time]
     lwv::vector<infectedPerson*>** symptomQueue;       // List of individuals who will exhibit symptoms. [thread][time]
+    int** queued_events;                               // Contact+symptom+recovery events waiting in each slot [thread][time]
+    int* queued_total;                                 // Sum of queued_events over the window [thread]
+    workQueue* work;                                   // Deals the queues above out to threads - see workqueue.cpp
+    int sched_mode;                                    // SCHED_STEAL (default) or SCHED_STRIDE (/sched:stride)
+    int sched_chunk;                                   // Items per chunk (/chunk:N)
     unsigned char** buffer;
     
     ~world();
@@ -0,0 +1,380 @@
+/* writer.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Background thread for flat file and movie output
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+#include "writer.h"
+#include "world.h"
+#include "lodepng.h"
+
+// Rank 0 writes the flat file and the movie frames. Formatting thousands of rows and compressing a 2160x1080 PNG
+// every timestep used to happen in the main loop - in doMessage for the frames - so every other rank waited for it
+// at the next collective. Now the main loop copies what is to be written into a job (claim/submit) and carries on,
+// and a dedicated thread formats, compresses and writes it.
+//
+// There are two job slots, used in turn, so jobs are written in the order they were submitted. If both are still
+// busy when the next timestep's output is ready, claim() waits for one: that is counted and reported, as it means
+// output is slower than the simulation. /syncout writes everything in the main loop, as before.
+//
+// The same rows can also go to a binary columnar file (/ffbin:file, see flatbin.h), with or without the text one.
+// Its timestep and unit index is kept in memory as blocks are written - the unit index as runs of consecutive
+// blocks, which is small as a unit with any cases tends to appear every timestep - and written by finish().
+//
+// Frames are encoded with frameEncoder (pngframe.cpp): palette made once, strips of rows deflated on png_threads
+// (/pngthreads:, default 1, async only) threads - or saved as run-length files (/moviefmt:rle) to be made into PNGs after the run.
+//
+// On the last rank the same thread does the database logging. Rows are held back across timesteps until there are
+// db_flush_rows (/dbbatch:) of them, then inserted with parameter arrays (DBOps::InsertRecords) and committed
+// once - so the main loop never waits on a database round trip.
+
+outputWriter::outputWriter(world* w, bool _async) {
+  async=_async;
+  ff=w->ff;
+  fb=w->fb;
+  no_place_types=w->P->no_place_types;
+  mv_path=w->mv_path;
+  mv_file=w->mv_file;
+  movie_rle=w->movie_rle;
+  png_threads=(async)?w->png_threads:1;          // In the main loop, encodePNG's team would be nested - one thread
+  frames=((w->log_movie) && (w->mpi_rank==0))?new frameEncoder(PNG_WIDTH,PNG_HEIGHT,png_threads):NULL;
+  frame_time=0;
+  frame_time_max=0;
+  frame_bytes=0;
+  row_width=9+(2*no_place_types);
+  for (int i=0; i<WRITER_SLOTS; i++) {
+    slots[i].kind=0;
+    slots[i].no_rows=0;
+    slots[i].max_rows=0;
+    slots[i].rows=NULL;
+    slots[i].frame=0;
+    slots[i].image=NULL;
+  }
+  fill_at=0;
+  write_at=0;
+  in_use=0;
+  queued=0;
+  stopping=false;
+  running=false;
+  for (int i=0; i<5; i++) jobs[i]=0;
+  ev=(w->events!=NULL)?w->events->f:NULL;
+  ev_events=0;
+  ev_raw=0;
+  ev_packed=0;
+  db=((w->log_db) && (w->mpi_rank==w->mpi_size-1))?w->db:NULL;
+  db_flush_rows=w->db_flush_rows;
+  db_pending_rows=0;
+  db_rows=0;
+  db_commits=0;
+  db_time=0;
+  db_failed=false;
+  waits=0;
+  wait_time=0;
+  no_units=w->no_units;
+  fb_at=0;
+  fb_column=NULL;
+  fb_column_size=0;
+  fb_unit_runs=NULL;
+  fb_indexed=false;
+  if (fb!=NULL) {
+    fb_unit_runs = new std::vector<flatbinRun>[no_units];
+    flatbinHeader h;
+    memset(&h,0,sizeof(h));
+    memcpy(h.magic,FLATBIN_MAGIC,8);
+    h.version=FLATBIN_VERSION;
+    h.no_place_types=no_place_types;
+    h.no_columns=flatbinColumns(no_place_types);
+    h.no_units=no_units;
+    putBinary(&h,sizeof(h));
+  }
+  pthread_mutex_init(&lock,NULL);
+  pthread_cond_init(&slot_free,NULL);
+  pthread_cond_init(&job_ready,NULL);
+  if (async) {
+    if (pthread_create(&thread,NULL,run,this)==0) running=true;
+    else {
+      printf("%d: Couldn't start the output writer thread - writing output in the main loop\n",w->mpi_rank);
+      fflush(stdout);
+      async=false;
+    }
+  }
+}
+
+outputWriter::~outputWriter() {
+  finish();
+  for (int i=0; i<WRITER_SLOTS; i++) {
+    delete[] slots[i].rows;
+    delete[] slots[i].image;
+  }
+  delete[] fb_column;
+  delete[] fb_unit_runs;
+  delete frames;
+  pthread_cond_destroy(&job_ready);
+  pthread_cond_destroy(&slot_free);
+  pthread_mutex_destroy(&lock);
+}
+
+writerJob* outputWriter::claim(int kind) {
+  pthread_mutex_lock(&lock);
+  if (in_use==WRITER_SLOTS) {
+    double t0=omp_get_wtime();
+    while (in_use==WRITER_SLOTS) pthread_cond_wait(&slot_free,&lock);
+    waits++;
+    wait_time+=omp_get_wtime()-t0;
+  }
+  writerJob* job = &slots[fill_at];
+  fill_at=(fill_at+1)%WRITER_SLOTS;
+  in_use++;
+  pthread_mutex_unlock(&lock);
+  job->kind=kind;
+  job->no_rows=0;
+  if ((kind==JOB_IMAGE) && (job->image==NULL)) job->image = new unsigned char[PNG_WIDTH*PNG_HEIGHT];
+  return job;
+}
+
+void outputWriter::submit(writerJob* job) {
+  if (!async) {
+    write(job);
+    pthread_mutex_lock(&lock);
+    write_at=(write_at+1)%WRITER_SLOTS;
+    in_use--;
+    pthread_mutex_unlock(&lock);
+    return;
+  }
+  pthread_mutex_lock(&lock);
+  queued++;
+  pthread_cond_signal(&job_ready);
+  pthread_mutex_unlock(&lock);
+}
+
+void outputWriter::finish() {
+  if (running) {
+    pthread_mutex_lock(&lock);
+    stopping=true;
+    pthread_cond_signal(&job_ready);
+    pthread_mutex_unlock(&lock);
+    pthread_join(thread,NULL);
+    running=false;
+  }
+  if ((fb!=NULL) && (!fb_indexed)) writeBinaryIndex();
+  if (db_pending_rows>0) flushDB();
+}
+
+void* outputWriter::run(void* arg) {
+  outputWriter* wr = (outputWriter*) arg;
+  while (true) {
+    pthread_mutex_lock(&wr->lock);
+    while ((wr->queued==0) && (!wr->stopping)) pthread_cond_wait(&wr->job_ready,&wr->lock);
+    if (wr->queued==0) {                  // Stopping, and nothing left
+      pthread_mutex_unlock(&wr->lock);
+      break;
+    }
+    writerJob* job = &wr->slots[wr->write_at];
+    pthread_mutex_unlock(&wr->lock);
+
+    wr->write(job);
+
+    pthread_mutex_lock(&wr->lock);
+    wr->write_at=(wr->write_at+1)%WRITER_SLOTS;
+    wr->queued--;
+    wr->in_use--;
+    pthread_cond_signal(&wr->slot_free);
+    pthread_mutex_unlock(&wr->lock);
+  }
+  return NULL;
+}
+
+void outputWriter::write(writerJob* job) {
+  jobs[job->kind]++;
+  if ((job->kind==JOB_DB) && (db!=NULL) && (!db_failed)) {
+    db_pending.insert(db_pending.end(),job->rows,job->rows+(job->no_rows*row_width));
+    db_pending_rows+=job->no_rows;
+    if (db_pending_rows>=db_flush_rows) flushDB();
+  }
+  if ((job->kind==JOB_EVENTS) && (ev!=NULL)) writeEvents(job);
+  if ((job->kind==JOB_FLAT) && (fb!=NULL)) writeBinary(job);
+  if ((job->kind==JOB_FLAT) && (ff!=NULL)) {
+    for (int r=0; r<job->no_rows; r++) {
+      int* row = &job->rows[r*row_width];
+      fprintf(ff,"%d\t%d\t%d\t%d\t%d\t",row[0],row[1],row[2],row[3],row[4]);
+      int j=5;
+      for (unsigned int k=0; k<no_place_types; k++) fprintf(ff,"%d\t",row[j++]);
+      fprintf(ff,"%d\t%d\t",row[j],row[j+1]);
+      j+=2;
+      for (unsigned int k=0; k<no_place_types; k++) fprintf(ff,"%d\t",row[j++]);
+      fprintf(ff,"%d\t%d\n",row[j],row[j+1]);
+    }
+    fflush(ff);
+
+  } else if (job->kind==JOB_IMAGE) {
+    string filename;
+    filename.append(mv_path);
+    filename.append("/");
+    filename.append(mv_file);
+    std::stringstream noConverter;
+    int no = job->frame;
+    if (no<1000) filename.append("0");
+    if (no<100) filename.append("0");
+    if (no<10) filename.append("0");
+    noConverter << (no);
+    filename.append(noConverter.str());
+    filename.append(movie_rle?".rle":".png");
+
+    double t0=omp_get_wtime();                  // Palette and tables are made once - see pngframe.cpp
+    if (movie_rle) frames->encodeRLE(job->image,frame_buffer);
+    else frames->encodePNG(job->image,frame_buffer);
+    double t=omp_get_wtime()-t0;
+    frame_time+=t;
+    if (t>frame_time_max) frame_time_max=t;
+    frame_bytes+=frame_buffer.size();
+
+    FILE* f = fopen(filename.c_str(),"wb");
+    if (f==NULL) {
+      printf("Couldn't write movie frame %s\n",filename.c_str());
+      fflush(stdout);
+    } else {
+      fwrite(&frame_buffer[0],1,frame_buffer.size(),f);
+      fclose(f);
+    }
+  }
+}
+
+void outputWriter::putBinary(const void* data, long long bytes) {
+  fwrite(data,1,bytes,fb);
+  fb_at+=bytes;
+}
+
+void outputWriter::writeBinary(writerJob* job) {
+  if (job->no_rows==0) return;
+  int b = (int) fb_steps.size();
+  flatbinStep step;
+  step.T=job->rows[0];
+  step.no_rows=job->no_rows;
+  step.offset=fb_at;
+  fb_steps.push_back(step);
+  flatbinBlock block;
+  block.T=step.T;
+  block.no_rows=job->no_rows;
+  putBinary(&block,sizeof(block));
+
+  if (fb_column_size<job->no_rows) {
+    delete[] fb_column;
+    fb_column_size=job->max_rows;
+    fb_column = new int[fb_column_size];
+  }
+  int no_columns=flatbinColumns(no_place_types);
+  for (int c=0; c<no_columns; c++) {              // Row fields after T, in order, are the columns
+    for (int r=0; r<job->no_rows; r++) fb_column[r]=job->rows[(r*row_width)+1+c];
+    putBinary(fb_column,(long long) job->no_rows*sizeof(int));
+  }
+  fflush(fb);
+
+  for (int r=0; r<job->no_rows; r++) {
+    int u = job->rows[(r*row_width)+1];
+    std::vector<flatbinRun>& runs = fb_unit_runs[u];
+    if ((runs.size()>0) && (runs.back().first_block+runs.back().no_blocks==b)) runs.back().no_blocks++;
+    else {
+      flatbinRun run;
+      run.first_block=b;
+      run.no_blocks=1;
+      runs.push_back(run);
+    }
+  }
+}
+
+void outputWriter::writeBinaryIndex() {
+  flatbinTrailer t;
+  memset(&t,0,sizeof(t));
+  long long pad=(8-(fb_at%8))%8;
+  if (pad>0) {
+    char zero[8]={0,0,0,0,0,0,0,0};
+    putBinary(zero,pad);
+  }
+  t.steps_at=fb_at;
+  t.no_blocks=(int) fb_steps.size();
+  if (t.no_blocks>0) putBinary(&fb_steps[0],(long long) t.no_blocks*sizeof(flatbinStep));
+
+  t.run_start_at=fb_at;
+  int start=0;
+  for (int u=0; u<no_units; u++) {
+    putBinary(&start,sizeof(int));
+    start+=(int) fb_unit_runs[u].size();
+  }
+  putBinary(&start,sizeof(int));
+  t.no_runs=start;
+
+  t.runs_at=fb_at;
+  for (int u=0; u<no_units; u++)
+    if (fb_unit_runs[u].size()>0) putBinary(&fb_unit_runs[u][0],(long long) fb_unit_runs[u].size()*sizeof(flatbinRun));
+  memcpy(t.magic,FLATBIN_END,8);
+  putBinary(&t,sizeof(t));
+  fflush(fb);
+  fb_indexed=true;
+}
+
+void outputWriter::flushDB() {
+  double t0=omp_get_wtime();
+  try {
+    db->InsertRecords(&db_pending[0],db_pending_rows);
+    db->CommitInsChanges();
+    db_rows+=db_pending_rows;
+    db_commits++;
+  }
+  catch (int Error) {
+    cerr << "Error " << Error << " writing to the database - no more database output\n";
+    db_failed=true;
+  }
+  db_time+=omp_get_wtime()-t0;
+  db_pending.clear();
+  db_pending_rows=0;
+}
+
+void outputWriter::writeEvents(writerJob* job) {
+  int n = (int) job->events.size();
+  ev_columns.resize(n*sizeof(transmissionEvent));
+  unsigned char* p = &ev_columns[0];
+  #define EVENT_COLUMN(field) for (int i=0; i<n; i++) { memcpy(p,&job->events[i].field,sizeof(job->events[i].field)); p+=sizeof(job->events[i].field); }
+  EVENT_COLUMN(infector)
+  EVENT_COLUMN(infectee)
+  EVENT_COLUMN(t)
+  EVENT_COLUMN(unit)
+  EVENT_COLUMN(setting)
+  EVENT_COLUMN(place_type)
+  EVENT_COLUMN(infector_node)
+  #undef EVENT_COLUMN
+  ev_columns.resize(p-&ev_columns[0]);
+  job->events.clear();
+
+  vector<unsigned char> packed;
+  LodeZlib::compress(packed,ev_columns);
+  int head[4] = {n,(int) ev_columns.size(),(int) packed.size(),0};
+  fwrite(head,sizeof(int),4,ev);
+  fwrite(&packed[0],1,packed.size(),ev);
+  fflush(ev);
+  ev_events+=n;
+  ev_raw+=ev_columns.size();
+  ev_packed+=packed.size();
+}
+
+void outputWriter::report(world* w) {
+  printf("%d: Output writer (%s): %d flat file steps, %d frames written",w->mpi_rank,async?"background thread":"/syncout",jobs[JOB_FLAT],jobs[JOB_IMAGE]);
+  if (jobs[JOB_IMAGE]>0) printf(" (%s, %.1f ms and %.0f KB each)",movie_rle?"RLE":"PNG",1000.0*frame_time/jobs[JOB_IMAGE],frame_bytes/(1024.0*jobs[JOB_IMAGE]));
+  if (db!=NULL) printf(", %lld database rows in %d commits (%.0f rows/s)",db_rows,db_commits,(db_time>0)?db_rows/db_time:0.0);
+  if (ev!=NULL) printf(", %lld transmission events (%.1f MB, %.1f MB compressed)",ev_events,ev_raw/1048576.0,ev_packed/1048576.0);
+  if (fb!=NULL) printf(", binary flat file %.1f MB (%d blocks)",fb_at/1048576.0,(int) fb_steps.size());
+  if (waits>0) printf(" - BEHIND: the main loop waited %d times, %.3f s in total, for output to be written",waits,wait_time);
+  printf("\n");
+  fflush(stdout);
+}
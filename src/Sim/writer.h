@@ -0,0 +1,127 @@
+/* writer.h, part of the Global Epidemic Simulation v1.0 BETA
+/* Background thread for flat file and movie output
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include <vector>
+#define FLATBIN_FORMAT_ONLY
+#include "flatbin.h"
+#include "eventlog.h"
+#include "pngframe.h"
+
+#define WRITER_SLOTS 2      // Double-buffered: the main loop fills one job while the writer thread writes the other
+#define JOB_FLAT 1          // Flat file rows for one timestep
+#define JOB_IMAGE 2         // One movie frame
+#define JOB_DB 3            // Database rows for one timestep
+#define JOB_EVENTS 4        // A chunk of the transmission event log
+
+class world;
+class DBOps;
+
+struct writerJob {
+  int kind;
+  int no_rows;
+  int max_rows;
+  int* rows;                // no_rows x row_width ints - T, unit, then the fields in flat file (or, JOB_DB, table) order
+  int frame;                // JOB_IMAGE: frame number, for the file name
+  unsigned char* image;     // JOB_IMAGE: PNG_WIDTH*PNG_HEIGHT palette indices
+  std::vector<transmissionEvent> events;    // JOB_EVENTS
+};
+
+class outputWriter {
+  public:
+    outputWriter(world* w, bool _async);
+    ~outputWriter();
+    writerJob* claim(int kind);   // A free job to fill. Waits if the writer thread has fallen behind.
+    void submit(writerJob* job);  // Hand it over. (If not async, it is written here and now.)
+    void finish();                // Write everything submitted, then stop the thread (and index the binary flat file,
+                                  // and insert any database rows still held back)
+    void report(world* w);
+    int noJobs(int kind) { return jobs[kind]; }
+
+    int row_width;
+    bool async;
+
+    double frame_time;        // Movie frames: seconds spent encoding (PNG or RLE), in total and the slowest frame
+    double frame_time_max;
+    long long frame_bytes;
+    bool movie_rle;
+    int png_threads;
+
+  private:
+    void write(writerJob* job);
+    void writeBinary(writerJob* job);
+    void writeBinaryIndex();
+    void putBinary(const void* data, long long bytes);
+    void flushDB();
+    void writeEvents(writerJob* job);
+    static void* run(void* arg);
+
+    FILE* ff;                 // Text flat file, or NULL if only the binary one was asked for
+    FILE* fb;                 // Binary flat file (/ffbin:) or NULL - see flatbin.h
+    unsigned int no_place_types;
+    char* mv_path;
+    char* mv_file;
+    frameEncoder* frames;     // Rank 0, when there's a movie
+    std::vector<unsigned char> frame_buffer;
+
+    writerJob slots[WRITER_SLOTS];
+    int fill_at;              // Next slot the main loop fills
+    int write_at;             // Next slot the writer thread writes
+    int in_use;               // Slots claimed, queued or being written
+    int queued;               // Slots submitted and not yet written
+    bool stopping;
+    bool running;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t slot_free;
+    pthread_cond_t job_ready;
+
+    int no_units;
+    long long fb_at;                            // Bytes written to fb so far
+    int* fb_column;                             // One column of a block, transposed from the job's rows
+    int fb_column_size;
+    std::vector<flatbinStep> fb_steps;          // Timestep index, built as blocks are written
+    std::vector<flatbinRun>* fb_unit_runs;      // Unit index - [no_units]
+    bool fb_indexed;
+
+    DBOps* db;                                  // Last rank only, when logging to the database
+    int db_flush_rows;                          // Rows held back across timesteps before they are inserted and committed
+    std::vector<int> db_pending;                // ...those rows
+    int db_pending_rows;
+    long long db_rows;
+    int db_commits;
+    double db_time;
+    bool db_failed;
+
+    FILE* ev;                                   // Transmission event log (/events:), this rank's file - see eventlog.cpp
+    long long ev_events;
+    long long ev_raw;
+    long long ev_packed;
+    std::vector<unsigned char> ev_columns;
+
+    int jobs[5];              // Jobs written, by kind
+    int waits;                // Times the main loop had to wait for a free slot
+    double wait_time;         // ...and for how long in total (s)
+};
+
+#endif
@@ -0,0 +1 @@
+g++ -Wall -O2 -ostatequiv statequiv.cpp
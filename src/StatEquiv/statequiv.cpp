@@ -0,0 +1,537 @@
+/* statequiv.cpp, part of the Global Epidemic Simulation v1.0 BETA
+/* Standalone tool comparing two sets of simulation runs for statistical equivalence
+/*
+/* Copyright 2012, MRC Centre for Outbreak Analysis and Modelling
+/* 
+/* Licensed under the Apache License, Version 2.0 (the "License");
+/* you may not use this file except in compliance with the License.
+/* You may obtain a copy of the License at
+/*
+/*       http://www.apache.org/licenses/LICENSE-2.0
+/*
+/* Unless required by applicable law or agreed to in writing, software
+/* distributed under the License is distributed on an "AS IS" BASIS,
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/* See the License for the specific language governing permissions and
+/* limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <map>
+#include <string>
+#include <algorithm>
+
+#ifndef _WIN32
+  #define strnicmp strncasecmp
+#endif
+
+// Performance changes that alter the random stream cannot be checked bit-for-bit against old output. Instead, run the
+// baseline and candidate simulators many times with different seeds (see bin-linux/Sim/equivalence.sh), and check
+// that the distributions of the outputs below are indistinguishable, with two-sample Kolmogorov-Smirnov and
+// Mann-Whitney tests and a Holm-Bonferroni correction across all tests.
+//
+//   statequiv <baseline dir> <candidate dir> <runs> [/alpha:0.05] [/minunit:N] [/perms:999]
+//
+// Reads <dir>/run_1.txt ... <dir>/run_<runs>.txt (flat file output). Per run it measures:-
+//
+//   final_size     Total infections
+//   peak_day       Day with most new infections
+//   hh_share       Proportion of infections that happened in households. (The flat file has no household
+//                  denominators, so this stands in for the household secondary attack rate.)
+//   unit_size:u    Total infections in unit u
+//   unit_peak:u    Peak day in unit u
+//
+// Units are only tested if they had infections in at least /minunit: runs (default half) of both sets.
+//
+// The whole epidemic curve is also tested, timestep by timestep (curve_band): at each timestep, the gap between the
+// two sets' mean cumulative infections is divided by its standard error (Welch), and the statistic is the largest
+// gap over all timesteps. Its p-value comes from /perms: random relabellings of the runs, so it allows for the
+// timesteps being correlated, and it adds one p-value to the Holm family rather than one per timestep. Passing
+// means the candidate's mean curve stays inside the baseline's simultaneous band at every timestep.
+//
+// Exit code is 0 if every test passes, 1 if any fails, 2 on error.
+//
+//   statequiv /params <params.bin> <new params.bin> <seed1> <seed2> <flat file dir> <flat file name>
+//
+// Copies a parameter file with the two random seeds replaced, flat file output on and written to
+// <flat file dir>/<flat file name>.txt, and database and movie output off. equivalence.sh uses this to seed and
+// collect each run through the parameter file, which any version of the simulator reads the same way.
+
+struct runSummary {
+  double final_size;
+  double peak_day;
+  double hh_share;
+  std::map<int,double> unit_size;
+  std::map<int,double> unit_peak;
+  std::map<int,double> step_infs;                            // New infections by timestep (T, hours)
+};
+
+struct testResult {
+  std::string metric;
+  double mean_a;
+  double mean_b;
+  double ks_d;                                               // For curve_band, the largest standardised gap
+  double ks_p;                                               // For curve_band, the permutation p-value
+  double mw_p;                                               // -1 for curve_band (one p-value only)
+  bool reject;
+};
+
+int loadRun(const char* file, runSummary* r) {
+  FILE* f = fopen(file,"r");
+  if (f==NULL) {
+    printf("Couldn't open %s\n",file);
+    return 1;
+  }
+  std::map<int,double> daily;                                // Total new infections by day
+  std::map<int,std::map<int,double> > unit_daily;            // New infections by unit, by day
+  double hh=0;
+  r->final_size=0;
+  char line[4096];
+  while (fgets(line,4096,f)!=NULL) {
+    std::vector<double> cols;
+    char* tok = strtok(line,"\t\r\n");
+    while (tok!=NULL) {
+      cols.push_back(atof(tok));
+      tok = strtok(NULL,"\t\r\n");
+    }
+    if (cols.size()<9) continue;
+    int no_place_types = ((int) cols.size()-9)/2;          // T,unit,makers,comm_cases,hh_cases,[place_cases],comm_infs,hh_infs,[place_infs],sympt,nonsympt
+    int day = ((int) cols[0])/24;
+    int unit = (int) cols[1];
+    int base = 5+no_place_types;
+    double infs = cols[base]+cols[base+1];
+    for (int k=0; k<no_place_types; k++) infs+=cols[base+2+k];
+    hh+=cols[base+1];
+    r->final_size+=infs;
+    r->step_infs[(int) cols[0]]+=infs;
+    daily[day]+=infs;
+    unit_daily[unit][day]+=infs;
+  }
+  fclose(f);
+  r->hh_share = (r->final_size>0)?hh/r->final_size:0;
+  r->peak_day=0;
+  double best=-1;
+  for (std::map<int,double>::iterator it=daily.begin(); it!=daily.end(); it++) {
+    if (it->second>best) {
+      best=it->second;
+      r->peak_day=it->first;
+    }
+  }
+  for (std::map<int,std::map<int,double> >::iterator u=unit_daily.begin(); u!=unit_daily.end(); u++) {
+    double total=0;
+    double ubest=-1;
+    double upeak=0;
+    for (std::map<int,double>::iterator it=u->second.begin(); it!=u->second.end(); it++) {
+      total+=it->second;
+      if (it->second>ubest) {
+        ubest=it->second;
+        upeak=it->first;
+      }
+    }
+    if (total>0) {
+      r->unit_size[u->first]=total;
+      r->unit_peak[u->first]=upeak;
+    }
+  }
+  return 0;
+}
+
+double ksProb(double lambda) {                               // Kolmogorov distribution tail, Q_KS(lambda)
+  double sum=0;
+  double sign=1;
+  double prev=0;
+  for (int j=1; j<=100; j++) {
+    double term = sign*2.0*exp(-2.0*j*j*lambda*lambda);
+    sum+=term;
+    if ((fabs(term)<=0.001*prev) || (fabs(term)<=1e-8*sum)) return sum;
+    sign=-sign;
+    prev=fabs(term);
+  }
+  return 1.0;                                                // Failed to converge - only happens as lambda->0
+}
+
+int ksTest(std::vector<double> a, std::vector<double> b, double* d, double* p) {
+  if ((a.size()==0) || (b.size()==0)) {                      // No distribution to compare
+    printf("ERROR - empty sample (%d and %d values) in Kolmogorov-Smirnov test\n",(int) a.size(),(int) b.size());
+    return 1;
+  }
+  std::sort(a.begin(),a.end());
+  std::sort(b.begin(),b.end());
+  const double na = (double) a.size();
+  const double nb = (double) b.size();
+  size_t i=0;
+  size_t j=0;
+  *d=0;
+  while ((i<a.size()) && (j<b.size())) {
+    double x = (a[i]<=b[j])?a[i]:b[j];
+    while ((i<a.size()) && (a[i]<=x)) i++;                   // Step past ties on both sides together
+    while ((j<b.size()) && (b[j]<=x)) j++;
+    double diff = fabs((i/na)-(j/nb));
+    if (diff>*d) *d=diff;
+  }
+  double ne = sqrt((na*nb)/(na+nb));
+  *p = ksProb((ne+0.12+(0.11/ne))*(*d));
+  if (*p>1) *p=1;
+  return 0;
+}
+
+double mwTest(const std::vector<double>& a, const std::vector<double>& b) {
+  // Mann-Whitney U, normal approximation with tie correction. Returns two-sided p.
+  std::vector<std::pair<double,int> > all;
+  for (size_t i=0; i<a.size(); i++) all.push_back(std::make_pair(a[i],0));
+  for (size_t i=0; i<b.size(); i++) all.push_back(std::make_pair(b[i],1));
+  std::sort(all.begin(),all.end());
+  const double n = (double) all.size();
+  const double na = (double) a.size();
+  const double nb = (double) b.size();
+  double rank_a=0;
+  double ties=0;
+  size_t i=0;
+  while (i<all.size()) {
+    size_t j=i;
+    while ((j<all.size()) && (all[j].first==all[i].first)) j++;
+    double t = (double) (j-i);
+    double avg_rank = (i+j+1)/2.0;                           // Ranks are 1-based: mean of i+1..j
+    for (size_t k=i; k<j; k++) if (all[k].second==0) rank_a+=avg_rank;
+    ties+=(t*t*t)-t;
+    i=j;
+  }
+  double u = rank_a-(na*(na+1)/2.0);
+  double var = (na*nb/12.0)*((n+1)-(ties/(n*(n-1))));
+  if (var<=0) return 1.0;
+  double z = (u-(na*nb/2.0))/sqrt(var);
+  return erfc(fabs(z)/sqrt(2.0));
+}
+
+double mean(const std::vector<double>& v) {
+  double s=0;
+  for (size_t i=0; i<v.size(); i++) s+=v[i];
+  return (v.size()>0)?s/v.size():0;
+}
+
+int addTest(std::vector<testResult>& tests, std::string metric, const std::vector<double>& a, const std::vector<double>& b) {
+  testResult t;
+  t.metric=metric;
+  t.mean_a=mean(a);
+  t.mean_b=mean(b);
+  if (ksTest(a,b,&t.ks_d,&t.ks_p)!=0) {
+    printf("ERROR - can't test %s\n",metric.c_str());
+    return 1;
+  }
+  t.mw_p=mwTest(a,b);
+  t.reject=false;
+  tests.push_back(t);
+  return 0;
+}
+
+double maxGap(const std::vector<std::vector<double> >& curves, const std::vector<int>& label, int* at) {
+  // Largest Welch-standardised gap between the mean curves of the runs labelled 0 and those labelled 1.
+  double worst=0;
+  for (size_t k=0; k<curves[0].size(); k++) {
+    double s[2]={0,0}, ss[2]={0,0}, n[2]={0,0};
+    for (size_t i=0; i<curves.size(); i++) {
+      s[label[i]]+=curves[i][k];
+      ss[label[i]]+=curves[i][k]*curves[i][k];
+      n[label[i]]++;
+    }
+    double m0=s[0]/n[0];
+    double m1=s[1]/n[1];
+    double v0=(n[0]>1)?std::max(0.0,(ss[0]-(n[0]*m0*m0))/(n[0]-1)):0;
+    double v1=(n[1]>1)?std::max(0.0,(ss[1]-(n[1]*m1*m1))/(n[1]-1)):0;
+    double se=sqrt((v0/n[0])+(v1/n[1]));
+    double gap;
+    if (se>0) gap=fabs(m0-m1)/se;
+    else gap=(m0==m1)?0:HUGE_VAL;                            // Both sets constant here - any difference is decisive
+    if (gap>worst) {
+      worst=gap;
+      *at=(int) k;
+    }
+  }
+  return worst;
+}
+
+int curveTest(std::vector<testResult>& tests, const std::vector<runSummary>* sets, int runs, int perms, int* worst_T) {
+  // curve_band - see the top of this file. Runs that stopped early keep their final total for the later timesteps.
+  std::map<int,int> step_index;
+  for (int s=0; s<2; s++)
+    for (int i=0; i<runs; i++)
+      for (std::map<int,double>::const_iterator it=sets[s][i].step_infs.begin(); it!=sets[s][i].step_infs.end(); it++)
+        step_index[it->first]=0;
+  if (step_index.size()==0) {
+    printf("ERROR - no timesteps in the flat files\n");
+    return 1;
+  }
+  std::vector<int> step_T;
+  for (std::map<int,int>::iterator it=step_index.begin(); it!=step_index.end(); it++) {
+    it->second=(int) step_T.size();
+    step_T.push_back(it->first);
+  }
+  std::vector<std::vector<double> > curves;
+  std::vector<int> label;
+  for (int s=0; s<2; s++) {
+    for (int i=0; i<runs; i++) {
+      std::vector<double> c(step_T.size(),0);
+      for (std::map<int,double>::const_iterator it=sets[s][i].step_infs.begin(); it!=sets[s][i].step_infs.end(); it++)
+        c[step_index[it->first]]+=it->second;
+      for (size_t k=1; k<c.size(); k++) c[k]+=c[k-1];
+      curves.push_back(c);
+      label.push_back(s);
+    }
+  }
+  int at=0;
+  testResult t;
+  t.metric="curve_band";
+  t.ks_d=maxGap(curves,label,&at);
+  *worst_T=step_T[at];
+  std::vector<double> a,b;
+  for (size_t i=0; i<curves.size(); i++) {
+    if (label[i]==0) a.push_back(curves[i][at]);
+    else b.push_back(curves[i][at]);
+  }
+  t.mean_a=mean(a);                                          // Means at the timestep with the largest gap
+  t.mean_b=mean(b);
+
+  unsigned int rnd=12345;                                    // Fixed seed, so the report is reproducible
+  int as_extreme=0;
+  std::vector<int> perm=label;
+  for (int p=0; p<perms; p++) {
+    for (int i=(int) perm.size()-1; i>0; i--) {              // Fisher-Yates shuffle of the set labels
+      rnd=(rnd*1103515245u)+12345u;
+      int j=(int) ((rnd>>8)%(unsigned int) (i+1));
+      std::swap(perm[i],perm[j]);
+    }
+    int dummy;
+    if (maxGap(curves,perm,&dummy)>=t.ks_d) as_extreme++;
+  }
+  t.ks_p=(as_extreme+1.0)/(perms+1.0);
+  t.mw_p=-1;
+  t.reject=false;
+  tests.push_back(t);
+  return 0;
+}
+
+int readInt(const std::vector<unsigned char>& buf, size_t* pos, int* v) {
+  if (*pos+4>buf.size()) return 1;
+  memcpy(v,&buf[*pos],4);
+  *pos+=4;
+  return 0;
+}
+
+int skipBytes(const std::vector<unsigned char>& buf, size_t* pos, long n) {
+  if ((n<0) || (*pos+n>buf.size())) return 1;
+  *pos+=n;
+  return 0;
+}
+
+int skipOutput(const std::vector<unsigned char>& buf, size_t* pos) {   // On/off flag, then two strings if on
+  int flag,len;
+  if (readInt(buf,pos,&flag)!=0) return 1;
+  if (flag!=1) return 0;
+  for (int i=0; i<2; i++) {
+    if (readInt(buf,pos,&len)!=0) return 1;
+    if (skipBytes(buf,pos,len)!=0) return 1;
+  }
+  return 0;
+}
+
+void putInt(std::vector<unsigned char>& buf, int v) {
+  unsigned char b[4];
+  memcpy(b,&v,4);
+  buf.insert(buf.end(),b,b+4);
+}
+
+void putString(std::vector<unsigned char>& buf, const char* s) {
+  putInt(buf,(int) strlen(s));
+  buf.insert(buf.end(),s,s+strlen(s));
+}
+
+int setParams(const char* in_file, const char* out_file, int seed1, int seed2, const char* ff_path, const char* ff_file) {
+  // statequiv /params - see the top of this file. Walks params.bin in the order loadBinaryInitFile reads it.
+  FILE* f = fopen(in_file,"rb");
+  if (f==NULL) {
+    printf("Couldn't open %s\n",in_file);
+    return 2;
+  }
+  std::vector<unsigned char> buf;
+  unsigned char chunk[65536];
+  size_t got;
+  while ((got=fread(chunk,1,sizeof(chunk),f))>0) buf.insert(buf.end(),chunk,chunk+got);
+  fclose(f);
+
+  size_t pos=0;
+  int v,res,no_place_types,n;
+  bool bad=false;
+  bad|=(readInt(buf,&pos,&no_place_types)!=0);
+  bad|=(readInt(buf,&pos,&v)!=0);                            // Latent period: fixed, or mean, ICDF and cutoff
+  if ((!bad) && (v==1)) bad|=(skipBytes(buf,&pos,8)!=0);
+  else if (!bad) bad|=((readInt(buf,&pos,&res)!=0) || (skipBytes(buf,&pos,8+(res*8L)+8)!=0));
+  bad|=(readInt(buf,&pos,&v)!=0);                            // Infectiousness: fixed, or profile
+  if ((!bad) && (v==1)) bad|=(skipBytes(buf,&pos,8)!=0);
+  else if (!bad) bad|=((readInt(buf,&pos,&res)!=0) || (skipBytes(buf,&pos,res*8L)!=0));
+  bad|=(readInt(buf,&pos,&v)!=0);                            // Infectious period: fixed, or mean, ICDF and cutoff
+  if ((!bad) && (v==1)) bad|=(skipBytes(buf,&pos,8)!=0);
+  else if (!bad) bad|=((skipBytes(buf,&pos,8)!=0) || (readInt(buf,&pos,&res)!=0) || (skipBytes(buf,&pos,(res*8L)+8)!=0));
+
+  const int sub_type_bytes[8] = { 16, 24, 64, 40, 48, 44, 16, 32 };   // Per intervention type
+  bad|=(readInt(buf,&pos,&n)!=0);
+  for (int i=0; (!bad) && (i<n); i++) {
+    int type,trig;
+    bad|=(readInt(buf,&pos,&type)!=0);
+    for (int on_off=0; (!bad) && (on_off<2); on_off++) {
+      bad|=(readInt(buf,&pos,&trig)!=0);
+      if ((!bad) && (trig==1)) bad|=(skipBytes(buf,&pos,8)!=0);
+      else if ((!bad) && (trig==0)) bad|=(skipBytes(buf,&pos,28)!=0);
+    }
+    if ((!bad) && (type>=0) && (type<8)) bad|=(skipBytes(buf,&pos,sub_type_bytes[type])!=0);
+  }
+
+  bad|=(readInt(buf,&pos,&n)!=0);                            // Units
+  for (int i=0; (!bad) && (i<n); i++) {
+    int level,no_interventions;
+    bad|=((readInt(buf,&pos,&level)!=0) || (skipBytes(buf,&pos,4)!=0));
+    if ((!bad) && (level>0)) bad|=(skipBytes(buf,&pos,4)!=0);
+    bad|=((!bad) && (skipBytes(buf,&pos,40+(no_place_types*48L)+72)!=0));
+    bad|=((!bad) && (readInt(buf,&pos,&no_interventions)!=0));
+    bad|=((!bad) && (skipBytes(buf,&pos,(no_interventions*4L)+4)!=0));
+  }
+  const size_t seed_at=pos;
+  bad|=((!bad) && (skipBytes(buf,&pos,8)!=0));
+  bad|=((!bad) && ((readInt(buf,&pos,&n)!=0) || (skipBytes(buf,&pos,n*28L)!=0)));    // Seed infections
+  bad|=((!bad) && ((readInt(buf,&pos,&n)!=0) || (skipBytes(buf,&pos,n*16L)!=0)));    // Age bands
+  const size_t output_at=pos;
+  for (int i=0; (!bad) && (i<3); i++) bad|=(skipOutput(buf,&pos)!=0);               // Database, flat file, movie
+  if (bad) {
+    printf("ERROR - %s ended early, at byte %d - not a parameter file?\n",in_file,(int) pos);
+    return 2;
+  }
+
+  std::vector<unsigned char> out(buf.begin(),buf.begin()+seed_at);
+  putInt(out,seed1);
+  putInt(out,seed2);
+  out.insert(out.end(),buf.begin()+seed_at+8,buf.begin()+output_at);
+  putInt(out,0);                                             // No database
+  putInt(out,1);                                             // Flat file
+  putString(out,ff_path);
+  putString(out,ff_file);
+  putInt(out,0);                                             // No movie
+  out.insert(out.end(),buf.begin()+pos,buf.end());
+
+  f = fopen(out_file,"wb");
+  if (f==NULL) {
+    printf("Couldn't open %s\n",out_file);
+    return 2;
+  }
+  if (fwrite(&out[0],1,out.size(),f)!=out.size()) {
+    printf("ERROR - couldn't write %s\n",out_file);
+    fclose(f);
+    return 2;
+  }
+  fclose(f);
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  double alpha=0.05;
+  int min_unit=-1;
+  int perms=999;
+  if ((argc>1) && (strnicmp("/params",argv[1],7)==0)) {
+    if (argc<8) {
+      printf("Usage: statequiv /params <params.bin> <new params.bin> <seed1> <seed2> <flat file dir> <flat file name>\n");
+      return 2;
+    }
+    return setParams(argv[2],argv[3],atoi(argv[4]),atoi(argv[5]),argv[6],argv[7]);
+  }
+  if (argc<4) {
+    printf("Usage: statequiv <baseline dir> <candidate dir> <runs> [/alpha:0.05] [/minunit:N] [/perms:999]\n");
+    return 2;
+  }
+  int runs=atoi(argv[3]);
+  for (int i=4; i<argc; i++) {
+    if (strnicmp("/alpha:",argv[i],7)==0) sscanf(argv[i]+7,"%lf",&alpha);
+    else if (strnicmp("/minunit:",argv[i],9)==0) sscanf(argv[i]+9,"%d",&min_unit);
+    else if (strnicmp("/perms:",argv[i],7)==0) sscanf(argv[i]+7,"%d",&perms);
+  }
+  if (min_unit<0) min_unit=(runs+1)/2;
+  if (runs<2) {
+    printf("ERROR - need at least 2 runs per set\n");
+    return 2;
+  }
+
+  std::vector<runSummary> sets[2];
+  for (int s=0; s<2; s++) {
+    for (int i=1; i<=runs; i++) {
+      char file[4096];
+      sprintf(file,"%s/run_%d.txt",argv[1+s],i);
+      runSummary r;
+      if (loadRun(file,&r)!=0) return 2;
+      sets[s].push_back(r);
+    }
+  }
+
+  std::vector<testResult> tests;
+  std::vector<double> a,b;
+
+  #define COLLECT(field) a.clear(); b.clear(); \
+    for (int i=0; i<runs; i++) { a.push_back(sets[0][i].field); b.push_back(sets[1][i].field); }
+
+  COLLECT(final_size);  if (addTest(tests,"final_size",a,b)!=0) return 2;
+  COLLECT(peak_day);    if (addTest(tests,"peak_day",a,b)!=0) return 2;
+  COLLECT(hh_share);    if (addTest(tests,"hh_share",a,b)!=0) return 2;
+  int worst_T=0;
+  if (curveTest(tests,sets,runs,perms,&worst_T)!=0) return 2;
+
+  std::map<int,int> unit_runs[2];                            // How many runs had infections in each unit
+  for (int s=0; s<2; s++)
+    for (int i=0; i<runs; i++)
+      for (std::map<int,double>::iterator it=sets[s][i].unit_size.begin(); it!=sets[s][i].unit_size.end(); it++) unit_runs[s][it->first]++;
+
+  for (std::map<int,int>::iterator it=unit_runs[0].begin(); it!=unit_runs[0].end(); it++) {
+    int u=it->first;
+    if ((it->second<min_unit) || (unit_runs[1][u]<min_unit)) continue;
+    std::vector<double> sa,sb,pa,pb;
+    for (int i=0; i<runs; i++) {                             // Runs with no infections in the unit count as size 0.
+      sa.push_back(sets[0][i].unit_size.count(u)?sets[0][i].unit_size[u]:0);
+      sb.push_back(sets[1][i].unit_size.count(u)?sets[1][i].unit_size[u]:0);
+      if (sets[0][i].unit_peak.count(u)) pa.push_back(sets[0][i].unit_peak[u]);   // Peak only defined where there were infections
+      if (sets[1][i].unit_peak.count(u)) pb.push_back(sets[1][i].unit_peak[u]);
+    }
+    char name[64];
+    sprintf(name,"unit_size:%d",u);
+    if (addTest(tests,name,sa,sb)!=0) return 2;
+    sprintf(name,"unit_peak:%d",u);
+    if (addTest(tests,name,pa,pb)!=0) return 2;            // Empty if /minunit:0 let in a unit one set never reached
+  }
+
+  // Holm-Bonferroni over all p-values (two per metric, one for curve_band).
+
+  std::vector<std::pair<double,int> > ps;
+  for (size_t i=0; i<tests.size(); i++) {
+    ps.push_back(std::make_pair(tests[i].ks_p,(int) i));
+    if (tests[i].mw_p>=0) ps.push_back(std::make_pair(tests[i].mw_p,(int) i));
+  }
+  std::sort(ps.begin(),ps.end());
+  const int m = (int) ps.size();
+  for (int k=0; k<m; k++) {
+    if (ps[k].first>alpha/(m-k)) break;
+    tests[ps[k].second].reject=true;
+  }
+
+  int failures=0;
+  printf("Baseline: %s   Candidate: %s   Runs: %d   Family-wise alpha: %g (Holm, %d p-values)\n\n",argv[1],argv[2],runs,alpha,m);
+  printf("%-18s %14s %14s %8s %10s %10s  %s\n","metric","baseline_mean","candidate_mean","ks_D","ks_p","mw_p","result");
+  for (size_t i=0; i<tests.size(); i++) {
+    testResult* t=&tests[i];
+    if (t->mw_p>=0) printf("%-18s %14.4f %14.4f %8.4f %10.4g %10.4g  %s\n",t->metric.c_str(),t->mean_a,t->mean_b,t->ks_d,t->ks_p,t->mw_p,t->reject?"FAIL":"ok");
+    else printf("%-18s %14.4f %14.4f %8.4f %10.4g %10s  %s\n",t->metric.c_str(),t->mean_a,t->mean_b,t->ks_d,t->ks_p,"-",t->reject?"FAIL":"ok");
+    if (t->reject) failures++;
+  }
+  printf("\ncurve_band: largest gap in cumulative infections at T=%d hours (means shown are at that timestep), %d permutations\n",
+         worst_T,perms);
+  printf("\n%s: %d of %d metrics differ\n",(failures==0)?"PASS":"FAIL",failures,(int) tests.size());
+  return (failures==0)?0:1;
+}
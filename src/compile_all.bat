@@ -7,6 +7,34 @@ del combine.exe
 cd ..
 
 
+cd CommReplay
+call compile.bat
+if not exist ..\..\bin-w64\CommReplay mkdir ..\..\bin-w64\CommReplay
+copy commreplay.exe ..\..\bin-w64\CommReplay /y
+del commreplay.exe
+cd ..
+
+cd DBBench
+call compile.bat
+if not exist ..\..\bin-w64\DBBench mkdir ..\..\bin-w64\DBBench
+copy dbbench.exe ..\..\bin-w64\DBBench /y
+del dbbench.exe
+cd ..
+
+cd EventLog
+call compile.bat
+if not exist ..\..\bin-w64\EventLog mkdir ..\..\bin-w64\EventLog
+copy events.exe ..\..\bin-w64\EventLog /y
+del events.exe
+cd ..
+
+cd FlatBin
+call compile.bat
+if not exist ..\..\bin-w64\FlatBin mkdir ..\..\bin-w64\FlatBin
+copy flatbin.exe ..\..\bin-w64\FlatBin /y
+del flatbin.exe
+cd ..
+
 cd GetAdminUnits
 call compile.bat
 copy GADM_Shps.class ..\..\bin-w64\GetAdminUnits /y
@@ -25,6 +53,13 @@ copy mashadmin.exe ..\..\bin-w64\MashAdminUnits /y
 del mashadmin.exe
 cd ..
 
+cd MovieConv
+call compile.bat
+if not exist ..\..\bin-w64\MovieConv mkdir ..\..\bin-w64\MovieConv
+copy movieconv.exe ..\..\bin-w64\MovieConv /y
+del movieconv.exe
+cd ..
+
 cd PatchFileMaker
 call compile.bat
 copy *.class ..\..\bin-w64\PatchFileMaker /y
@@ -37,6 +72,13 @@ copy Sim.exe ..\..\bin-w64\Sim /y
 del Sim.exe
 cd ..
 
+cd StatEquiv
+call compile.bat
+if not exist ..\..\bin-w64\StatEquiv mkdir ..\..\bin-w64\StatEquiv
+copy statequiv.exe ..\..\bin-w64\StatEquiv /y
+del statequiv.exe
+cd ..
+
 cd SynthPopul
 call compile.bat
 copy SynthPopul.exe ..\..\bin-w64\SynthPopul /y
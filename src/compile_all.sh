@@ -5,6 +5,38 @@ cp combine ../../bin-linux/CombineSynthPopul
 rm combine
 cd ..
 
+cd CommReplay
+compile.sh
+chmod 755 commreplay
+mkdir -p ../../bin-linux/CommReplay
+cp commreplay ../../bin-linux/CommReplay
+rm commreplay
+cd ..
+
+cd DBBench
+compile.sh
+chmod 755 dbbench
+mkdir -p ../../bin-linux/DBBench
+cp dbbench ../../bin-linux/DBBench
+rm dbbench
+cd ..
+
+cd EventLog
+compile.sh
+chmod 755 events
+mkdir -p ../../bin-linux/EventLog
+cp events ../../bin-linux/EventLog
+rm events
+cd ..
+
+cd FlatBin
+compile.sh
+chmod 755 flatbin
+mkdir -p ../../bin-linux/FlatBin
+cp flatbin ../../bin-linux/FlatBin
+rm flatbin
+cd ..
+
 cd GetAdminUnits
 compile.sh
 cp GADM_Shps.class ../../bin-linux/GetAdminUnits
@@ -25,6 +57,14 @@ cp mashadmin ../../bin-linux/MashAdminUnits
 rm mashadmin
 cd ..
 
+cd MovieConv
+compile.sh
+chmod 755 movieconv
+mkdir -p ../../bin-linux/MovieConv
+cp movieconv ../../bin-linux/MovieConv
+rm movieconv
+cd ..
+
 cd PatchFileMaker
 compile.sh
 cp *.class ../../bin-linux/PatchFileMaker
@@ -38,6 +78,14 @@ cp sim ../../bin-linux/Sim
 rm sim
 cd ..
 
+cd StatEquiv
+compile.sh
+chmod 755 statequiv
+mkdir -p ../../bin-linux/StatEquiv
+cp statequiv ../../bin-linux/StatEquiv
+rm statequiv
+cd ..
+
 cd SynthPopul
 compile.sh
 chmod 755 SynthPopul